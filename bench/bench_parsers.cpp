@@ -0,0 +1,288 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
+#include "anime_serializer.hpp"
+#include "benchmark.hpp"
+#include "corpus.hpp"
+#include "http_capture.hpp"
+#include "local_lists.hpp"
+#include "malgtk_anime.h"
+#include "malgtk_item_list.h"
+#include "malgtk_manga.h"
+#include "manga_serializer.hpp"
+
+using namespace MAL;
+using namespace MAL::Bench;
+
+namespace {
+    struct XmlTextReaderDeleter {
+        void operator()(xmlTextReaderPtr reader) const {
+            xmlFreeTextReader(reader);
+        }
+    };
+
+    /* What MAL::deserialize_from_disk_sync does once the file is read */
+    std::size_t load_local_lists(const std::string& xml)
+    {
+        std::size_t items = 0;
+        deserialize_local_lists(std::string(xml),
+                                [&items](std::shared_ptr<Anime>&&) { ++items; },
+                                [&items](std::shared_ptr<Manga>&&) { ++items; });
+        return items;
+    }
+
+    /* libmalgtk objects for a whole document */
+    struct MalgtkItems {
+        MalgtkItemList *anime = malgtk_item_list_new(MALGTK_TYPE_ANIME);
+        MalgtkItemList *manga = malgtk_item_list_new(MALGTK_TYPE_MANGA);
+
+        MalgtkItems() = default;
+        MalgtkItems(const MalgtkItems&) = delete;
+        MalgtkItems& operator=(const MalgtkItems&) = delete;
+
+        ~MalgtkItems() {
+            g_object_unref(anime);
+            g_object_unref(manga);
+        }
+    };
+
+    /* libmalgtk's bulk reader for the same document, one batch per
+     * list. The objects are kept in items if given */
+    std::size_t load_local_lists_libmalgtk(const std::string& xml, MalgtkItems *items = nullptr)
+    {
+        MalgtkItems scratch;
+        if (!items)
+            items = &scratch;
+
+        std::unique_ptr<xmlTextReader, XmlTextReaderDeleter> reader(
+            xmlReaderForMemory(xml.data(), static_cast<int>(xml.size()), nullptr, nullptr, 0));
+        std::size_t count = 0;
+        while (xmlTextReaderRead(reader.get()) == 1) {
+            if (xmlTextReaderNodeType(reader.get()) != XML_READER_TYPE_ELEMENT)
+                continue;
+
+            const auto name = xmlTextReaderConstName(reader.get());
+            if (xmlStrEqual(name, BAD_CAST "anime_list"))
+                count += malgtk_item_list_load_xml(items->anime, reader.get(), 0);
+            else if (xmlStrEqual(name, BAD_CAST "manga_list"))
+                count += malgtk_item_list_load_xml(items->manga, reader.get(), 0);
+        }
+        return count;
+    }
+
+    /* libmalgtk's writer for the same document, returning its size */
+    std::size_t write_local_lists_libmalgtk(const MalgtkItems& items)
+    {
+        xmlBufferPtr buffer = xmlBufferCreate();
+        xmlTextWriterPtr writer = xmlNewTextWriterMemory(buffer, 0);
+        xmlTextWriterStartDocument(writer, nullptr, "UTF-8", nullptr);
+        xmlTextWriterStartElement(writer, BAD_CAST "mal-gtk");
+        xmlTextWriterStartElement(writer, BAD_CAST "anime_list");
+        for (guint i = 0; i < g_list_model_get_n_items(G_LIST_MODEL(items.anime)); ++i)
+            malgtk_anime_get_xml(MALGTK_ANIME(malgtk_item_list_get(items.anime, i)), writer);
+        xmlTextWriterEndElement(writer);
+        xmlTextWriterStartElement(writer, BAD_CAST "manga_list");
+        for (guint i = 0; i < g_list_model_get_n_items(G_LIST_MODEL(items.manga)); ++i)
+            malgtk_manga_get_xml(MALGTK_MANGA(malgtk_item_list_get(items.manga, i)), writer);
+        xmlTextWriterEndElement(writer);
+        xmlTextWriterEndElement(writer);
+        xmlTextWriterEndDocument(writer);
+        xmlFreeTextWriter(writer);
+
+        const std::size_t size = xmlBufferLength(buffer);
+        xmlBufferFree(buffer);
+        return size;
+    }
+
+    /* The responses in a capture, by what parses them */
+    struct CapturedBodies {
+        std::vector<std::string> anime_list, manga_list, anime_search, manga_search,
+                                 anime_details, manga_details;
+    };
+
+    bool load_capture(const std::string& path, CapturedBodies& bodies)
+    {
+        std::vector<HttpExchange> exchanges;
+        if (!HttpCapture::load(path, exchanges)) {
+            std::cerr << "Error: Unable to read HTTP capture " << path << std::endl;
+            return false;
+        }
+
+        for (auto& exchange : exchanges) {
+            const auto& url = exchange.url;
+            std::vector<std::string> *into = nullptr;
+            if (exchange.result != 0 || exchange.kind == "login")
+                continue;
+            if (url.find("/malappinfo.php") != std::string::npos)
+                into = url.find("type=manga") != std::string::npos ? &bodies.manga_list : &bodies.anime_list;
+            else if (url.find("/api/anime/search.xml") != std::string::npos)
+                into = &bodies.anime_search;
+            else if (url.find("/api/manga/search.xml") != std::string::npos)
+                into = &bodies.manga_search;
+            else if (url.find("/editlist.php") != std::string::npos)
+                into = &bodies.anime_details;
+            else if (url.find("go=editmanga") != std::string::npos)
+                into = &bodies.manga_details;
+            if (into)
+                into->push_back(std::move(exchange.body));
+        }
+        return true;
+    }
+
+    /* Runs parse over every body, as one case */
+    template<typename Parse>
+    void run_captured(Runner& runner, const std::string& name,
+                      const std::vector<std::string>& bodies, Parse parse)
+    {
+        if (bodies.empty() || !runner.selected(name))
+            return;
+
+        std::size_t bytes = 0, entries = 0;
+        for (const auto& body : bodies) {
+            bytes += body.size();
+            entries += parse(body);
+        }
+        runner.run(name, entries, bytes, [&] {
+                for (const auto& body : bodies)
+                    keep(parse(body));
+            });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner(argc, argv);
+    auto text_util = std::make_shared<TextUtility>();
+    AnimeSerializer anime_serializer(text_util);
+    MangaSerializer manga_serializer(text_util);
+
+    /* g_warning on unknown fields would swamp the results */
+    g_log_set_handler(nullptr, G_LOG_LEVEL_WARNING, [](const gchar*, GLogLevelFlags, const gchar*, gpointer) {}, nullptr);
+
+    for (const auto entries : runner.sizes()) {
+        if (runner.selected("anime_list/deserialize")) {
+            const auto xml = anime_list_xml(entries);
+            runner.run("anime_list/deserialize", entries, xml.size(), [&] {
+                    keep(anime_serializer.deserialize(xml).size());
+                });
+        }
+
+        if (runner.selected("manga_list/deserialize")) {
+            const auto xml = manga_list_xml(entries);
+            runner.run("manga_list/deserialize", entries, xml.size(), [&] {
+                    keep(manga_serializer.deserialize(xml).size());
+                });
+        }
+
+        if (runner.selected("anime_search/deserialize")) {
+            const auto xml = anime_search_xml(entries);
+            runner.run("anime_search/deserialize", entries, xml.size(), [&] {
+                    keep(anime_serializer.deserialize(xml).size());
+                });
+        }
+
+        if (runner.selected("manga_search/deserialize")) {
+            const auto xml = manga_search_xml(entries);
+            runner.run("manga_search/deserialize", entries, xml.size(), [&] {
+                    keep(manga_serializer.deserialize(xml).size());
+                });
+        }
+
+        if (runner.selected("html_entities/parse")) {
+            const auto text = synopses_text(entries);
+            runner.run("html_entities/parse", entries, text.size(), [&] {
+                    std::string copy(text);
+                    text_util->parse_html_entities(copy);
+                    keep(copy.size());
+                });
+        }
+
+        if (runner.selected("local_lists/serialize") ||
+            runner.selected("local_lists/deserialize") ||
+            runner.selected("local_lists/malgtk_set_from_xml") ||
+            runner.selected("local_lists/malgtk_get_xml")) {
+            const auto xml = local_lists_xml(entries);
+            const auto anime = anime_serializer.deserialize(anime_list_xml(entries));
+            const auto manga = manga_serializer.deserialize(manga_list_xml(entries));
+            runner.run("local_lists/serialize", entries * 2, xml.size(), [&] {
+                    keep(serialize_local_lists(anime, manga).size());
+                });
+            runner.run("local_lists/deserialize", entries * 2, xml.size(), [&] {
+                    keep(load_local_lists(xml));
+                });
+            runner.run("local_lists/malgtk_set_from_xml", entries * 2, xml.size(), [&] {
+                    keep(load_local_lists_libmalgtk(xml));
+                });
+
+            if (runner.selected("local_lists/malgtk_get_xml")) {
+                MalgtkItems items;
+                load_local_lists_libmalgtk(xml, &items);
+                runner.run("local_lists/malgtk_get_xml", entries * 2, xml.size(), [&] {
+                        keep(write_local_lists_libmalgtk(items));
+                    });
+            }
+        }
+    }
+
+    /* One page per call; the page does not grow with the list */
+    if (runner.selected("anime_details/deserialize")) {
+        const auto html = anime_details_html(0);
+        runner.run("anime_details/deserialize", 1, html.size(), [&] {
+                keep(anime_serializer.deserialize_details(html) != nullptr);
+            });
+    }
+
+    if (runner.selected("manga_details/deserialize")) {
+        const auto html = manga_details_html(0);
+        runner.run("manga_details/deserialize", 1, html.size(), [&] {
+                keep(manga_serializer.deserialize_details(html) != nullptr);
+            });
+    }
+
+    if (!runner.capture().empty()) {
+        CapturedBodies bodies;
+        if (!load_capture(runner.capture(), bodies))
+            return 1;
+
+        run_captured(runner, "capture/anime_list", bodies.anime_list, [&](const std::string& xml) {
+                return anime_serializer.deserialize(xml).size();
+            });
+        run_captured(runner, "capture/manga_list", bodies.manga_list, [&](const std::string& xml) {
+                return manga_serializer.deserialize(xml).size();
+            });
+        run_captured(runner, "capture/anime_search", bodies.anime_search, [&](const std::string& xml) {
+                return anime_serializer.deserialize(xml).size();
+            });
+        run_captured(runner, "capture/manga_search", bodies.manga_search, [&](const std::string& xml) {
+                return manga_serializer.deserialize(xml).size();
+            });
+        run_captured(runner, "capture/anime_details", bodies.anime_details, [&](const std::string& html) {
+                return std::size_t(anime_serializer.deserialize_details(html) != nullptr);
+            });
+        run_captured(runner, "capture/manga_details", bodies.manga_details, [&](const std::string& html) {
+                return std::size_t(manga_serializer.deserialize_details(html) != nullptr);
+            });
+    }
+
+    return 0;
+}
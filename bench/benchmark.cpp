@@ -0,0 +1,117 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace {
+    volatile std::size_t sink;
+
+    std::vector<std::size_t> parse_sizes(const char *str)
+    {
+        std::vector<std::size_t> sizes;
+        std::istringstream in(str);
+        std::string size;
+        while (std::getline(in, size, ','))
+            sizes.push_back(std::strtoul(size.c_str(), nullptr, 10));
+        return sizes;
+    }
+
+    const char *option_value(const char *arg, const char *option)
+    {
+        const auto len = std::strlen(option);
+        if (std::strncmp(arg, option, len) == 0 && arg[len] == '=')
+            return arg + len + 1;
+        return nullptr;
+    }
+}
+
+namespace MAL {
+namespace Bench {
+
+    Runner::Runner(int argc, char **argv) :
+        m_sizes          {100, 1000, 10000, 50000},
+        m_min_seconds    (0.5),
+        m_min_iterations (3)
+    {
+        for (int i = 1; i < argc; ++i) {
+            const char *value;
+            if ((value = option_value(argv[i], "--sizes"))) {
+                m_sizes = parse_sizes(value);
+            } else if ((value = option_value(argv[i], "--filter"))) {
+                m_filter = value;
+            } else if ((value = option_value(argv[i], "--capture"))) {
+                m_capture = value;
+            } else if ((value = option_value(argv[i], "--min-time"))) {
+                m_min_seconds = std::strtod(value, nullptr);
+            } else if ((value = option_value(argv[i], "--min-iterations"))) {
+                m_min_iterations = static_cast<unsigned>(std::max(1ul, std::strtoul(value, nullptr, 10)));
+            } else {
+                std::cerr << "Usage: " << argv[0]
+                          << " [--sizes=100,1000,...] [--filter=substring]"
+                          << " [--min-time=seconds] [--min-iterations=n]"
+                          << " [--capture=FILE]" << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    bool Runner::selected(const std::string& name) const
+    {
+        return m_filter.empty() || name.find(m_filter) != std::string::npos;
+    }
+
+    void Runner::run(const std::string& name, std::size_t entries, std::size_t bytes,
+                     const std::function<void ()>& fn)
+    {
+        if (!selected(name))
+            return;
+
+        typedef std::chrono::steady_clock clock;
+        std::vector<std::int64_t> samples;
+        const auto deadline = clock::now() + std::chrono::duration<double>(m_min_seconds);
+        while (samples.size() < m_min_iterations || clock::now() < deadline) {
+            const auto start = clock::now();
+            fn();
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        const auto mean = std::accumulate(samples.cbegin(), samples.cend(), std::int64_t(0)) / std::int64_t(samples.size());
+
+        std::cout << "{\"benchmark\":\"" << name << "\""
+                  << ",\"entries\":" << entries
+                  << ",\"bytes\":" << bytes
+                  << ",\"iterations\":" << samples.size()
+                  << ",\"min_ns\":" << samples.front()
+                  << ",\"median_ns\":" << samples[samples.size() / 2]
+                  << ",\"mean_ns\":" << mean << "}" << std::endl;
+    }
+
+    void keep(std::size_t value)
+    {
+        sink = value;
+    }
+}
+}
@@ -0,0 +1,72 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MAL {
+namespace Bench {
+
+    /** Times benchmark cases and prints one JSON object per line on
+     * stdout:
+     *
+     * {"benchmark":"anime_list/deserialize","entries":1000,"bytes":712345,
+     *  "iterations":40,"min_ns":...,"median_ns":...,"mean_ns":...}
+     *
+     * Each case runs at least min_iterations times and until
+     * min_seconds have passed. The median is the figure to track;
+     * min shows the best case without scheduler noise.
+     */
+    class Runner {
+    public:
+        Runner(int argc, char **argv);
+
+        /** Sizes given with --sizes=100,1000, or the defaults.
+         */
+        const std::vector<std::size_t>& sizes() const { return m_sizes; }
+
+        /** A MALGTK_RECORD capture given with --capture=FILE, whose
+         * responses are parsed as well as the synthetic corpus.
+         */
+        const std::string& capture() const { return m_capture; }
+
+        /** Whether a case named name was selected with --filter.
+         */
+        bool selected(const std::string& name) const;
+
+        /** Times fn, which processes entries items from bytes of
+         * input.
+         */
+        void run(const std::string& name, std::size_t entries, std::size_t bytes,
+                 const std::function<void ()>& fn);
+
+    private:
+        std::vector<std::size_t> m_sizes;
+        std::string              m_filter;
+        std::string              m_capture;
+        double                   m_min_seconds;
+        unsigned                 m_min_iterations;
+    };
+
+    /** Keeps the optimiser from discarding a result.
+     */
+    void keep(std::size_t value);
+}
+}
@@ -0,0 +1,381 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "corpus.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include "anime_serializer.hpp"
+#include "local_lists.hpp"
+#include "manga_serializer.hpp"
+
+namespace {
+    /* A fixed LCG rather than <random>: the distributions there are
+     * free to differ between standard libraries */
+    class Rng {
+    public:
+        explicit Rng(std::uint64_t seed) : m_state(seed * 6364136223846793005ULL + 1442695040888963407ULL) {}
+
+        unsigned next(unsigned bound) {
+            m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<unsigned>(m_state >> 33) % bound;
+        }
+
+    private:
+        std::uint64_t m_state;
+    };
+
+    const char *const words[] = {
+        "Cowboy", "Bebop", "Sword", "Sky", "Ghost", "Shell", "Spirit", "Moon",
+        "Academy", "Detective", "Summer", "Wars", "Heart", "Steel", "Alchemist",
+        "Garden", "Knight", "Star", "Lonely", "Machine", "Letter", "Wolf", "Rain",
+        "Festival", "Tower", "River", "Silver", "Crown", "Dream", "Voyage",
+    };
+    constexpr unsigned n_words = sizeof words / sizeof words[0];
+
+    /* With the entities MAL leaves in titles and synopses, already
+     * escaped for XML */
+    const char *const entity_words[] = {
+        "&amp;", "&amp;quot;Hello&amp;quot;", "Pok&amp;eacute;mon", "&amp;mdash;",
+        "&amp;#039;s", "Caf&amp;eacute;", "&amp;hellip;", "&amp;#9734;",
+    };
+    constexpr unsigned n_entity_words = sizeof entity_words / sizeof entity_words[0];
+
+    void append_words(std::string& out, Rng& rng, unsigned count, bool entities)
+    {
+        for (unsigned i = 0; i < count; ++i) {
+            if (i)
+                out += ' ';
+            if (entities && rng.next(8) == 0)
+                out += entity_words[rng.next(n_entity_words)];
+            else
+                out += words[rng.next(n_words)];
+        }
+    }
+
+    void append_date(std::string& out, Rng& rng)
+    {
+        char buf[16];
+        std::snprintf(buf, sizeof buf, "%04u-%02u-%02u",
+                      1970 + rng.next(50), 1 + rng.next(12), 1 + rng.next(28));
+        out += buf;
+    }
+
+    void append_element(std::string& out, const char *name, const std::string& value)
+    {
+        out += '<'; out += name; out += '>';
+        out += value;
+        out += "</"; out += name; out += '>';
+    }
+
+    void append_element(std::string& out, const char *name, unsigned value)
+    {
+        append_element(out, name, std::to_string(value));
+    }
+
+    void append_synopsis(std::string& out, Rng& rng)
+    {
+        const unsigned sentences = 3 + rng.next(6);
+        for (unsigned i = 0; i < sentences; ++i) {
+            append_words(out, rng, 8 + rng.next(16), true);
+            out += i % 3 == 2 ? ".&lt;br /&gt;&lt;br /&gt;" : ". ";
+        }
+    }
+
+    std::string list_xml(std::size_t entries, bool anime, const std::string& image_host)
+    {
+        Rng rng(anime ? 1 : 2);
+        std::string out;
+        out.reserve(entries * 700 + 512);
+        out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<myanimelist><myinfo>";
+        append_element(out, "user_id", 1234567u);
+        append_element(out, "user_name", std::string("bench"));
+        append_element(out, anime ? "user_watching" : "user_reading", static_cast<unsigned>(entries / 5));
+        append_element(out, "user_completed", static_cast<unsigned>(entries / 2));
+        append_element(out, "user_onhold", static_cast<unsigned>(entries / 10));
+        append_element(out, "user_dropped", static_cast<unsigned>(entries / 10));
+        append_element(out, anime ? "user_plantowatch" : "user_plantoread", static_cast<unsigned>(entries / 10));
+        append_element(out, "user_days_spent_watching", std::string("123.45"));
+        out += "</myinfo>\n";
+
+        for (std::size_t i = 0; i < entries; ++i) {
+            const unsigned id = static_cast<unsigned>(i + 1);
+            std::string title, synonyms, tags, date;
+            append_words(title, rng, 2 + rng.next(4), false);
+            synonyms += "; ";
+            append_words(synonyms, rng, 2 + rng.next(3), false);
+            append_words(tags, rng, rng.next(4), false);
+
+            out += anime ? "<anime>" : "<manga>";
+            append_element(out, anime ? "series_animedb_id" : "series_mangadb_id", id);
+            append_element(out, "series_title", title);
+            append_element(out, "series_synonyms", synonyms);
+            append_element(out, "series_type", 1 + rng.next(6));
+            if (anime) {
+                append_element(out, "series_episodes", rng.next(100));
+            } else {
+                append_element(out, "series_chapters", rng.next(300));
+                append_element(out, "series_volumes", rng.next(40));
+            }
+            append_element(out, "series_status", 1 + rng.next(3));
+            append_date(date, rng);
+            append_element(out, "series_start", date);
+            date.clear();
+            append_date(date, rng);
+            append_element(out, "series_end", date);
+            append_element(out, "series_image", image_host + "/images/"
+                           + std::string(anime ? "anime/" : "manga/") + std::to_string(id % 13)
+                           + "/" + std::to_string(10000 + id) + ".jpg");
+            append_element(out, "my_id", 0u);
+            if (anime) {
+                append_element(out, "my_watched_episodes", rng.next(100));
+            } else {
+                append_element(out, "my_read_chapters", rng.next(300));
+                append_element(out, "my_read_volumes", rng.next(40));
+            }
+            append_element(out, "my_start_date", std::string("0000-00-00"));
+            date.clear();
+            append_date(date, rng);
+            append_element(out, "my_finish_date", date);
+            append_element(out, "my_score", rng.next(11));
+            append_element(out, "my_status", 1 + rng.next(4));
+            append_element(out, anime ? "my_rewatching" : "my_rereadingg", rng.next(2));
+            append_element(out, anime ? "my_rewatching_ep" : "my_rereading_chap", 0u);
+            append_element(out, "my_last_updated", 1200000000u + rng.next(300000000));
+            append_element(out, "my_tags", tags);
+            out += anime ? "</anime>\n" : "</manga>\n";
+        }
+
+        out += "</myanimelist>\n";
+        return out;
+    }
+
+    std::string search_xml(std::size_t entries, bool anime, const std::string& image_host)
+    {
+        static const char *const anime_types[]    = { "TV", "OVA", "Movie", "Special", "ONA", "Music" };
+        static const char *const anime_statuses[] = { "Currently Airing", "Finished Airing", "Not yet aired" };
+        static const char *const manga_types[]    = { "Manga", "Novel", "One Shot", "Doujin", "Manhwa", "Manhua" };
+        static const char *const manga_statuses[] = { "Publishing", "Finished", "Not yet published" };
+
+        Rng rng(anime ? 3 : 4);
+        std::string out;
+        out.reserve(entries * 1500 + 128);
+        out += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+        out += anime ? "<anime>\n" : "<manga>\n";
+
+        for (std::size_t i = 0; i < entries; ++i) {
+            const unsigned id = static_cast<unsigned>(i + 1);
+            std::string title, english, synonyms, synopsis, date;
+            append_words(title, rng, 2 + rng.next(4), true);
+            append_words(english, rng, 2 + rng.next(4), true);
+            append_words(synonyms, rng, 2 + rng.next(3), false);
+            append_synopsis(synopsis, rng);
+
+            out += "  <entry>";
+            append_element(out, "id", id);
+            append_element(out, "title", title);
+            append_element(out, "english", english);
+            append_element(out, "synonyms", synonyms);
+            if (anime) {
+                append_element(out, "episodes", rng.next(100));
+            } else {
+                append_element(out, "chapters", rng.next(300));
+                append_element(out, "volumes", rng.next(40));
+            }
+            append_element(out, "score", std::to_string(rng.next(10)) + "." + std::to_string(rng.next(100)));
+            append_element(out, "type", anime ? anime_types[rng.next(6)] : manga_types[rng.next(6)]);
+            append_element(out, "status", anime ? anime_statuses[rng.next(3)] : manga_statuses[rng.next(3)]);
+            append_date(date, rng);
+            append_element(out, "start_date", date);
+            date.clear();
+            append_date(date, rng);
+            append_element(out, "end_date", date);
+            append_element(out, "synopsis", synopsis);
+            append_element(out, "image", image_host + "/images/"
+                           + std::string(anime ? "anime/" : "manga/") + std::to_string(id % 13)
+                           + "/" + std::to_string(10000 + id) + ".jpg");
+            out += "</entry>\n";
+        }
+
+        out += anime ? "</anime>\n" : "</manga>\n";
+        return out;
+    }
+
+    /* The parts of the page around the edit form, which the details
+     * parser has to walk through */
+    void append_site_chrome(std::string& out, Rng& rng, const std::string& where)
+    {
+        out += "<div id=\"" + where + "Small\"><a href=\"/panel.php\" class=\"link-mal-logo\">MyAnimeList.net</a></div>\n";
+        out += "<div id=\"" + where + "Menu\"><ul class=\"nav\">";
+        for (unsigned i = 0; i < 40; ++i) {
+            out += "<li class=\"small\"><a href=\"/topanime.php?type=";
+            out += words[i % n_words];
+            out += "\">";
+            append_words(out, rng, 2, false);
+            out += "</a></li>";
+        }
+        out += "</ul></div>\n<script type=\"text/javascript\">window.MAL = {};";
+        for (unsigned i = 0; i < 30; ++i)
+            out += " window.MAL.config_" + std::to_string(i) + " = \"" + words[rng.next(n_words)] + "\";";
+        out += "</script>\n";
+    }
+
+    void append_select(std::string& out, const char *name, unsigned options, unsigned selected)
+    {
+        out += "<select name=\"";
+        out += name;
+        out += "\" class=\"inputtext\">";
+        for (unsigned i = 0; i < options; ++i) {
+            out += "<option value=\"" + std::to_string(i) + "\"";
+            if (i == selected)
+                out += " selected";
+            out += ">Option " + std::to_string(i) + "</option>";
+        }
+        out += "</select>";
+    }
+
+    void append_input(std::string& out, const char *type, const char *name, const std::string& value)
+    {
+        out += "<tr><td class=\"borderClass\"><input type=\"";
+        out += type;
+        out += "\" name=\"";
+        out += name;
+        out += "\" value=\"" + value + "\" class=\"inputtext\" size=\"25\"></td></tr>\n";
+    }
+}
+
+namespace MAL {
+namespace Bench {
+
+    const char *const default_image_host = "https://myanimelist.cdn-dena.com";
+
+    std::string anime_list_xml(std::size_t entries, const std::string& image_host)
+    {
+        return list_xml(entries, true, image_host);
+    }
+
+    std::string manga_list_xml(std::size_t entries, const std::string& image_host)
+    {
+        return list_xml(entries, false, image_host);
+    }
+
+    std::string anime_search_xml(std::size_t entries, const std::string& image_host)
+    {
+        return search_xml(entries, true, image_host);
+    }
+
+    std::string manga_search_xml(std::size_t entries, const std::string& image_host)
+    {
+        return search_xml(entries, false, image_host);
+    }
+
+    std::string anime_details_html(std::size_t index)
+    {
+        Rng rng(index * 2 + 5);
+        std::string out, comments, tags;
+        out.reserve(48 * 1024);
+        out += "<!DOCTYPE html>\n<html><head><title>Edit Anime - MyAnimeList.net</title></head><body>\n";
+        append_site_chrome(out, rng, "header");
+        out += "<form name=\"editAnime\" method=\"post\" action=\"/editlist.php?type=anime&amp;id=";
+        out += std::to_string(index + 1) + "\"><table>\n";
+        append_input(out, "text", "list_downloaded_eps", std::to_string(rng.next(50)));
+        append_input(out, "text", "list_times_watched", std::to_string(rng.next(5)));
+        append_input(out, "text", "fansub_group", words[rng.next(n_words)]);
+        append_input(out, "text", "storageVal", std::to_string(rng.next(10)) + ".0");
+        append_input(out, "checkbox", "list_rewatching", "1");
+        out += "<tr><td>";
+        append_select(out, "priority", 3, rng.next(3));
+        append_select(out, "storage", 8, rng.next(8));
+        append_select(out, "list_rewatch_value", 6, rng.next(6));
+        append_select(out, "discuss", 2, rng.next(2));
+        append_words(tags, rng, 4, false);
+        append_synopsis(comments, rng);
+        out += "</td></tr>\n<tr><td><textarea name=\"tags\" rows=\"2\" cols=\"45\">" + tags + "</textarea></td></tr>\n";
+        out += "<tr><td><textarea name=\"list_comments\" rows=\"5\" cols=\"45\">" + comments + "</textarea></td></tr>\n";
+        out += "</table><input type=\"submit\" name=\"submitIt\" value=\"Submit\"></form>\n";
+        append_site_chrome(out, rng, "footer");
+        out += "</body></html>\n";
+        return out;
+    }
+
+    std::string manga_details_html(std::size_t index)
+    {
+        Rng rng(index * 2 + 6);
+        std::string out, comments, tags;
+        out.reserve(48 * 1024);
+        out += "<!DOCTYPE html>\n<html><head><title>Edit Manga - MyAnimeList.net</title></head><body>\n";
+        append_site_chrome(out, rng, "header");
+        out += "<form name=\"mangaForm\" method=\"post\" action=\"/panel.php?go=editmanga&amp;id=";
+        out += std::to_string(index + 1) + "\"><table>\n";
+        append_input(out, "text", "downloaded_chapters", std::to_string(rng.next(200)));
+        append_input(out, "text", "times_read", std::to_string(rng.next(5)));
+        append_input(out, "text", "retail_volumes", std::to_string(rng.next(30)));
+        append_input(out, "checkbox", "rereading", "1");
+        out += "<tr><td>";
+        append_select(out, "priority", 3, rng.next(3));
+        append_select(out, "storage_num", 6, rng.next(6));
+        append_select(out, "reread_value", 6, rng.next(6));
+        append_select(out, "discuss", 2, rng.next(2));
+        append_words(tags, rng, 4, false);
+        append_synopsis(comments, rng);
+        out += "</td></tr>\n<tr><td><textarea name=\"tags\" rows=\"2\" cols=\"45\">" + tags + "</textarea></td></tr>\n";
+        out += "<tr><td><textarea name=\"comments\" rows=\"5\" cols=\"45\">" + comments + "</textarea></td></tr>\n";
+        out += "</table><input type=\"submit\" name=\"submitIt\" value=\"Submit\"></form>\n";
+        append_site_chrome(out, rng, "footer");
+        out += "</body></html>\n";
+        return out;
+    }
+
+    std::string synopses_text(std::size_t entries)
+    {
+        Rng rng(7);
+        std::string xml_escaped;
+        for (std::size_t i = 0; i < entries; ++i)
+            append_synopsis(xml_escaped, rng);
+
+        /* Undo the XML escaping, leaving the HTML entities the way
+         * the serializers see them */
+        std::string out;
+        out.reserve(xml_escaped.size());
+        for (std::size_t i = 0; i < xml_escaped.size(); ) {
+            if (xml_escaped.compare(i, 5, "&amp;") == 0) {
+                out += '&';
+                i += 5;
+            } else if (xml_escaped.compare(i, 4, "&lt;") == 0) {
+                out += '<';
+                i += 4;
+            } else if (xml_escaped.compare(i, 4, "&gt;") == 0) {
+                out += '>';
+                i += 4;
+            } else {
+                out += xml_escaped[i++];
+            }
+        }
+        return out;
+    }
+
+    std::string local_lists_xml(std::size_t entries)
+    {
+        /* Round trip through the real parsers so the document is
+         * exactly what the application writes */
+        auto text_util = std::make_shared<TextUtility>();
+        const auto anime = AnimeSerializer(text_util).deserialize(anime_list_xml(entries));
+        const auto manga = MangaSerializer(text_util).deserialize(manga_list_xml(entries));
+        return serialize_local_lists(anime, manga);
+    }
+}
+}
@@ -0,0 +1,76 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace MAL {
+namespace Bench {
+
+    /* Synthetic documents shaped like the ones myanimelist.net serves,
+     * for the benchmarks. Every generator is deterministic: the same
+     * arguments always produce the same bytes, so results from
+     * different builds compare.
+     *
+     * Cover image URLs are image_host followed by
+     * /images/anime/N/ID.jpg or /images/manga/N/ID.jpg.
+     */
+
+    extern const char *const default_image_host;
+
+    /** malappinfo.php?type=anime for a user with entries anime.
+     */
+    std::string anime_list_xml(std::size_t entries,
+                               const std::string& image_host = default_image_host);
+
+    /** malappinfo.php?type=manga for a user with entries manga.
+     */
+    std::string manga_list_xml(std::size_t entries,
+                               const std::string& image_host = default_image_host);
+
+    /** api/anime/search.xml with entries results. Titles and
+     * synopses carry HTML entities, escaped once more for XML.
+     */
+    std::string anime_search_xml(std::size_t entries,
+                                 const std::string& image_host = default_image_host);
+
+    /** api/manga/search.xml with entries results.
+     */
+    std::string manga_search_xml(std::size_t entries,
+                                 const std::string& image_host = default_image_host);
+
+    /** The editlist.php page for anime number index, including the
+     * site chrome around the form.
+     */
+    std::string anime_details_html(std::size_t index);
+
+    /** The panel-manga.php edit page for manga number index.
+     */
+    std::string manga_details_html(std::size_t index);
+
+    /** Synopsis text of entries series, with the HTML entities that
+     * TextUtility::parse_html_entities decodes.
+     */
+    std::string synopses_text(std::size_t entries);
+
+    /** AnimeMangaList.xml with entries anime and entries manga, as
+     * MAL::serialize_to_disk_sync writes it.
+     */
+    std::string local_lists_xml(std::size_t entries);
+}
+}
@@ -0,0 +1,70 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes the benchmark corpus to a directory, to feed other tools or
+ * a stand-in server the same documents the benchmarks parse.
+ *
+ * mal-gtk-corpus DIR [ENTRIES...]
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "corpus.hpp"
+
+using namespace MAL::Bench;
+
+namespace {
+    bool write_file(const std::string& path, const std::string& contents)
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << contents;
+        if (!out) {
+            std::cerr << "Error: Unable to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " DIR [ENTRIES...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir = argv[1];
+    bool ok = write_file(dir + "/editlist-anime.html", anime_details_html(0));
+    ok &= write_file(dir + "/editlist-manga.html", manga_details_html(0));
+
+    const char *const default_sizes[] = { "100", "1000", "10000", "50000" };
+    const char *const *sizes = argc > 2 ? argv + 2 : default_sizes;
+    const int n_sizes = argc > 2 ? argc - 2 : 4;
+    for (int i = 0; i < n_sizes; ++i) {
+        const auto entries = std::strtoul(sizes[i], nullptr, 10);
+        const std::string suffix = std::string("-") + sizes[i] + ".xml";
+        ok &= write_file(dir + "/malappinfo-anime" + suffix, anime_list_xml(entries));
+        ok &= write_file(dir + "/malappinfo-manga" + suffix, manga_list_xml(entries));
+        ok &= write_file(dir + "/search-anime" + suffix, anime_search_xml(entries));
+        ok &= write_file(dir + "/search-manga" + suffix, manga_search_xml(entries));
+        ok &= write_file(dir + "/AnimeMangaList" + suffix, local_lists_xml(entries));
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,449 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A stand-in for myanimelist.net, for measuring the network paths
+ * without the network.
+ *
+ * mal-gtk-standin [--port=8080] [--entries=1000] [--search-results=20]
+ *                 [--latency-ms=0] [--jitter-ms=0] [--bandwidth=0]
+ *                 [--error-rate=0] [--seed=1] [--dir=DIR] [--verbose]
+ *
+ * Then run MALGTK_BASE_URL=http://127.0.0.1:8080 ./src/mal-gtk
+ *
+ * Lists, search results and edit pages come from the benchmark corpus
+ * generator, cover images are small generated PNMs. Any file in DIR
+ * named as mal-gtk-corpus names them (malappinfo-anime.xml,
+ * search-manga.xml, editlist-anime.html, images/ID.jpg, ...) is
+ * served instead, so recorded responses can be replayed.
+ *
+ * Every response waits latency-ms plus up to jitter-ms before the
+ * headers go out, and the body is sent at bandwidth bytes per second
+ * (0 is unlimited). A fraction error-rate of requests, chosen by
+ * seed, get a 503 instead.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "corpus.hpp"
+
+using namespace MAL::Bench;
+
+namespace {
+    struct Options {
+        unsigned short port           = 8080;
+        std::size_t    entries        = 1000;
+        std::size_t    search_results = 20;
+        unsigned       latency_ms     = 0;
+        unsigned       jitter_ms      = 0;
+        std::size_t    bandwidth      = 0;
+        double         error_rate     = 0;
+        std::uint64_t  seed           = 1;
+        std::string    dir;
+        bool           verbose        = false;
+    };
+
+    struct Request {
+        std::string method;
+        std::string path;
+        std::string query;
+        bool        keep_alive = true;
+    };
+
+    struct Response {
+        int         status       = 200;
+        const char *content_type = "text/html; charset=utf-8";
+        std::string body;
+    };
+
+    /* The documents that do not change between requests */
+    struct Documents {
+        std::string anime_list;
+        std::string manga_list;
+        std::string anime_search;
+        std::string manga_search;
+    };
+
+    Options         options;
+    Documents       documents;
+    std::mutex      log_mutex;
+    std::atomic<std::uint64_t> request_count(0);
+
+    std::uint64_t splitmix64(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /* Uniform in [0, 1) for the nth request */
+    double chance(std::uint64_t n, std::uint64_t stream)
+    {
+        return (splitmix64(options.seed * 4 + stream + (n << 2)) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    bool read_file(const std::string& name, std::string& contents)
+    {
+        if (options.dir.empty())
+            return false;
+
+        std::ifstream in(options.dir + "/" + name, std::ios::binary);
+        if (!in)
+            return false;
+
+        std::ostringstream buf;
+        buf << in.rdbuf();
+        contents = buf.str();
+        return true;
+    }
+
+    std::string query_value(const std::string& query, const std::string& key)
+    {
+        std::size_t pos = 0;
+        while (pos < query.size()) {
+            auto end = query.find('&', pos);
+            if (end == std::string::npos)
+                end = query.size();
+            if (query.compare(pos, key.size(), key) == 0 && pos + key.size() < end
+                && query[pos + key.size()] == '=')
+                return query.substr(pos + key.size() + 1, end - pos - key.size() - 1);
+            pos = end + 1;
+        }
+        return std::string();
+    }
+
+    std::size_t id_value(const std::string& query)
+    {
+        const auto id = std::strtoul(query_value(query, "id").c_str(), nullptr, 10);
+        return id > 0 ? id - 1 : 0;
+    }
+
+    bool starts_with(const std::string& str, const char *prefix)
+    {
+        return str.compare(0, std::strlen(prefix), prefix) == 0;
+    }
+
+    /* A cover-sized binary PPM, which gdk-pixbuf loads without a
+     * codec */
+    std::string cover_image(const std::string& path)
+    {
+        const unsigned width = 75, height = 117;
+        const auto hash = splitmix64(std::hash<std::string>()(path));
+        std::string out = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        out.reserve(out.size() + width * height * 3);
+        for (unsigned y = 0; y < height; ++y) {
+            for (unsigned x = 0; x < width; ++x) {
+                out += static_cast<char>((hash >> 0) + x * 3);
+                out += static_cast<char>((hash >> 8) + y * 2);
+                out += static_cast<char>((hash >> 16) + (x ^ y));
+            }
+        }
+        return out;
+    }
+
+    Response route(const Request& request)
+    {
+        Response response;
+        const auto& path = request.path;
+        const auto& query = request.query;
+
+        if (path == "/malappinfo.php") {
+            const bool anime = query_value(query, "type") != "manga";
+            response.content_type = "text/xml; charset=utf-8";
+            if (!read_file(anime ? "malappinfo-anime.xml" : "malappinfo-manga.xml", response.body))
+                response.body = anime ? documents.anime_list : documents.manga_list;
+        } else if (path == "/api/anime/search.xml" || path == "/api/manga/search.xml") {
+            const bool anime = path == "/api/anime/search.xml";
+            response.content_type = "text/xml; charset=utf-8";
+            if (!read_file(anime ? "search-anime.xml" : "search-manga.xml", response.body))
+                response.body = anime ? documents.anime_search : documents.manga_search;
+        } else if (path == "/editlist.php") {
+            if (!read_file("editlist-anime.html", response.body))
+                response.body = anime_details_html(id_value(query));
+        } else if (path == "/panel.php" && query_value(query, "go") == "editmanga") {
+            if (!read_file("editlist-manga.html", response.body))
+                response.body = manga_details_html(id_value(query));
+        } else if (starts_with(path, "/api/animelist/update/") || starts_with(path, "/api/mangalist/update/")) {
+            response.content_type = "text/plain";
+            response.body = "Updated";
+        } else if (starts_with(path, "/api/animelist/add/") || starts_with(path, "/api/mangalist/add/")) {
+            response.status = 201;
+            response.content_type = "text/plain";
+            response.body = "Created";
+        } else if (path == "/login.php") {
+            response.body = "<html><body>Logged in</body></html>";
+        } else if (starts_with(path, "/images/")) {
+            response.content_type = "image/x-portable-pixmap";
+            if (!read_file("images/" + path.substr(path.rfind('/') + 1), response.body))
+                response.body = cover_image(path);
+            else
+                response.content_type = "image/jpeg";
+        } else {
+            response.status = 404;
+            response.body = "<html><body>404 Not Found</body></html>";
+        }
+
+        return response;
+    }
+
+    const char *reason(int status)
+    {
+        switch (status) {
+            case 200: return "OK";
+            case 201: return "Created";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 503: return "Service Unavailable";
+            default:  return "Unknown";
+        }
+    }
+
+    bool send_all(int fd, const char *data, std::size_t size)
+    {
+        while (size > 0) {
+            const auto sent = send(fd, data, size, MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    bool send_response(int fd, const Request& request, const Response& response)
+    {
+        std::ostringstream headers;
+        headers << "HTTP/1.1 " << response.status << " " << reason(response.status) << "\r\n"
+                << "Content-Type: " << response.content_type << "\r\n"
+                << "Content-Length: " << response.body.size() << "\r\n"
+                << "Connection: " << (request.keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+        const auto head = headers.str();
+        if (!send_all(fd, head.data(), head.size()))
+            return false;
+
+        if (options.bandwidth == 0)
+            return send_all(fd, response.body.data(), response.body.size());
+
+        /* 50 chunks a second, paced against the start so rounding
+         * does not accumulate */
+        const std::size_t chunk = std::max<std::size_t>(options.bandwidth / 50, 1);
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t offset = 0; offset < response.body.size(); offset += chunk) {
+            const auto size = std::min(chunk, response.body.size() - offset);
+            if (!send_all(fd, response.body.data() + offset, size))
+                return false;
+            std::this_thread::sleep_until(start + std::chrono::duration<double>(
+                                              double(offset + size) / options.bandwidth));
+        }
+        return true;
+    }
+
+    /* Reads one request's head and body from fd. buffer keeps what
+     * was read past it. */
+    bool read_request(int fd, std::string& buffer, Request& request)
+    {
+        std::size_t head_end;
+        char chunk[16384];
+        while ((head_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            const auto got = recv(fd, chunk, sizeof chunk, 0);
+            if (got <= 0)
+                return false;
+            buffer.append(chunk, static_cast<std::size_t>(got));
+        }
+
+        std::istringstream head(buffer.substr(0, head_end));
+        std::string target, version, line;
+        head >> request.method >> target >> version;
+        std::getline(head, line);
+
+        const auto question = target.find('?');
+        request.path = target.substr(0, question);
+        request.query = question == std::string::npos ? std::string() : target.substr(question + 1);
+        request.keep_alive = version == "HTTP/1.1";
+
+        std::size_t content_length = 0;
+        while (std::getline(head, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            const auto colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+            std::string name = line.substr(0, colon);
+            for (auto& c : name)
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            const auto value_start = line.find_first_not_of(' ', colon + 1);
+            const auto value = value_start == std::string::npos ? std::string() : line.substr(value_start);
+            if (name == "content-length")
+                content_length = std::strtoul(value.c_str(), nullptr, 10);
+            else if (name == "connection")
+                request.keep_alive = value != "close" && (request.keep_alive || value == "keep-alive");
+        }
+
+        /* The body is read and dropped; nothing is stored */
+        const auto total = head_end + 4 + content_length;
+        while (buffer.size() < total) {
+            const auto got = recv(fd, chunk, sizeof chunk, 0);
+            if (got <= 0)
+                return false;
+            buffer.append(chunk, static_cast<std::size_t>(got));
+        }
+        buffer.erase(0, total);
+        return true;
+    }
+
+    void serve_connection(int fd)
+    {
+        std::string buffer;
+        Request request;
+        while (read_request(fd, buffer, request)) {
+            const auto n = request_count++;
+            const auto start = std::chrono::steady_clock::now();
+
+            Response response;
+            if (chance(n, 0) < options.error_rate) {
+                response.status = 503;
+                response.body = "<html><body>Service Unavailable</body></html>";
+            } else {
+                response = route(request);
+            }
+
+            const auto delay = options.latency_ms + static_cast<unsigned>(chance(n, 1) * options.jitter_ms);
+            if (delay > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+
+            const bool sent = send_response(fd, request, response);
+
+            if (options.verbose) {
+                const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::lock_guard<std::mutex> lock(log_mutex);
+                std::cerr << request.method << " " << request.path
+                          << (request.query.empty() ? "" : "?") << request.query
+                          << " " << response.status << " " << response.body.size()
+                          << " bytes " << ms << " ms" << std::endl;
+            }
+
+            if (!sent || !request.keep_alive)
+                break;
+            request = Request();
+        }
+        close(fd);
+    }
+
+    const char *option_value(const char *arg, const char *option)
+    {
+        const auto len = std::strlen(option);
+        if (std::strncmp(arg, option, len) == 0 && arg[len] == '=')
+            return arg + len + 1;
+        return nullptr;
+    }
+
+    bool parse_options(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; ++i) {
+            const char *value;
+            if ((value = option_value(argv[i], "--port")))
+                options.port = static_cast<unsigned short>(std::strtoul(value, nullptr, 10));
+            else if ((value = option_value(argv[i], "--entries")))
+                options.entries = std::strtoul(value, nullptr, 10);
+            else if ((value = option_value(argv[i], "--search-results")))
+                options.search_results = std::strtoul(value, nullptr, 10);
+            else if ((value = option_value(argv[i], "--latency-ms")))
+                options.latency_ms = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            else if ((value = option_value(argv[i], "--jitter-ms")))
+                options.jitter_ms = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            else if ((value = option_value(argv[i], "--bandwidth")))
+                options.bandwidth = std::strtoul(value, nullptr, 10);
+            else if ((value = option_value(argv[i], "--error-rate")))
+                options.error_rate = std::strtod(value, nullptr);
+            else if ((value = option_value(argv[i], "--seed")))
+                options.seed = std::strtoull(value, nullptr, 10);
+            else if ((value = option_value(argv[i], "--dir")))
+                options.dir = value;
+            else if (std::strcmp(argv[i], "--verbose") == 0)
+                options.verbose = true;
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_options(argc, argv)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--port=8080] [--entries=1000] [--search-results=20]"
+                  << " [--latency-ms=0] [--jitter-ms=0] [--bandwidth=bytes/s]"
+                  << " [--error-rate=0..1] [--seed=1] [--dir=DIR] [--verbose]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0
+        || listen(listen_fd, 64) < 0) {
+        std::cerr << "Error: Unable to listen on 127.0.0.1:" << options.port
+                  << ": " << std::strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string base_url = "http://127.0.0.1:" + std::to_string(options.port);
+    documents.anime_list   = anime_list_xml(options.entries, base_url);
+    documents.manga_list   = manga_list_xml(options.entries, base_url);
+    documents.anime_search = anime_search_xml(options.search_results, base_url);
+    documents.manga_search = manga_search_xml(options.search_results, base_url);
+
+    std::cerr << "Serving on " << base_url
+              << "; run MALGTK_BASE_URL=" << base_url << " mal-gtk" << std::endl;
+
+    for (;;) {
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Error: accept failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        std::thread(serve_connection, fd).detach();
+    }
+
+    close(listen_fd);
+    return EXIT_FAILURE;
+}
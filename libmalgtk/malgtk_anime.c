@@ -17,8 +17,8 @@
 
 #include "malgtk_anime.h"
 #include "malgtk_enumtypes.h"
-#include "malgtk_deserialize_v1_tools.h"
 #include "malgtk_xml.h"
+#include "malgtk_variant.h"
 
 typedef struct _MalgtkAnime MalgtkAnime;
 
@@ -194,16 +194,30 @@ malgtk_anime_finalize (GObject *obj)
     G_OBJECT_CLASS (malgtk_anime_parent_class)->finalize (obj);
 }
 
+static const GVariantType *malgtk_anime_get_variant_type (void);
+static guint32             malgtk_anime_get_variant_schema (void);
+static GVariant           *malgtk_anime_get_variant      (const MalgtkMalitem *item);
+static void                malgtk_anime_set_from_variant (MalgtkMalitem *item, GVariant *variant);
+static void                malgtk_anime_load_xml         (MalgtkMalitem *item, xmlTextReaderPtr reader);
+
 static void
 malgtk_anime_class_init (MalgtkAnimeClass *klass)
 {
     GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    MalgtkMalitemClass *malitem_class = MALGTK_MALITEM_CLASS (klass);
 
     gobject_class->set_property = malgtk_anime_set_property;
     gobject_class->get_property = malgtk_anime_get_property;
     gobject_class->dispose      = malgtk_anime_dispose;
     gobject_class->finalize     = malgtk_anime_finalize;
 
+    malitem_class->get_variant_type   = malgtk_anime_get_variant_type;
+    malitem_class->get_variant_schema = malgtk_anime_get_variant_schema;
+    malitem_class->get_variant        = malgtk_anime_get_variant;
+    malitem_class->set_from_variant   = malgtk_anime_set_from_variant;
+    malitem_class->xml_name           = "anime";
+    malitem_class->load_xml           = malgtk_anime_load_xml;
+
     obj_properties[PROP_SERIES_TYPE] =
         g_param_spec_enum ("series-type",
                            "Series Type",
@@ -290,121 +304,99 @@ malgtk_anime_new(void)
     return g_object_new(MALGTK_TYPE_ANIME, NULL);
 }
 
-static gboolean
-xform_series_type_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_ANIME_SERIES_TYPE, in);
-}
-
-static gboolean
-xform_series_status_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_ANIME_SERIES_STATUS, in);
-}
-
-static gboolean
-xform_status_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_ANIME_STATUS, in);
-}
-
-static gboolean
-xform_storage_type_enum(GValue *value, const xmlChar *in)
+static GOnce s_defs_once = G_ONCE_INIT;
+static struct malgtk_xml_serialization_defs s_defs[N_PROPERTIES] = { 0 };
+static GHashTable *s_defs_index;
+static MalgtkXmlPlan *s_plan;
+static MalgtkVariantPlan *s_variant_plan;
+static GVariantType *s_variant_type;
+static void* _init_s_defs(void* v);
+
+/* Returns the MALGTK_XML_PROP_BITs of what changed. The MALitem part
+ * notifies its own changes unless load is set, when nothing does. */
+static guint64
+_read_xml(MalgtkAnime *anime, xmlTextReaderPtr reader, gboolean load)
 {
-    return xform_enum(value, MALGTK_TYPE_ANIME_STORAGE_TYPE, in);
-}
+    MalgtkAnimePrivate *priv;
+    const struct malgtk_xml_serialization_defs *def = NULL;
+    const xmlChar *element;
+    guint64 changed = 0;
 
-static const struct {
-    const xmlChar *xml_name;
-    gint prop_id;
-    gboolean (*xform)(GValue *out, const xmlChar* in);
-} field_map[] = {
-    {BAD_CAST"MALitem",         -1,                   NULL},
-    {BAD_CAST"anime",           -1,                   NULL},
-    {BAD_CAST"series_type",     PROP_SERIES_TYPE,     xform_series_type_enum},
-    {BAD_CAST"series_status",   PROP_SERIES_STATUS,   xform_series_status_enum},
-    {BAD_CAST"series_episodes", PROP_SERIES_EPISODES, xform_gint64},
-    {BAD_CAST"status",          PROP_STATUS,          xform_status_enum},
-    {BAD_CAST"episodes",        PROP_EPISODES,        xform_gint64},
-    {BAD_CAST"rewatch_episode", PROP_REWATCH_EPISODE, xform_gint64},
-    {BAD_CAST"storage_type",    PROP_STORAGE_TYPE,    xform_storage_type_enum},
-    {BAD_CAST"storage_value",   PROP_STORAGE_VALUE,   xform_gdouble},
-};
-
-static gint
-find_field_for_name(const xmlChar *name)
-{
-    for (size_t i = 0; i < G_N_ELEMENTS(field_map); ++i)
-    {
-        if (xmlStrEqual(field_map[i].xml_name, name)) {
-            return i;
-        }
-    }
-
-    return -1;
-}
-
-void
-malgtk_anime_set_from_xml(MalgtkAnime *anime,
-                          xmlTextReaderPtr reader)
-{
-    gint offset = -1;
-    GValue value = G_VALUE_INIT;
-    gboolean is_default;
-    g_return_if_fail(MALGTK_IS_ANIME(anime));
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    priv = malgtk_anime_get_instance_private (anime);
 
-    for (; !(xmlStrEqual(BAD_CAST"anime", xmlTextReaderConstName(reader)) &&
-             xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT);
-         xmlTextReaderRead(reader))
+    while (!(xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT &&
+             xmlStrEqual(BAD_CAST"anime", xmlTextReaderConstName(reader))))
     {
         switch (xmlTextReaderNodeType(reader))
         {
             case XML_READER_TYPE_ELEMENT:
-                offset = find_field_for_name(xmlTextReaderConstName(reader));
-                if (-1 == offset) {
-                    g_warning("Unexpected field: %s", (const char*)xmlTextReaderConstName(reader));
-                }
-                if (0 == offset) {
-                    malgtk_malitem_set_from_xml (MALGTK_MALITEM(anime), reader);
-                    break;
+                element = xmlTextReaderConstName(reader);
+                def = NULL;
+                if (xmlStrEqual(BAD_CAST"MALitem", element)) {
+                    if (load)
+                        MALGTK_MALITEM_CLASS (malgtk_anime_parent_class)->load_xml (MALGTK_MALITEM(anime), reader);
+                    else
+                        malgtk_malitem_set_from_xml (MALGTK_MALITEM(anime), reader);
+                } else if (!g_hash_table_lookup_extended(s_defs_index, element, NULL, (gpointer*)&def)) {
+                    g_warning("Unexpected field: %s", (const char*)element);
+                    def = NULL;
                 }
                 break;
             case XML_READER_TYPE_TEXT:
-                switch (field_map[offset].prop_id) {
-                    case -1:
-                        break;
-                    default:
-                        is_default = field_map[offset].xform(&value,
-                                                             xmlTextReaderConstValue(reader));
-                        if (!is_default) {
-                            g_object_set_property(G_OBJECT(anime),
-                                                  obj_properties[field_map[offset].prop_id]->name, &value);
-                            g_value_unset(&value);
-                        }
-                        break;
-                }
+                if (def && malgtk_xml_deserialize(def, priv, xmlTextReaderConstValue(reader)))
+                    changed |= MALGTK_XML_PROP_BIT(def->prop_id);
+                break;
+            case XML_READER_TYPE_END_ELEMENT:
+                def = NULL;
                 break;
             default:
                 break;
         }
+
+        if (1 != xmlTextReaderRead(reader))
+            break;
     }
+
+    return changed;
+}
+
+void
+malgtk_anime_set_from_xml(MalgtkAnime *anime, xmlTextReaderPtr reader)
+{
+    guint64 changed;
+    g_return_if_fail(MALGTK_IS_ANIME(anime));
+
+    /* The MALitem part notifies when this does */
+    g_object_freeze_notify (G_OBJECT (anime));
+
+    changed = _read_xml (anime, reader, FALSE);
+
+    malgtk_xml_notify_changed (G_OBJECT (anime), obj_properties, changed);
+    g_object_thaw_notify (G_OBJECT (anime));
+}
+
+static void
+malgtk_anime_load_xml(MalgtkMalitem *item, xmlTextReaderPtr reader)
+{
+    _read_xml (MALGTK_ANIME (item), reader, TRUE);
 }
 
-static GOnce s_defs_once = G_ONCE_INIT;
-static struct malgtk_xml_serialization_defs s_defs[N_PROPERTIES] = { 0 };
 static void*
 _init_s_defs(void* v)
 {
     (void)v;
     s_defs[0] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_ANIME_SERIES_TYPE, PROP_SERIES_TYPE, "series-type", "series_type",
-        NULL, offsetof(MalgtkAnimePrivate, series_type), sizeof(MalgtkAnimeSeriesType) };
+        NULL, offsetof(MalgtkAnimePrivate, series_type), sizeof(MalgtkAnimeSeriesType),
+        malgtk_anime_series_type_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkAnimeSeriesType);
 
     s_defs[1] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_ANIME_SERIES_STATUS, PROP_SERIES_STATUS, "series-status", "series_status",
-        NULL, offsetof(MalgtkAnimePrivate, series_status), sizeof(MalgtkAnimeSeriesStatus) };
+        NULL, offsetof(MalgtkAnimePrivate, series_status), sizeof(MalgtkAnimeSeriesStatus),
+        malgtk_anime_series_status_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkAnimeSeriesStatus);
 
@@ -414,7 +406,8 @@ _init_s_defs(void* v)
 
     s_defs[3] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_ANIME_STATUS, PROP_STATUS, "status", "status",
-        NULL, offsetof(MalgtkAnimePrivate, series_status), sizeof(MalgtkAnimeStatus) };
+        NULL, offsetof(MalgtkAnimePrivate, status), sizeof(MalgtkAnimeStatus),
+        malgtk_anime_status_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkAnimeStatus);
 
@@ -428,7 +421,8 @@ _init_s_defs(void* v)
 
     s_defs[6] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_ANIME_STORAGE_TYPE, PROP_STORAGE_TYPE, "storage-type", "storage_type",
-        NULL, offsetof(MalgtkAnimePrivate, storage_type), sizeof(MalgtkAnimeStorageType) };
+        NULL, offsetof(MalgtkAnimePrivate, storage_type), sizeof(MalgtkAnimeStorageType),
+        malgtk_anime_storage_type_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkAnimeStorageType);
 
@@ -436,6 +430,16 @@ _init_s_defs(void* v)
         G_TYPE_DOUBLE, PROP_STORAGE_VALUE, "storage-value", "storage_value",
         NULL, offsetof(MalgtkAnimePrivate, storage_value), 0 };
 
+    s_defs_index = malgtk_xml_defs_index_new(s_defs, "anime");
+    s_plan       = malgtk_xml_plan_new(s_defs);
+
+    /* The MALitem fields, then ours */
+    s_variant_plan = malgtk_variant_plan_new(s_defs);
+    s_variant_type = g_variant_type_new_tuple(
+        (const GVariantType * const []){
+            g_variant_type_first(MALGTK_MALITEM_CLASS (malgtk_anime_parent_class)->get_variant_type ()),
+            malgtk_variant_plan_get_type(s_variant_plan) }, 2);
+
     return NULL;
 }
 
@@ -451,8 +455,66 @@ malgtk_anime_get_xml(const MalgtkAnime *anime,
     xmlTextWriterWriteAttribute(writer, BAD_CAST"version", BAD_CAST"1");
     malgtk_malitem_get_xml(MALGTK_MALITEM((MalgtkAnime*)anime), writer);
 
-    malgtk_xml_serialize(writer, s_defs, priv);
+    malgtk_xml_serialize(writer, s_plan, priv);
 
     xmlTextWriterEndElement(writer); /* anime */
 
 }
+
+static const GVariantType *
+malgtk_anime_get_variant_type(void)
+{
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    return s_variant_type;
+}
+
+static guint32
+malgtk_anime_get_variant_schema(void)
+{
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    return MALGTK_MALITEM_CLASS (malgtk_anime_parent_class)->get_variant_schema () * 31 +
+        malgtk_variant_plan_get_schema(s_variant_plan);
+}
+
+static GVariant *
+malgtk_anime_get_variant(const MalgtkMalitem *item)
+{
+    g_autoptr(GVariant) malitem = NULL;
+    GVariant *children[2];
+    GVariant *variant;
+
+    g_once (&s_defs_once, _init_s_defs, NULL);
+
+    malitem     = g_variant_ref_sink (MALGTK_MALITEM_CLASS (malgtk_anime_parent_class)->get_variant (item));
+    children[0] = g_variant_get_child_value (malitem, 0);
+    children[1] = malgtk_variant_serialize (s_variant_plan,
+                                            malgtk_anime_get_instance_private_const (MALGTK_ANIME ((MalgtkMalitem*)item)));
+    variant     = g_variant_new_tuple (children, 2);
+
+    /* Only the new child was floating */
+    g_variant_unref (children[0]);
+    return variant;
+}
+
+static void
+malgtk_anime_set_from_variant(MalgtkMalitem *item,
+                              GVariant *variant)
+{
+    g_autoptr(GVariant) fields = NULL;
+    guint64 changed;
+
+    g_once (&s_defs_once, _init_s_defs, NULL);
+
+    /* The MALitem part notifies when this does */
+    g_object_freeze_notify (G_OBJECT (item));
+
+    MALGTK_MALITEM_CLASS (malgtk_anime_parent_class)->set_from_variant (item, variant);
+
+    fields  = g_variant_get_child_value (variant, 1);
+    changed = malgtk_variant_deserialize (s_variant_plan,
+                                          malgtk_anime_get_instance_private (MALGTK_ANIME (item)),
+                                          fields);
+
+    malgtk_xml_notify_changed (G_OBJECT (item), obj_properties, changed);
+    g_object_thaw_notify (G_OBJECT (item));
+}
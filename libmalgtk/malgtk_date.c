@@ -16,6 +16,7 @@
  */
 
 #include "malgtk_date.h"
+#include "malgtk_season.h"
 #include <string.h>
 
 static void
@@ -152,86 +153,174 @@ malgtk_date_set_dmy(MalgtkDate *date, GDateDay day, GDateMonth month, GDateYear
 gchar*
 malgtk_date_get_season(const MalgtkDate *date)
 {
-    GDateYear year;
+    gchar buf[MALGTK_DATE_SEASON_SIZE];
+    gsize len = malgtk_date_format_season(date, buf);
 
-    if (!g_date_valid_year(date->year)) {
-        return g_strdup("Unknown");
-    }
+    return g_strndup(buf, len);
+}
 
-    year = date->year;
-    if ( g_date_valid_month(date->month) ) {
-        switch (date->month) {
-            case G_DATE_DECEMBER:
-                ++year;
-                __attribute__ ((fallthrough));
-            case G_DATE_JANUARY:
-            case G_DATE_FEBRUARY:
-                return g_strdup_printf("Winter %u", year);
-            case G_DATE_MARCH:
-            case G_DATE_APRIL:
-            case G_DATE_MAY:
-                return g_strdup_printf("Spring %u", year);
-            case G_DATE_JUNE:
-            case G_DATE_JULY:
-            case G_DATE_AUGUST:
-                return g_strdup_printf("Summer %u", year);
-            case G_DATE_SEPTEMBER:
-            case G_DATE_OCTOBER:
-            case G_DATE_NOVEMBER:
-                return g_strdup_printf("Autumn %u", year);
-            case G_DATE_BAD_MONTH:
-            default:
-                break;
-        }
+/* The value of the n digits at str, or -1 if they aren't all digits.
+ * Stops at the first one that isn't, so never reads past the end. */
+static inline gint
+_parse_digits(const gchar *str, guint n)
+{
+    gint value = 0;
+
+    for (guint i = 0; i < n; ++i) {
+        guint digit = (guchar)str[i] - '0';
+        if (digit > 9)
+            return -1;
+        value = value * 10 + digit;
     }
 
-    return g_strdup_printf("%u", year);
+    return value;
 }
 
-/* Expected format: YYYY-MM-DD */
+/* Writes value without a terminator, returns the number of digits */
+static inline gsize
+_format_uint(gchar *buf, guint value)
+{
+    gchar digits[10];
+    gsize n = 0;
+
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    for (gsize i = 0; i < n; ++i)
+        buf[i] = digits[n - 1 - i];
+    return n;
+}
+
+static inline void
+_format_2digits(gchar *buf, guint value)
+{
+    buf[0] = '0' + value / 10;
+    buf[1] = '0' + value % 10;
+}
+
+/* Expected format: YYYY-MM-DD, YYYY-MM or YYYY */
 void
 malgtk_date_set_from_string (MalgtkDate *date, const gchar *str)
 {
-    size_t len;
-    GDateYear year;
-    GDateMonth month;
-    GDateDay day;
+    gint year;
+    gint month = -1;
+    gint day = -1;
 
     malgtk_date_clear(date);
 
-    len = strlen(str);
-    if (len < 4)
+    year = _parse_digits(str, 4);
+    if (year < 0)
         return;
 
-    year = g_ascii_strtoll(str, NULL, 10);
+    if ('\0' != str[4]) {
+        month = _parse_digits(str + 5, 2);
+        if (month >= 0 && '\0' != str[7])
+            day = _parse_digits(str + 8, 2);
+    }
+
     if (g_date_valid_year(year))
         date->year = year;
-    if (len < 6)
-        return;
-
-    month = g_ascii_strtoll(str + 5, NULL, 10);
-    if (g_date_valid_month(month))
+    if (month >= 0 && g_date_valid_month(month))
         date->month = month;
-    if (len < 9)
-        return;
-
-    day = g_ascii_strtoll(str + 8, NULL, 10);
-    if (g_date_valid_day(day))
+    if (day >= 0 && g_date_valid_day(day))
         date->day = day;
 }
 
+gsize
+malgtk_date_format(const MalgtkDate *date, gchar buf[MALGTK_DATE_STRING_SIZE])
+{
+    gsize len;
+
+    if (!g_date_valid_year(date->year)) {
+        memcpy(buf, "0000-00-00", sizeof "0000-00-00");
+        return sizeof "0000-00-00" - 1;
+    }
+
+    len = _format_uint(buf, date->year);
+    if (g_date_valid_month(date->month)) {
+        buf[len] = '-';
+        _format_2digits(buf + len + 1, date->month);
+        len += 3;
+
+        if (malgtk_date_is_complete(date)) {
+            buf[len] = '-';
+            _format_2digits(buf + len + 1, date->day);
+            len += 3;
+        }
+    }
+
+    buf[len] = '\0';
+    return len;
+}
+
 gchar *
 malgtk_date_get_string(const MalgtkDate *date)
 {
+    gchar buf[MALGTK_DATE_STRING_SIZE];
+    gsize len;
+
     if (NULL == date)
         return NULL;
-    if (malgtk_date_is_complete(date))
-        return g_strdup_printf("%u-%02u-%02u", date->year, date->month, date->day);
-    if (g_date_valid_month(date->month) && g_date_valid_year(date->year))
-        return g_strdup_printf("%u-%02u", date->year, date->month);
-    if (g_date_valid_year(date->year))
-        return g_strdup_printf("%u", date->year);
-    return g_strdup("0000-00-00");
+
+    len = malgtk_date_format(date, buf);
+    return g_strndup(buf, len);
+}
+
+guint32
+malgtk_date_get_key(const MalgtkDate *date)
+{
+    return (guint32)date->year << 16 | (guint32)date->month << 8 | date->day;
+}
+
+void
+malgtk_date_set_from_key(MalgtkDate *date, guint32 key)
+{
+    malgtk_date_set_dmy(date, key & 0xff, (key >> 8) & 0xff, key >> 16);
+}
+
+guint32
+malgtk_date_get_season_key(const MalgtkDate *date)
+{
+    return malgtk_season_key(date->year, date->month);
+}
+
+const gchar*
+malgtk_date_season_key_get_name(guint32 season_key)
+{
+    return malgtk_season_key_get_name(season_key);
+}
+
+GDateYear
+malgtk_date_season_key_get_year(guint32 season_key)
+{
+    return malgtk_season_key_get_year(season_key);
+}
+
+/* "Winter 2014", "2014" when the month is unknown, or "Unknown" */
+gsize
+malgtk_date_format_season(const MalgtkDate *date, gchar buf[MALGTK_DATE_SEASON_SIZE])
+{
+    guint32 key = malgtk_date_get_season_key(date);
+    const gchar *name;
+    gsize len = 0;
+
+    if (0 == key) {
+        memcpy(buf, "Unknown", sizeof "Unknown");
+        return sizeof "Unknown" - 1;
+    }
+
+    name = malgtk_date_season_key_get_name(key);
+    if (name) {
+        len = strlen(name);
+        memcpy(buf, name, len);
+        buf[len++] = ' ';
+    }
+
+    len += _format_uint(buf + len, malgtk_date_season_key_get_year(key));
+    buf[len] = '\0';
+    return len;
 }
 
 gboolean
@@ -252,31 +341,18 @@ malgtk_date_is_clear(const MalgtkDate *date)
 gboolean
 malgtk_date_is_equal(const MalgtkDate *a, const MalgtkDate *b)
 {
-    return a->day == b->day && a->month == b->month && a->year == b->year;
+    return malgtk_date_get_key(a) == malgtk_date_get_key(b);
 }
 
-gboolean
+gint
 malgtk_date_compare(const MalgtkDate *a, const MalgtkDate *b)
 {
+    guint32 ka, kb;
+
     g_return_val_if_fail(a != NULL, 0);
     g_return_val_if_fail(b != NULL, 0);
 
-    if (a->year < b->year)
-        return -1;
-    else if (a->year > b->year)
-        return 1;
-    else {
-        if (a->month < b->month)
-            return -1;
-        else if (a->month > b->month)
-            return 1;
-        else {
-            if (a->day < b->day)
-                return -1;
-            else if (a->day > b->day)
-                return 1;
-            else
-                return 0;
-        }
-    }
+    ka = malgtk_date_get_key(a);
+    kb = malgtk_date_get_key(b);
+    return (ka > kb) - (ka < kb);
 }
@@ -29,6 +29,11 @@ typedef struct _MalgtkDate
 
 #define MALGTK_TYPE_DATE malgtk_date_get_type()
 
+/* Big enough for malgtk_date_format(), "65535-12-31" */
+#define MALGTK_DATE_STRING_SIZE 12
+/* Big enough for malgtk_date_format_season(), "Winter 65536" */
+#define MALGTK_DATE_SEASON_SIZE 13
+
 GType       malgtk_date_get_type        (void);
 MalgtkDate* malgtk_date_new             (void);
 MalgtkDate* malgtk_date_copy            (const MalgtkDate *date);
@@ -48,6 +53,22 @@ gboolean    malgtk_date_is_clear        (const MalgtkDate *date);
 gboolean    malgtk_date_is_equal        (const MalgtkDate *a, const MalgtkDate *b);
 gint        malgtk_date_compare         (const MalgtkDate *a, const MalgtkDate *b);
 
+/* The date packed as year << 16 | month << 8 | day, with unknown parts
+ * as 0, so keys order the same way as dates */
+guint32     malgtk_date_get_key         (const MalgtkDate *date);
+void        malgtk_date_set_from_key    (MalgtkDate *date, guint32 key);
+
+/* Write malgtk_date_get_string() into buf, return its length */
+gsize       malgtk_date_format          (const MalgtkDate *date, gchar buf[MALGTK_DATE_STRING_SIZE]);
+gsize       malgtk_date_format_season   (const MalgtkDate *date, gchar buf[MALGTK_DATE_SEASON_SIZE]);
+
+/* Orders dates by season, those with only a year ahead of that year's
+ * seasons; 0 when the year is unknown. */
+guint32      malgtk_date_get_season_key      (const MalgtkDate *date);
+/* "Winter" and so on, or NULL for a key without a season */
+const gchar* malgtk_date_season_key_get_name (guint32 season_key);
+GDateYear    malgtk_date_season_key_get_year (guint32 season_key);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(MalgtkDate, malgtk_date_free)
 
 G_END_DECLS
@@ -0,0 +1,77 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "malgtk_enum_table.h"
+
+struct _MalgtkEnumTable
+{
+    GEnumClass   *enum_class;
+    const gchar **nicks;    /* Indexed by value - enum_class->minimum */
+    GHashTable   *values;   /* nick -> value */
+};
+
+gpointer
+malgtk_enum_table_new(gpointer enum_type)
+{
+    MalgtkEnumTable *table = g_new0(MalgtkEnumTable, 1);
+    GEnumClass *enum_class;
+
+    /* Held for good, as the table points into the class' values */
+    enum_class = g_type_class_ref((GType)GPOINTER_TO_SIZE(enum_type));
+
+    table->enum_class = enum_class;
+    table->nicks      = g_new0(const gchar*, enum_class->maximum - enum_class->minimum + 1);
+    table->values     = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (guint i = 0; i < enum_class->n_values; ++i) {
+        const GEnumValue *v = &enum_class->values[i];
+        table->nicks[v->value - enum_class->minimum] = v->value_nick;
+        g_hash_table_insert(table->values, (gpointer)v->value_nick, GINT_TO_POINTER(v->value));
+    }
+
+    return table;
+}
+
+gboolean
+malgtk_enum_table_lookup_nick(const MalgtkEnumTable *table,
+                              const gchar *nick,
+                              gint *value)
+{
+    gpointer v;
+
+    if (!g_hash_table_lookup_extended(table->values, nick, NULL, &v))
+        return FALSE;
+
+    *value = GPOINTER_TO_INT(v);
+    return TRUE;
+}
+
+const gchar*
+malgtk_enum_table_get_nick(const MalgtkEnumTable *table,
+                           gint value)
+{
+    if (value < table->enum_class->minimum || value > table->enum_class->maximum)
+        return NULL;
+
+    return table->nicks[value - table->enum_class->minimum];
+}
+
+const gchar*
+malgtk_enum_table_get_name(const MalgtkEnumTable *table)
+{
+    return G_ENUM_CLASS_TYPE_NAME(table->enum_class);
+}
@@ -0,0 +1,40 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* Nick and value lookups for one enum type.
+ *
+ * Each enum in malgtk_enumtypes.h gets its table from
+ * <enum_name>_get_table(), built the first time it is asked for and
+ * kept for the life of the process. Tables are never modified after
+ * that, so they are safe to share between threads.
+ */
+typedef struct _MalgtkEnumTable MalgtkEnumTable;
+
+gboolean     malgtk_enum_table_lookup_nick (const MalgtkEnumTable *table, const gchar *nick, gint *value);
+const gchar* malgtk_enum_table_get_nick    (const MalgtkEnumTable *table, gint value);
+const gchar* malgtk_enum_table_get_name    (const MalgtkEnumTable *table);
+
+/* For the generated <enum_name>_get_table(), as a GThreadFunc for g_once() */
+gpointer     malgtk_enum_table_new         (gpointer enum_type);
+
+G_END_DECLS
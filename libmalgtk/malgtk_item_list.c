@@ -0,0 +1,693 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "malgtk_item_list.h"
+#include <string.h>
+
+/* The index is a set of these, hashed on the id at their start. They
+ * are allocated a batch at a time, in slabs the list frees when it is
+ * emptied, rather than one by one. */
+typedef struct
+{
+    gint64 mal_db_id;
+    guint  position;
+} IndexEntry;
+
+struct _MalgtkItemList
+{
+    GObject             parent_instance;
+
+    GType               item_type;
+    MalgtkMalitemClass *item_class;
+    GPtrArray          *items;      /* NULL where source hasn't been read yet */
+    GHashTable         *index;
+    GPtrArray          *slabs;
+    GVariant           *source;     /* What the list was loaded from, until it changes */
+};
+
+static MalgtkMalitem *_get_item(MalgtkItemList *self, guint position);
+
+static void malgtk_item_list_list_model_init (GListModelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (MalgtkItemList, malgtk_item_list, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, malgtk_item_list_list_model_init))
+
+enum
+{
+    PROP_0,
+    PROP_ITEM_TYPE,
+    N_PROPERTIES
+};
+
+static GParamSpec *obj_properties[N_PROPERTIES] = { NULL, };
+
+static GType
+malgtk_item_list_get_item_type (GListModel *model)
+{
+    return MALGTK_ITEM_LIST(model)->item_type;
+}
+
+static guint
+malgtk_item_list_get_n_items (GListModel *model)
+{
+    return MALGTK_ITEM_LIST(model)->items->len;
+}
+
+static gpointer
+malgtk_item_list_get_item (GListModel *model,
+                           guint       position)
+{
+    MalgtkItemList *self = MALGTK_ITEM_LIST(model);
+
+    if (position >= self->items->len)
+        return NULL;
+
+    return g_object_ref(_get_item(self, position));
+}
+
+static void
+malgtk_item_list_list_model_init (GListModelInterface *iface)
+{
+    iface->get_item_type = malgtk_item_list_get_item_type;
+    iface->get_n_items   = malgtk_item_list_get_n_items;
+    iface->get_item      = malgtk_item_list_get_item;
+}
+
+static void
+malgtk_item_list_set_property (GObject      *object,
+                               guint         property_id,
+                               const GValue *value,
+                               GParamSpec   *pspec)
+{
+    MalgtkItemList *self = MALGTK_ITEM_LIST (object);
+
+    switch (property_id)
+    {
+        case PROP_ITEM_TYPE:
+            self->item_type  = g_value_get_gtype (value);
+            g_clear_pointer (&self->item_class, g_type_class_unref);
+            self->item_class = g_type_class_ref (self->item_type);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+malgtk_item_list_get_property (GObject    *object,
+                               guint       property_id,
+                               GValue     *value,
+                               GParamSpec *pspec)
+{
+    MalgtkItemList *self = MALGTK_ITEM_LIST (object);
+
+    switch (property_id)
+    {
+        case PROP_ITEM_TYPE:
+            g_value_set_gtype (value, self->item_type);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+malgtk_item_list_dispose (GObject *obj)
+{
+    MalgtkItemList *self = MALGTK_ITEM_LIST (obj);
+
+    g_hash_table_remove_all (self->index);
+    g_ptr_array_set_size (self->items, 0);
+    g_ptr_array_set_size (self->slabs, 0);
+    g_clear_pointer (&self->source, g_variant_unref);
+
+    G_OBJECT_CLASS (malgtk_item_list_parent_class)->dispose (obj);
+}
+
+static void
+malgtk_item_list_finalize (GObject *obj)
+{
+    MalgtkItemList *self = MALGTK_ITEM_LIST (obj);
+
+    g_hash_table_unref (self->index);
+    g_ptr_array_unref (self->items);
+    g_ptr_array_unref (self->slabs);
+    g_clear_pointer (&self->item_class, g_type_class_unref);
+
+    G_OBJECT_CLASS (malgtk_item_list_parent_class)->finalize (obj);
+}
+
+static void
+malgtk_item_list_class_init (MalgtkItemListClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+    gobject_class->set_property = malgtk_item_list_set_property;
+    gobject_class->get_property = malgtk_item_list_get_property;
+    gobject_class->dispose      = malgtk_item_list_dispose;
+    gobject_class->finalize     = malgtk_item_list_finalize;
+
+    obj_properties[PROP_ITEM_TYPE] =
+        g_param_spec_gtype ("item-type",
+                            "Item Type",
+                            "The type of the items in the list",
+                            MALGTK_TYPE_MALITEM,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties (gobject_class,
+                                       N_PROPERTIES,
+                                       obj_properties);
+}
+
+static void
+_item_unref(gpointer item)
+{
+    if (item)
+        g_object_unref (item);
+}
+
+static void
+malgtk_item_list_init (MalgtkItemList *self)
+{
+    self->item_type = MALGTK_TYPE_MALITEM;
+    self->items     = g_ptr_array_new_with_free_func (_item_unref);
+    self->index     = g_hash_table_new (g_int64_hash, g_int64_equal);
+    self->slabs     = g_ptr_array_new_with_free_func (g_free);
+}
+
+static IndexEntry *
+_index_lookup(MalgtkItemList *self,
+              gint64          mal_db_id)
+{
+    return g_hash_table_lookup (self->index, &mal_db_id);
+}
+
+/* Room for n_entries _index_add()s */
+static IndexEntry *
+_index_alloc(MalgtkItemList *self,
+             guint           n_entries)
+{
+    IndexEntry *slab = g_new (IndexEntry, n_entries);
+    g_ptr_array_add (self->slabs, slab);
+    return slab;
+}
+
+static void
+_index_add(MalgtkItemList *self,
+           IndexEntry     *entry,
+           gint64          mal_db_id,
+           guint           position)
+{
+    entry->mal_db_id = mal_db_id;
+    entry->position  = position;
+    g_hash_table_add (self->index, entry);
+}
+
+static MalgtkMalitem *
+_get_item(MalgtkItemList *self,
+          guint           position)
+{
+    MalgtkMalitem *item = g_ptr_array_index (self->items, position);
+    g_autoptr(GVariant) variant = NULL;
+
+    if (G_LIKELY(NULL != item))
+        return item;
+
+    variant = g_variant_get_child_value (self->source, position);
+    item    = g_object_new (self->item_type, NULL);
+    self->item_class->set_from_variant (item, variant);
+
+    g_ptr_array_index (self->items, position) = item;
+    return item;
+}
+
+/* Before the list changes, so positions no longer follow source */
+static void
+_detach_source(MalgtkItemList *self)
+{
+    if (NULL == self->source)
+        return;
+
+    for (guint i = 0; i < self->items->len; ++i)
+        _get_item (self, i);
+
+    g_clear_pointer (&self->source, g_variant_unref);
+}
+
+static GVariantType *
+_new_variant_type(MalgtkItemList *self)
+{
+    return g_variant_type_new_array (self->item_class->get_variant_type ());
+}
+
+static gint
+_compare_position(gconstpointer a,
+                  gconstpointer b)
+{
+    const guint pa = *(const guint*)a;
+    const guint pb = *(const guint*)b;
+    return (pa > pb) - (pa < pb);
+}
+
+MalgtkItemList *
+malgtk_item_list_new(GType item_type)
+{
+    g_return_val_if_fail(g_type_is_a(item_type, MALGTK_TYPE_MALITEM), NULL);
+
+    return g_object_new(MALGTK_TYPE_ITEM_LIST, "item-type", item_type, NULL);
+}
+
+/* Unlike g_list_model_get_item(), doesn't add a reference */
+MalgtkMalitem *
+malgtk_item_list_get(MalgtkItemList *list,
+                     guint           position)
+{
+    g_return_val_if_fail(MALGTK_IS_ITEM_LIST(list), NULL);
+
+    if (position >= list->items->len)
+        return NULL;
+
+    return _get_item(list, position);
+}
+
+gboolean
+malgtk_item_list_find(MalgtkItemList *list,
+                      gint64          mal_db_id,
+                      guint          *position)
+{
+    IndexEntry *entry;
+
+    g_return_val_if_fail(MALGTK_IS_ITEM_LIST(list), FALSE);
+
+    /* Items merge is still collecting are in the index ahead of the
+     * array */
+    entry = _index_lookup(list, mal_db_id);
+    if (NULL == entry || entry->position >= list->items->len)
+        return FALSE;
+
+    if (position)
+        *position = entry->position;
+    return TRUE;
+}
+
+/* Doesn't add a reference */
+MalgtkMalitem *
+malgtk_item_list_lookup(MalgtkItemList *list,
+                        gint64          mal_db_id)
+{
+    guint position;
+
+    if (!malgtk_item_list_find(list, mal_db_id, &position))
+        return NULL;
+
+    return _get_item(list, position);
+}
+
+void
+malgtk_item_list_append(MalgtkItemList *list,
+                        MalgtkMalitem  *item)
+{
+    malgtk_item_list_merge(list, &item, 1);
+}
+
+/* Items whose mal-db-id is already in the list replace the one there,
+ * in place; the rest are appended in order. When the same id comes up
+ * twice in @items the later one wins. */
+void
+malgtk_item_list_merge(MalgtkItemList *list,
+                       MalgtkMalitem **items,
+                       guint           n_items)
+{
+    g_autoptr(GArray) replaced = NULL;
+    g_autoptr(GPtrArray) added = NULL;
+    IndexEntry *entry;
+    IndexEntry *slab = NULL;
+    guint old_len;
+    gint64 id;
+    guint i, start;
+
+    g_return_if_fail(MALGTK_IS_ITEM_LIST(list));
+    g_return_if_fail(NULL != items || 0 == n_items);
+
+    for (i = 0; i < n_items; ++i)
+        g_return_if_fail(g_type_is_a(G_OBJECT_TYPE(items[i]), list->item_type));
+
+    _detach_source(list);
+
+    old_len  = list->items->len;
+    replaced = g_array_new(FALSE, FALSE, sizeof(guint));
+    added    = g_ptr_array_sized_new(n_items);
+
+    for (i = 0; i < n_items; ++i) {
+        id    = malgtk_malitem_get_mal_db_id(items[i]);
+        entry = _index_lookup(list, id);
+        if (NULL == entry) {
+            if (NULL == slab)
+                slab = _index_alloc(list, n_items - i);
+            _index_add(list, slab++, id, old_len + added->len);
+            g_ptr_array_add(added, g_object_ref(items[i]));
+        } else if (entry->position >= old_len) {
+            g_object_unref(g_ptr_array_index(added, entry->position - old_len));
+            g_ptr_array_index(added, entry->position - old_len) = g_object_ref(items[i]);
+        } else {
+            g_object_ref(items[i]);
+            g_object_unref(g_ptr_array_index(list->items, entry->position));
+            g_ptr_array_index(list->items, entry->position) = items[i];
+            g_array_append_val(replaced, entry->position);
+        }
+    }
+
+    /* One signal for each run of replaced positions, then one for
+     * everything appended */
+    g_array_sort(replaced, _compare_position);
+    for (i = 0; i < replaced->len; i = start) {
+        guint first = g_array_index(replaced, guint, i);
+        guint last  = first;
+
+        for (start = i + 1; start < replaced->len; ++start) {
+            guint p = g_array_index(replaced, guint, start);
+            if (p > last + 1)
+                break;
+            last = p;
+        }
+
+        g_list_model_items_changed(G_LIST_MODEL(list), first, last - first + 1, last - first + 1);
+    }
+
+    if (added->len > 0) {
+        g_ptr_array_set_size(list->items, old_len + added->len);
+        memcpy(list->items->pdata + old_len, added->pdata, added->len * sizeof(gpointer));
+        g_list_model_items_changed(G_LIST_MODEL(list), old_len, 0, added->len);
+    }
+}
+
+gboolean
+malgtk_item_list_remove(MalgtkItemList *list,
+                        gint64          mal_db_id)
+{
+    guint position;
+
+    if (!malgtk_item_list_find(list, mal_db_id, &position))
+        return FALSE;
+
+    _detach_source(list);
+    g_hash_table_remove(list->index, &mal_db_id);
+    g_ptr_array_remove_index(list->items, position);
+
+    for (guint i = position; i < list->items->len; ++i)
+        _index_lookup(list, malgtk_malitem_get_mal_db_id(g_ptr_array_index(list->items, i)))->position = i;
+
+    g_list_model_items_changed(G_LIST_MODEL(list), position, 1, 0);
+    return TRUE;
+}
+
+void
+malgtk_item_list_remove_all(MalgtkItemList *list)
+{
+    guint n_items;
+
+    g_return_if_fail(MALGTK_IS_ITEM_LIST(list));
+
+    n_items = list->items->len;
+    if (0 == n_items)
+        return;
+
+    g_hash_table_remove_all(list->index);
+    g_ptr_array_set_size(list->items, 0);
+    g_ptr_array_set_size(list->slabs, 0);
+    g_clear_pointer(&list->source, g_variant_unref);
+    g_list_model_items_changed(G_LIST_MODEL(list), 0, n_items, 0);
+}
+
+/* Only indexes the items, they are created by _get_item. An item
+ * whose mal-db-id is already taken is dropped, so that every position
+ * is indexed: the source is then rebuilt without it. */
+static void
+_load_variant(MalgtkItemList *list,
+              GVariant       *variant)
+{
+    g_autoptr(GVariant) loaded = g_variant_ref_sink(variant);
+    g_autoptr(GPtrArray) kept  = NULL; /* The children, once one is dropped */
+    IndexEntry *slab;
+    gsize n_items;
+    guint position = 0;
+
+    n_items = g_variant_n_children(loaded);
+    slab    = _index_alloc(list, n_items);
+
+    for (gsize i = 0; i < n_items; ++i) {
+        g_autoptr(GVariant) child = g_variant_get_child_value(loaded, i);
+        gint64 id = malgtk_malitem_variant_get_mal_db_id(child);
+
+        if (NULL != _index_lookup(list, id)) {
+            g_warning("Dropping duplicate mal-db-id in item list: %" G_GINT64_FORMAT, id);
+            if (NULL == kept) {
+                kept = g_ptr_array_new_full(n_items, (GDestroyNotify)g_variant_unref);
+                for (gsize j = 0; j < i; ++j)
+                    g_ptr_array_add(kept, g_variant_get_child_value(loaded, j));
+            }
+            continue;
+        }
+
+        if (kept)
+            g_ptr_array_add(kept, g_steal_pointer(&child));
+        _index_add(list, slab++, id, position++);
+    }
+
+    if (kept)
+        list->source = g_variant_ref_sink(g_variant_new_array(list->item_class->get_variant_type(),
+                                                              (GVariant * const *)kept->pdata, kept->len));
+    else
+        list->source = g_steal_pointer(&loaded);
+    g_ptr_array_set_size(list->items, position);
+}
+
+/* variant must be an array of item_type's variant type. Items are
+ * created from it as they are asked for, so it is kept, and any data
+ * it points into, such as a mapped file, must not change. */
+MalgtkItemList *
+malgtk_item_list_new_from_variant(GType     item_type,
+                                  GVariant *variant)
+{
+    g_autoptr(MalgtkItemList) list = NULL;
+    g_autoptr(GVariantType) type = NULL;
+
+    list = malgtk_item_list_new(item_type);
+    g_return_val_if_fail(NULL != list, NULL);
+
+    type = _new_variant_type(list);
+    g_return_val_if_fail(g_variant_is_of_type(variant, type), NULL);
+
+    _load_variant(list, variant);
+
+    return g_steal_pointer(&list);
+}
+
+/* Returns a new, non-floating reference. Items that have been created
+ * may have been changed through their properties since, so they are
+ * serialized afresh; the rest are taken from the variant the list was
+ * loaded from, and a list none of whose items has been created returns
+ * that variant. */
+GVariant *
+malgtk_item_list_get_variant(MalgtkItemList *list)
+{
+    GVariant **children;
+    GVariant *variant;
+    gboolean materialized = FALSE;
+
+    g_return_val_if_fail(MALGTK_IS_ITEM_LIST(list), NULL);
+
+    for (guint i = 0; i < list->items->len && !materialized; ++i)
+        materialized = NULL != g_ptr_array_index(list->items, i);
+
+    if (list->source && !materialized)
+        return g_variant_ref(list->source);
+
+    children = g_new(GVariant*, list->items->len);
+    for (guint i = 0; i < list->items->len; ++i) {
+        MalgtkMalitem *item = g_ptr_array_index(list->items, i);
+
+        /* One reference each, dropped once the array has its own */
+        if (item)
+            children[i] = g_variant_ref_sink(list->item_class->get_variant(item));
+        else
+            children[i] = g_variant_get_child_value(list->source, i);
+    }
+
+    variant = g_variant_new_array(list->item_class->get_variant_type(), children, list->items->len);
+    for (guint i = 0; i < list->items->len; ++i)
+        g_variant_unref(children[i]);
+    g_free(children);
+
+    return g_variant_ref_sink(variant);
+}
+
+/* The file is a FILE_TYPE tuple: FILE_MAGIC, FILE_VERSION, the item
+ * class' variant schema and the list's variant boxed in a "v", in host
+ * byte order. It is a cache, not an interchange format, so a file
+ * written by another version, or for items whose fields have changed,
+ * is rejected rather than converted. */
+#define FILE_TYPE    "(suuv)"
+#define FILE_MAGIC   "malgtk-item-list"
+#define FILE_VERSION 1
+
+MalgtkItemList *
+malgtk_item_list_new_from_file(GType         item_type,
+                               const gchar  *path,
+                               GError      **error)
+{
+    g_autoptr(GMappedFile) mapped = NULL;
+    g_autoptr(GBytes) bytes = NULL;
+    g_autoptr(GVariant) file = NULL;
+    g_autoptr(GVariant) items = NULL;
+    g_autoptr(GVariantType) type = NULL;
+    g_autoptr(MalgtkItemList) list = NULL;
+    const gchar *magic;
+    guint32 version, schema;
+
+    g_return_val_if_fail(g_type_is_a(item_type, MALGTK_TYPE_MALITEM), NULL);
+
+    mapped = g_mapped_file_new(path, FALSE, error);
+    if (NULL == mapped)
+        return NULL;
+
+    bytes = g_mapped_file_get_bytes(mapped);
+    file  = g_variant_ref_sink(g_variant_new_from_bytes(G_VARIANT_TYPE(FILE_TYPE), bytes, FALSE));
+
+    /* Untrusted data that is not a FILE_TYPE reads as its defaults,
+     * which don't hold the magic */
+    g_variant_get(file, "(&suu@v)", &magic, &version, &schema, NULL);
+    if (0 != strcmp(magic, FILE_MAGIC) || FILE_VERSION != version) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "%s is not an item list file of this version", path);
+        return NULL;
+    }
+
+    list = malgtk_item_list_new(item_type);
+    if (list->item_class->get_variant_schema() != schema) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "%s was written for other %s fields", path, g_type_name(item_type));
+        return NULL;
+    }
+
+    g_variant_get_child(file, 3, "v", &items);
+    type = _new_variant_type(list);
+    if (!g_variant_is_of_type(items, type)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "%s does not hold a list of %s", path, g_type_name(item_type));
+        return NULL;
+    }
+
+    _load_variant(list, items);
+
+    return g_steal_pointer(&list);
+}
+
+gboolean
+malgtk_item_list_save_file(MalgtkItemList  *list,
+                           const gchar     *path,
+                           GError         **error)
+{
+    g_autoptr(GVariant) items = NULL;
+    g_autoptr(GVariant) file = NULL;
+
+    g_return_val_if_fail(MALGTK_IS_ITEM_LIST(list), FALSE);
+
+    items = malgtk_item_list_get_variant(list);
+    file  = g_variant_ref_sink(g_variant_new(FILE_TYPE, FILE_MAGIC, FILE_VERSION,
+                                             list->item_class->get_variant_schema(), items));
+
+    return g_file_set_contents(path, g_variant_get_data(file), g_variant_get_size(file), error);
+}
+
+/* Reads every item_type element under the reader's current node, or in
+ * the whole document if it hasn't been read yet, and merges them in as one batch. The items
+ * are filled in before anything can be watching them, so none of
+ * their properties are notified. size_hint, if known, is roughly how
+ * many there are. Returns how many were read. */
+guint
+malgtk_item_list_load_xml(MalgtkItemList   *list,
+                          xmlTextReaderPtr  reader,
+                          guint             size_hint)
+{
+    g_autoptr(GPtrArray) items = NULL;
+    const xmlChar *name;
+    gint depth;
+
+    g_return_val_if_fail(MALGTK_IS_ITEM_LIST(list), 0);
+
+    items = g_ptr_array_new_full(size_hint, g_object_unref);
+
+    /* Names come out of the reader's dictionary, so they can be
+     * compared by address */
+    name  = xmlTextReaderConstString(reader, BAD_CAST list->item_class->xml_name);
+    depth = XML_TEXTREADER_MODE_INITIAL == xmlTextReaderReadState(reader) ? -1 : xmlTextReaderDepth(reader);
+
+    while (1 == xmlTextReaderRead(reader) && xmlTextReaderDepth(reader) > depth) {
+        MalgtkMalitem *item;
+
+        if (XML_READER_TYPE_ELEMENT != xmlTextReaderNodeType(reader) ||
+            name != xmlTextReaderConstName(reader))
+            continue;
+
+        item = g_object_new(list->item_type, NULL);
+        list->item_class->load_xml(item, reader);
+        g_ptr_array_add(items, item);
+    }
+
+    malgtk_item_list_merge(list, (MalgtkMalitem**)items->pdata, items->len);
+    return items->len;
+}
+
+/* Counts the item elements up front, which is much cheaper than
+ * parsing them, to size everything the load allocates */
+guint
+malgtk_item_list_load_xml_buffer(MalgtkItemList *list,
+                                 const gchar    *buffer,
+                                 gsize           len)
+{
+    g_autofree gchar *tag = NULL;
+    const gchar *end = buffer + len;
+    const gchar *p;
+    xmlTextReaderPtr reader;
+    gsize tag_len;
+    guint size_hint = 0;
+    guint n_items;
+
+    g_return_val_if_fail(MALGTK_IS_ITEM_LIST(list), 0);
+    g_return_val_if_fail(NULL != buffer || 0 == len, 0);
+
+    tag     = g_strconcat("<", list->item_class->xml_name, NULL);
+    tag_len = strlen(tag);
+    for (p = buffer; NULL != (p = g_strstr_len(p, end - p, tag)); p += tag_len) {
+        if (p + tag_len < end && '\0' != p[tag_len] && strchr("> \t\r\n/", p[tag_len]))
+            ++size_hint;
+    }
+
+    reader = xmlReaderForMemory(buffer, len, NULL, NULL, 0);
+    if (NULL == reader) {
+        g_warning("Could not create an XML reader");
+        return 0;
+    }
+
+    n_items = malgtk_item_list_load_xml(list, reader, size_hint);
+
+    xmlFreeTextReader(reader);
+    return n_items;
+}
@@ -0,0 +1,59 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include "malgtk_malitem.h"
+
+G_BEGIN_DECLS
+
+/* A list of MalgtkMalitems, kept in a dense array in insertion order
+ * and indexed by their mal-db-id, so an item can be found without a
+ * scan. Implements GListModel.
+ *
+ * The batch functions change the list in one go and emit a single
+ * items-changed per contiguous run of positions they touched, not
+ * one per item. An item's mal-db-id must not change while it is in
+ * a list.
+ *
+ * A list can also be saved as, and loaded from, an array of the item
+ * class' GVariant (see MalgtkMalitemClass). A loaded list keeps the
+ * variant, possibly a mapped file, and only creates an item when it
+ * is first asked for; changing the list creates the rest.
+ */
+#define MALGTK_TYPE_ITEM_LIST             (malgtk_item_list_get_type ())
+G_DECLARE_FINAL_TYPE(MalgtkItemList, malgtk_item_list, MALGTK, ITEM_LIST, GObject)
+
+MalgtkItemList *malgtk_item_list_new        (GType item_type);
+MalgtkMalitem  *malgtk_item_list_get        (MalgtkItemList *list, guint position);
+MalgtkMalitem  *malgtk_item_list_lookup     (MalgtkItemList *list, gint64 mal_db_id);
+gboolean        malgtk_item_list_find       (MalgtkItemList *list, gint64 mal_db_id, guint *position);
+void            malgtk_item_list_append     (MalgtkItemList *list, MalgtkMalitem *item);
+void            malgtk_item_list_merge      (MalgtkItemList *list, MalgtkMalitem **items, guint n_items);
+gboolean        malgtk_item_list_remove     (MalgtkItemList *list, gint64 mal_db_id);
+void            malgtk_item_list_remove_all (MalgtkItemList *list);
+
+MalgtkItemList *malgtk_item_list_new_from_variant (GType item_type, GVariant *variant);
+GVariant       *malgtk_item_list_get_variant      (MalgtkItemList *list);
+MalgtkItemList *malgtk_item_list_new_from_file    (GType item_type, const gchar *path, GError **error);
+gboolean        malgtk_item_list_save_file        (MalgtkItemList *list, const gchar *path, GError **error);
+
+guint           malgtk_item_list_load_xml         (MalgtkItemList *list, xmlTextReaderPtr reader, guint size_hint);
+guint           malgtk_item_list_load_xml_buffer  (MalgtkItemList *list, const gchar *buffer, gsize len);
+
+G_END_DECLS
@@ -20,9 +20,9 @@
 #include "malgtk_malitem.h"
 #include "malgtk_date.h"
 #include "malgtk_enumtypes.h"
-#include "malgtk_deserialize_v1_tools.h"
 #include "malgtk_xml.h"
-#include "malgtk_gtree.h"
+#include "malgtk_variant.h"
+#include "malgtk_string_set.h"
 
 typedef struct _MalgtkMalitemPrivate
 {
@@ -32,10 +32,10 @@ typedef struct _MalgtkMalitemPrivate
     MalgtkDate series_begin;
     MalgtkDate series_end;
     GString *image_url;
-    GTree *series_synonyms;
+    MalgtkStringSet series_synonyms;
     GString *synopsis;
 
-    GTree *tags;
+    MalgtkStringSet tags;
     GDate date_start;
     GDate date_finish;
     gint64 id;
@@ -52,9 +52,6 @@ typedef struct _MalgtkMalitemPrivate
     gboolean enable_discussion;
 
     gboolean has_details;
-
-    GStringChunk *chunk;
-
 } MalgtkMalitemPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MalgtkMalitem, malgtk_malitem, G_TYPE_OBJECT)
@@ -65,9 +62,6 @@ malgtk_malitem_get_instance_private_const (const MalgtkMalitem *self)
   return (G_STRUCT_MEMBER_P (self, MalgtkMalitem_private_offset));
 }
 
-static gchar ** _tree_to_gstrv(GTree *tree);
-static void     _tree_remove_all(GTree *tree);
-
 enum
 {
     PROP_0,
@@ -101,46 +95,6 @@ enum
 
 static GParamSpec *obj_properties[N_PROPERTIES] = { NULL, };
 
-struct strv_tree_data
-{
-    const gchar * const * strv;
-    gboolean is_equal;
-};
-
-static gboolean
-strv_tree_eq_fn(gpointer key,
-                gpointer value __attribute__((unused)),
-                gpointer data)
-{
-    struct strv_tree_data *d = (struct strv_tree_data*)data;
-    if (!g_strv_contains(d->strv, (const gchar*)key)) {
-        d->is_equal = FALSE;
-        return TRUE;
-    }
-
-    return FALSE;
-}
-
-static gboolean
-is_strv_tree_equal(gchar **strv,
-                   GTree *tree)
-{
-    struct strv_tree_data d;
-
-    for (gchar **s = strv; NULL != *s; ++s) {
-        if (!g_tree_lookup_extended (tree, *s, NULL, NULL)) {
-            return FALSE;
-        }
-    }
-
-    d.strv     = (const gchar * const *)strv;
-    d.is_equal = TRUE;
-
-    g_tree_foreach(tree, strv_tree_eq_fn, &d);
-
-    return d.is_equal;
-}
-
 static void
 malgtk_malitem_set_property (GObject      *object,
                              guint         property_id,
@@ -215,16 +169,8 @@ malgtk_malitem_set_property (GObject      *object,
             break;
         case PROP_SERIES_SYNONYM:
             strv = g_value_get_boxed(value);
-            if (!is_strv_tree_equal(strv, priv->series_synonyms)) {
-                _tree_remove_all(priv->series_synonyms);
-                for (; NULL != *strv; ++strv) {
-                    if (!g_tree_lookup_extended(priv->series_synonyms, *strv, NULL, NULL)) {
-                        g_tree_insert(priv->series_synonyms,
-                                      g_string_chunk_insert_const(priv->chunk, *strv), NULL);
-                    }
-                }
+            if (malgtk_string_set_assign_strv(&priv->series_synonyms, (const gchar * const *)strv))
                 g_object_notify_by_pspec(object, obj_properties[PROP_SERIES_SYNONYM]);
-            }
             break;
         case PROP_SERIES_SYNOPSIS:
             str = g_value_get_string (value);
@@ -235,16 +181,8 @@ malgtk_malitem_set_property (GObject      *object,
             break;
         case PROP_TAGS:
             strv = g_value_get_boxed(value);
-            if (!is_strv_tree_equal(strv, priv->tags)) {
-                _tree_remove_all(priv->tags);
-                for (; NULL != *strv; ++strv) {
-                    if (!g_tree_lookup_extended(priv->tags, *strv, NULL, NULL)) {
-                        g_tree_insert(priv->tags,
-                                      g_string_chunk_insert_const(priv->chunk, *strv), NULL);
-                    }
-                }
+            if (malgtk_string_set_assign_strv(&priv->tags, (const gchar * const *)strv))
                 g_object_notify_by_pspec(object, obj_properties[PROP_TAGS]);
-            }
             break;
         case PROP_DATE_START:
             date = (GDate*)g_value_get_boxed(value);
@@ -395,13 +333,13 @@ malgtk_malitem_get_property (GObject    *object,
             g_value_set_string (value, priv->image_url->str);
             break;
         case PROP_SERIES_SYNONYM:
-            g_value_take_boxed (value, _tree_to_gstrv(priv->series_synonyms));
+            g_value_take_boxed (value, malgtk_string_set_to_strv(&priv->series_synonyms));
             break;
         case PROP_SERIES_SYNOPSIS:
             g_value_set_string (value, priv->synopsis->str);
             break;
         case PROP_TAGS:
-            g_value_take_boxed (value, _tree_to_gstrv(priv->tags));
+            g_value_take_boxed (value, malgtk_string_set_to_strv(&priv->tags));
             break;
         case PROP_DATE_START:
             if (g_date_valid (&priv->date_start))
@@ -473,21 +411,28 @@ malgtk_malitem_finalize (GObject *obj)
     g_string_free (priv->series_title, TRUE);
     g_string_free (priv->preferred_title, TRUE);
     g_string_free (priv->image_url, TRUE);
-    g_tree_unref (priv->series_synonyms);
+    malgtk_string_set_clear (&priv->series_synonyms);
     g_string_free (priv->synopsis, TRUE);
 
-    g_tree_unref (priv->tags);
+    malgtk_string_set_clear (&priv->tags);
     g_date_time_unref(priv->last_updated);
 
     g_string_free (priv->fansub_group, TRUE);
     g_string_free (priv->comments, TRUE);
 
-    g_string_chunk_free (priv->chunk);
-
     G_OBJECT_CLASS (malgtk_malitem_parent_class)->finalize (obj);
 }
 
 
+static const GVariantType *malgtk_malitem_real_get_variant_type (void);
+static guint32             malgtk_malitem_real_get_variant_schema (void);
+static GVariant           *malgtk_malitem_real_get_variant      (const MalgtkMalitem *item);
+static void                malgtk_malitem_real_set_from_variant (MalgtkMalitem *item, GVariant *variant);
+static void                malgtk_malitem_real_load_xml         (MalgtkMalitem *item, xmlTextReaderPtr reader);
+
+/* Immutable, so every new item shares it */
+static GDateTime *s_epoch;
+
 static void
 malgtk_malitem_class_init (MalgtkMalitemClass *klass)
 {
@@ -498,6 +443,15 @@ malgtk_malitem_class_init (MalgtkMalitemClass *klass)
     gobject_class->dispose      = malgtk_malitem_dispose;
     gobject_class->finalize     = malgtk_malitem_finalize;
 
+    klass->get_variant_type     = malgtk_malitem_real_get_variant_type;
+    klass->get_variant_schema   = malgtk_malitem_real_get_variant_schema;
+    klass->get_variant          = malgtk_malitem_real_get_variant;
+    klass->set_from_variant     = malgtk_malitem_real_set_from_variant;
+    klass->xml_name             = "MALitem";
+    klass->load_xml             = malgtk_malitem_real_load_xml;
+
+    s_epoch = g_date_time_new_from_unix_utc (0);
+
     obj_properties[PROP_SERIES_MALDB_ID] =
         g_param_spec_int64 ("mal-db-id",
                             "MAL.net id",
@@ -692,15 +646,6 @@ malgtk_malitem_class_init (MalgtkMalitemClass *klass)
 
 }
 
-static gint
-_gcompare_str(gconstpointer a,
-              gconstpointer b,
-              gpointer user_data)
-{
-    (void) user_data;
-    return g_utf8_collate(a, b);
-}
-
 static void
 malgtk_malitem_init (MalgtkMalitem *self)
 {
@@ -710,19 +655,15 @@ malgtk_malitem_init (MalgtkMalitem *self)
     malgtk_date_clear(&priv->series_begin);
     malgtk_date_clear(&priv->series_end);
     priv->image_url       = g_string_new("");
-    priv->series_synonyms = g_tree_new_full(_gcompare_str, NULL, NULL, NULL);
     priv->synopsis        = g_string_new("");
 
-    priv->tags            = g_tree_new_full(_gcompare_str, NULL, NULL, NULL);
     g_date_clear(&priv->date_start, 1);
     g_date_clear(&priv->date_finish, 1);
-    priv->last_updated    = g_date_time_new_from_unix_utc (0);
+    priv->last_updated    = g_date_time_ref (s_epoch);
     priv->fansub_group    = g_string_new("");
     priv->comments        = g_string_new("");
     priv->reconsume_value = MALGTK_MALITEM_RECONSUME_VALUE_INVALID;
     priv->priority        = MALGTK_MALITEM_PRIORITY_INVALID;
-
-    priv->chunk           = g_string_chunk_new(128);
 }
 
 
@@ -733,26 +674,27 @@ malgtk_malitem_new(void)
     return g_object_new(MALGTK_TYPE_MALITEM, NULL);
 }
 
+gint64
+malgtk_malitem_get_mal_db_id(const MalgtkMalitem *item)
+{
+    const MalgtkMalitemPrivate *priv = malgtk_malitem_get_instance_private_const(item);
+    return priv->mal_db_id;
+}
+
 void
 malgtk_malitem_add_synonym(MalgtkMalitem *item,
                            const gchar *synonym)
 {
     MalgtkMalitemPrivate *priv;
-    gpointer p;
 
     g_return_if_fail(MALGTK_IS_MALITEM(item));
     g_return_if_fail(NULL != synonym && 0 != *synonym);
 
     priv = malgtk_malitem_get_instance_private (item);
 
-
-    p = g_tree_lookup(priv->series_synonyms, synonym);
-    if (p)
+    if (!malgtk_string_set_add(&priv->series_synonyms, synonym))
         return;
 
-    g_tree_insert(priv->series_synonyms,
-                  g_string_chunk_insert_const(priv->chunk, synonym), NULL);
-
     g_object_notify_by_pspec(G_OBJECT(item), obj_properties[PROP_SERIES_SYNONYM]);
 }
 
@@ -761,35 +703,27 @@ malgtk_malitem_add_tag(MalgtkMalitem *item,
                        const gchar *tag)
 {
     MalgtkMalitemPrivate *priv;
-    gpointer p;
 
     g_return_if_fail(MALGTK_IS_MALITEM(item));
     g_return_if_fail(NULL != tag && 0 != *tag);
 
     priv = malgtk_malitem_get_instance_private (item);
 
-    p = g_tree_lookup(priv->tags, tag);
-    if (p)
+    if (!malgtk_string_set_add(&priv->tags, tag))
         return;
 
-    g_tree_insert(priv->tags,
-                  g_string_chunk_insert_const(priv->chunk, tag), NULL);
-
     g_object_notify_by_pspec(G_OBJECT(item), obj_properties[PROP_TAGS]);
 }
 
-struct _foreach_data {
-    MalgtkSetForeachFunc cb;
-    gpointer user_data;
-};
-
-static gboolean
-_foreach_cb(gpointer key,
-            gpointer value __attribute__((unused)),
-            gpointer data)
+static void
+_foreach_str(const MalgtkStringSet *set,
+             MalgtkSetForeachFunc cb,
+             gpointer user_data)
 {
-    struct _foreach_data *bkt = data;
-    return bkt->cb(key, bkt->user_data);
+    for (guint i = 0; i < set->len; ++i) {
+        if (cb(set->strs[i], user_data))
+            break;
+    }
 }
 
 void
@@ -797,12 +731,11 @@ malgtk_malitem_foreach_synonym(const MalgtkMalitem *item,
                                MalgtkSetForeachFunc cb,
                                gpointer user_data)
 {
-    MalgtkMalitemPrivate *priv;
-    struct _foreach_data data = {cb, user_data};
+    const MalgtkMalitemPrivate *priv;
     g_return_if_fail(MALGTK_IS_MALITEM((MalgtkMalitem*)item));
 
-    priv = malgtk_malitem_get_instance_private ((MalgtkMalitem*)item);
-    g_tree_foreach (priv->series_synonyms, _foreach_cb, &data);
+    priv = malgtk_malitem_get_instance_private_const (item);
+    _foreach_str(&priv->series_synonyms, cb, user_data);
 }
 
 void
@@ -810,164 +743,95 @@ malgtk_malitem_foreach_tag(const MalgtkMalitem *item,
                            MalgtkSetForeachFunc cb,
                            gpointer user_data)
 {
-    MalgtkMalitemPrivate *priv;
-    struct _foreach_data data = {cb, user_data};
+    const MalgtkMalitemPrivate *priv;
     g_return_if_fail(MALGTK_IS_MALITEM((MalgtkMalitem*)item));
-    priv = malgtk_malitem_get_instance_private ((MalgtkMalitem*)item);
-    g_tree_foreach (priv->tags, _foreach_cb, &data);
-}
 
-static gboolean
-_tree_to_gstrv_cb(gpointer key,
-                  gpointer value __attribute__((unused)),
-                  gpointer data)
-{
-    gchar ***strvp = data;
-    **strvp = g_strdup(key);
-    ++*strvp;
-    return FALSE;
-}
-
-static gchar **
-_tree_to_gstrv(GTree *tree)
-{
-    gchar **strv = g_malloc(sizeof(gchar*) * (g_tree_nnodes(tree)+1));
-    gchar **res = strv;
-    g_tree_foreach (tree, _tree_to_gstrv_cb, &strv);
-    *strv = NULL;
-    return res;
-}
-
-static void _tree_remove_all(GTree *tree)
-{
-    g_tree_ref (tree);
-    g_tree_destroy (tree);
-}
-
-static gboolean
-xform_reconsume_value_enum(GValue *value,
-                           const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_MALITEM_RECONSUME_VALUE, in);
-}
-
-static gboolean
-xform_priority_enum(GValue *value,
-                    const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_MALITEM_PRIORITY, in);
-}
-
-
-static gboolean
-xform_string(GValue *value,
-             const xmlChar* in)
-{
-    g_value_init(value, G_TYPE_STRING);
-    g_value_set_static_string(value, (const char*)in);
-    return FALSE;
+    priv = malgtk_malitem_get_instance_private_const (item);
+    _foreach_str(&priv->tags, cb, user_data);
 }
 
-static const struct {
-    const xmlChar *xml_name;
-    gint prop_id;
-    gboolean (*xform)(GValue *out, const xmlChar* in);
-} field_map[] = {
-    { BAD_CAST"MALitem",                -1,                          NULL},
-    { BAD_CAST"series_itemdb_id",       PROP_SERIES_MALDB_ID,        xform_gint64},
-    { BAD_CAST"series_title",           PROP_SERIES_TITLE,           xform_string},
-    { BAD_CAST"series_preferred_title", PROP_SERIES_PREFERRED_TITLE, xform_string},
-    { BAD_CAST"series_date_begin",      PROP_SERIES_DATE_BEGIN,      xform_string},
-    { BAD_CAST"series_date_end",        PROP_SERIES_DATE_END,        xform_string},
-    { BAD_CAST"image_url",              PROP_IMAGE_URL,              xform_string},
-    { BAD_CAST"series_synonyms",        -1,                          xform_string},
-    { BAD_CAST"series_synonym",         PROP_SERIES_SYNONYM,         xform_string},
-    { BAD_CAST"series_synopsis",        PROP_SERIES_SYNOPSIS,        xform_string},
-    { BAD_CAST"tags",                   -1,                          xform_string},
-    { BAD_CAST"tag",                    PROP_TAGS,                   xform_string},
-    { BAD_CAST"date_finish",            PROP_DATE_FINISH,            xform_gdate},
-    { BAD_CAST"date_start",             PROP_DATE_START,             xform_gdate},
-    { BAD_CAST"id",                     PROP_ID,                     xform_gint64},
-    { BAD_CAST"last_updated",           PROP_LAST_UPDATED,           xform_datetime},
-    { BAD_CAST"score",                  PROP_SCORE,                  xform_gdouble},
-    { BAD_CAST"enable_reconsuming",     PROP_ENABLE_RECONSUMING,     xform_gint64},
-    { BAD_CAST"fansub_group",           PROP_FANSUB_GROUP,           xform_string},
-    { BAD_CAST"comments",               PROP_COMMENTS,               xform_string},
-    { BAD_CAST"downloaded_items",       PROP_DOWNLOADED_ITEMS,       xform_gint64},
-    { BAD_CAST"times_consumed",         PROP_TIMES_CONSUMED,         xform_gint64},
-    { BAD_CAST"reconsume_value",        PROP_RECONSUME_VALUE,        xform_reconsume_value_enum},
-    { BAD_CAST"priority",               PROP_PRIORITY,               xform_priority_enum},
-    { BAD_CAST"enable_discussion",      PROP_ENABLE_DISCUSSION,      xform_gint64},
-    { BAD_CAST"has_details",            PROP_HAS_DETAILS,            xform_gint64},
-};
+static GOnce s_defs_once = G_ONCE_INIT;
+static struct malgtk_xml_serialization_defs s_defs[N_PROPERTIES] = { 0 };
+static GHashTable *s_defs_index;
+static MalgtkXmlPlan *s_plan;
+static MalgtkVariantPlan *s_variant_plan;
+static GVariantType *s_variant_type;
+static void* _init_s_defs(void* v);
 
-static gint
-find_field_for_name(const xmlChar *name)
+static void
+_notify_changed(MalgtkMalitem *malitem,
+                guint64 changed)
 {
-    for (size_t i = 0; i < G_N_ELEMENTS(field_map); ++i)
-    {
-        if (xmlStrEqual(field_map[i].xml_name, name)) {
-            return i;
-        }
-    }
+    if (changed & MALGTK_XML_PROP_BIT(PROP_SERIES_DATE_BEGIN))
+        changed |= MALGTK_XML_PROP_BIT(PROP_SEASON_BEGIN);
+    if (changed & MALGTK_XML_PROP_BIT(PROP_SERIES_DATE_END))
+        changed |= MALGTK_XML_PROP_BIT(PROP_SEASON_END);
 
-    return -1;
+    malgtk_xml_notify_changed (G_OBJECT (malitem), obj_properties, changed);
 }
 
-void
-malgtk_malitem_set_from_xml(MalgtkMalitem *malitem,
-                            xmlTextReaderPtr reader)
+/* Returns the MALGTK_XML_PROP_BITs of what changed */
+static guint64
+_read_xml(MalgtkMalitem *malitem,
+          xmlTextReaderPtr reader)
 {
-    gint offset = -1;
-    GValue value = G_VALUE_INIT;
-    gboolean is_default;
-    g_return_if_fail(MALGTK_IS_MALITEM((MalgtkMalitem*)malitem));
+    MalgtkMalitemPrivate *priv;
+    const struct malgtk_xml_serialization_defs *def = NULL;
+    const xmlChar *name;
+    const xmlChar *value;
+    guint64 changed = 0;
 
-    g_object_freeze_notify (G_OBJECT (malitem));
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    priv = malgtk_malitem_get_instance_private (malitem);
 
-    for (; !(xmlStrEqual(BAD_CAST"MALitem", xmlTextReaderConstName(reader)) &&
-             xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT);
-         xmlTextReaderRead(reader))
+    while (!(xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT &&
+             xmlStrEqual(BAD_CAST"MALitem", xmlTextReaderConstName(reader))))
     {
         switch (xmlTextReaderNodeType(reader))
         {
             case XML_READER_TYPE_ELEMENT:
-                offset = find_field_for_name(xmlTextReaderConstName(reader));
-                if (-1 == offset) {
-                    g_warning("Unexpected field: %s", (const char*)xmlTextReaderConstName(reader));
+                name = xmlTextReaderConstName(reader);
+                if (!g_hash_table_lookup_extended(s_defs_index, name, NULL, (gpointer*)&def)) {
+                    g_warning("Unexpected field: %s", (const char*)name);
+                    def = NULL;
                 }
                 break;
             case XML_READER_TYPE_TEXT:
-                switch (field_map[offset].prop_id) {
-                    case -1:
-                        break;
-                    case PROP_TAGS:
-                        malgtk_malitem_add_tag(malitem, (const char*)xmlTextReaderConstValue(reader));
-                        break;
-                    case PROP_SERIES_SYNONYM:
-                        malgtk_malitem_add_synonym(malitem, (const char*)xmlTextReaderConstValue(reader));
-                        break;
-                    default:
-                        is_default = field_map[offset].xform(&value,
-                                                             xmlTextReaderConstValue(reader));
-                        if (!is_default) {
-                            g_object_set_property(G_OBJECT(malitem),
-                                                  obj_properties[field_map[offset].prop_id]->name, &value);
-                            g_value_unset(&value);
-                        }
-                        break;
-                }
+                if (NULL == def)
+                    break;
+                value = xmlTextReaderConstValue(reader);
+                if (malgtk_xml_deserialize(def, priv, value))
+                    changed |= MALGTK_XML_PROP_BIT(def->prop_id);
+                break;
+            case XML_READER_TYPE_END_ELEMENT:
+                def = NULL;
                 break;
             default:
                 break;
         }
+
+        if (1 != xmlTextReaderRead(reader))
+            break;
     }
 
-    g_object_thaw_notify (G_OBJECT (malitem));
+    return changed;
 }
 
-static GOnce s_defs_once = G_ONCE_INIT;
-static struct malgtk_xml_serialization_defs s_defs[N_PROPERTIES] = { 0 };
+void
+malgtk_malitem_set_from_xml(MalgtkMalitem *malitem,
+                            xmlTextReaderPtr reader)
+{
+    g_return_if_fail(MALGTK_IS_MALITEM((MalgtkMalitem*)malitem));
+
+    _notify_changed (malitem, _read_xml (malitem, reader));
+}
+
+static void
+malgtk_malitem_real_load_xml(MalgtkMalitem *malitem,
+                             xmlTextReaderPtr reader)
+{
+    _read_xml (malitem, reader);
+}
 
 static void*
 _init_s_defs(void* v)
@@ -992,13 +856,13 @@ _init_s_defs(void* v)
         G_TYPE_GSTRING, PROP_IMAGE_URL, "image-url", "image_url",
         NULL, offsetof(MalgtkMalitemPrivate, image_url), 0 };
     s_defs[6] = (struct malgtk_xml_serialization_defs){
-        G_TYPE_TREE, PROP_SERIES_SYNONYM, "series-synonyms", "series_synonyms",
+        MALGTK_TYPE_STRING_SET, PROP_SERIES_SYNONYM, "series-synonyms", "series_synonyms",
         "series_synonym", offsetof(MalgtkMalitemPrivate, series_synonyms), 0 };
     s_defs[7] = (struct malgtk_xml_serialization_defs){
         G_TYPE_GSTRING, PROP_SERIES_SYNOPSIS, "series-synopsis", "series_synopsis",
         NULL, offsetof(MalgtkMalitemPrivate, synopsis), 0 };
     s_defs[8] = (struct malgtk_xml_serialization_defs){
-        G_TYPE_TREE, PROP_TAGS, "tags", "tags",
+        MALGTK_TYPE_STRING_SET, PROP_TAGS, "tags", "tags",
         "tag", offsetof(MalgtkMalitemPrivate, tags), 0 };
     s_defs[9] = (struct malgtk_xml_serialization_defs){
         G_TYPE_DATE, PROP_DATE_START, "date-start", "date_start",
@@ -1035,19 +899,28 @@ _init_s_defs(void* v)
 
     s_defs[19] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_MALITEM_RECONSUME_VALUE, PROP_RECONSUME_VALUE, "reconsume-value", "reconsume_value",
-        NULL, offsetof(MalgtkMalitemPrivate, reconsume_value), sizeof(MalgtkMalitemReconsumeValue) };
+        NULL, offsetof(MalgtkMalitemPrivate, reconsume_value), sizeof(MalgtkMalitemReconsumeValue),
+        malgtk_malitem_reconsume_value_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkMalitemPriority);
 
     s_defs[20] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_MALITEM_PRIORITY, PROP_PRIORITY, "priority", "priority",
-        NULL, offsetof(MalgtkMalitemPrivate, priority), sizeof(MalgtkMalitemPriority) };
+        NULL, offsetof(MalgtkMalitemPrivate, priority), sizeof(MalgtkMalitemPriority),
+        malgtk_malitem_priority_get_table() };
     s_defs[21] = (struct malgtk_xml_serialization_defs){
         G_TYPE_BOOLEAN, PROP_ENABLE_DISCUSSION, "enable-discussion", "enable_discussion",
         NULL, offsetof(MalgtkMalitemPrivate, enable_discussion), 0 };
     s_defs[22] = (struct malgtk_xml_serialization_defs){
         G_TYPE_BOOLEAN, PROP_HAS_DETAILS, "has-details", "has_details",
         NULL, offsetof(MalgtkMalitemPrivate, has_details), 0 };
+
+    s_defs_index = malgtk_xml_defs_index_new(s_defs, "MALitem");
+    s_plan       = malgtk_xml_plan_new(s_defs);
+
+    s_variant_plan = malgtk_variant_plan_new(s_defs);
+    s_variant_type = g_variant_type_new_tuple(
+        (const GVariantType * const []){ malgtk_variant_plan_get_type(s_variant_plan) }, 1);
     return NULL;
 }
 
@@ -1062,7 +935,80 @@ malgtk_malitem_get_xml(const MalgtkMalitem *malitem,
     xmlTextWriterStartElement(writer, BAD_CAST"MALitem");
     xmlTextWriterWriteAttribute(writer, BAD_CAST"version", BAD_CAST"1");
 
-    malgtk_xml_serialize(writer, s_defs, priv);
+    malgtk_xml_serialize(writer, s_plan, priv);
 
     xmlTextWriterEndElement(writer); /* MALitem */
 }
+
+static const GVariantType *
+malgtk_malitem_real_get_variant_type(void)
+{
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    return s_variant_type;
+}
+
+static guint32
+malgtk_malitem_real_get_variant_schema(void)
+{
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    return malgtk_variant_plan_get_schema(s_variant_plan);
+}
+
+static GVariant *
+malgtk_malitem_real_get_variant(const MalgtkMalitem *malitem)
+{
+    GVariant *fields;
+
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    fields = malgtk_variant_serialize(s_variant_plan, malgtk_malitem_get_instance_private_const (malitem));
+    return g_variant_new_tuple(&fields, 1);
+}
+
+static void
+malgtk_malitem_real_set_from_variant(MalgtkMalitem *malitem,
+                                     GVariant *variant)
+{
+    g_autoptr(GVariant) fields = NULL;
+
+    g_once (&s_defs_once, _init_s_defs, NULL);
+
+    /* Reads only the first child, so subclasses pass their whole
+     * variant along */
+    fields = g_variant_get_child_value(variant, 0);
+    _notify_changed (malitem, malgtk_variant_deserialize(s_variant_plan,
+                                                         malgtk_malitem_get_instance_private (malitem),
+                                                         fields));
+}
+
+/* Returns a floating reference */
+GVariant *
+malgtk_malitem_get_variant(const MalgtkMalitem *malitem)
+{
+    g_return_val_if_fail (MALGTK_IS_MALITEM((MalgtkMalitem*)malitem), NULL);
+    return MALGTK_MALITEM_GET_CLASS (malitem)->get_variant (malitem);
+}
+
+void
+malgtk_malitem_set_from_variant(MalgtkMalitem *malitem,
+                                GVariant *variant)
+{
+    MalgtkMalitemClass *klass;
+
+    g_return_if_fail (MALGTK_IS_MALITEM(malitem));
+
+    klass = MALGTK_MALITEM_GET_CLASS (malitem);
+    g_return_if_fail (g_variant_is_of_type (variant, klass->get_variant_type ()));
+
+    klass->set_from_variant (malitem, variant);
+}
+
+/* mal-db-id is the first field of the first child, whatever the
+ * item's class, so a list can be indexed without loading its items */
+gint64
+malgtk_malitem_variant_get_mal_db_id(GVariant *variant)
+{
+    g_autoptr(GVariant) fields = g_variant_get_child_value(variant, 0);
+    g_autoptr(GVariant) id     = g_variant_get_child_value(fields, 0);
+
+    return g_variant_get_int64(id);
+}
@@ -47,16 +47,36 @@ G_DECLARE_DERIVABLE_TYPE(MalgtkMalitem, malgtk_malitem, MALGTK, MALITEM, GObject
 struct _MalgtkMalitemClass
 {
     GObjectClass  parent_class;
+
+    /* An item's variant is a tuple with one child for each class in
+     * its hierarchy, MalgtkMalitem's first, holding that class' fields
+     * as laid out in malgtk_variant.h. Subclasses chain up for the
+     * children before their own, and fold their plan's schema into
+     * their parent's, so that files can tell which fields they hold. */
+    const GVariantType* (*get_variant_type) (void);
+    guint32             (*get_variant_schema) (void);
+    GVariant*           (*get_variant)      (const MalgtkMalitem *item);
+    void                (*set_from_variant) (MalgtkMalitem *item, GVariant *variant);
+
+    /* The element an item is read from, and set_from_xml without the
+     * notifications, for items nothing can be watching yet. The reader
+     * is on the item's element and is left on its end. */
+    const gchar        *xml_name;
+    void                (*load_xml)         (MalgtkMalitem *item, xmlTextReaderPtr reader);
 };
 
 typedef gboolean (*MalgtkSetForeachFunc)(const gchar *str, gpointer user_data);
 
 MalgtkMalitem *malgtk_malitem_new (void);
+gint64         malgtk_malitem_get_mal_db_id(const MalgtkMalitem *item);
 void           malgtk_malitem_add_synonym(MalgtkMalitem *item, const gchar *synonym);
 void           malgtk_malitem_foreach_synonym(const MalgtkMalitem *item, MalgtkSetForeachFunc cb, gpointer user_data);
 void           malgtk_malitem_add_tag(MalgtkMalitem *item, const gchar *synonym);
 void           malgtk_malitem_foreach_tag(const MalgtkMalitem *item, MalgtkSetForeachFunc cb, gpointer user_data);
 void           malgtk_malitem_set_from_xml(MalgtkMalitem *item, xmlTextReaderPtr reader);
 void           malgtk_malitem_get_xml(const MalgtkMalitem *item, xmlTextWriterPtr writer);
+GVariant      *malgtk_malitem_get_variant(const MalgtkMalitem *item);
+void           malgtk_malitem_set_from_variant(MalgtkMalitem *item, GVariant *variant);
+gint64         malgtk_malitem_variant_get_mal_db_id(GVariant *variant);
 
 G_END_DECLS
@@ -17,8 +17,8 @@
 
 #include "malgtk_manga.h"
 #include "malgtk_enumtypes.h"
-#include "malgtk_deserialize_v1_tools.h"
 #include "malgtk_xml.h"
+#include "malgtk_variant.h"
 
 typedef struct _MalgtkManga MalgtkManga;
 
@@ -203,14 +203,28 @@ malgtk_manga_get_property (GObject    *object,
 }
 
 
+static const GVariantType *malgtk_manga_get_variant_type (void);
+static guint32             malgtk_manga_get_variant_schema (void);
+static GVariant           *malgtk_manga_get_variant      (const MalgtkMalitem *item);
+static void                malgtk_manga_set_from_variant (MalgtkMalitem *item, GVariant *variant);
+static void                malgtk_manga_load_xml         (MalgtkMalitem *item, xmlTextReaderPtr reader);
+
 static void
 malgtk_manga_class_init (MalgtkMangaClass *klass)
 {
     GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    MalgtkMalitemClass *malitem_class = MALGTK_MALITEM_CLASS (klass);
 
     gobject_class->set_property = malgtk_manga_set_property;
     gobject_class->get_property = malgtk_manga_get_property;
 
+    malitem_class->get_variant_type   = malgtk_manga_get_variant_type;
+    malitem_class->get_variant_schema = malgtk_manga_get_variant_schema;
+    malitem_class->get_variant        = malgtk_manga_get_variant;
+    malitem_class->set_from_variant   = malgtk_manga_set_from_variant;
+    malitem_class->xml_name           = "manga";
+    malitem_class->load_xml           = malgtk_manga_load_xml;
+
     obj_properties[PROP_SERIES_TYPE] =
         g_param_spec_enum ("series-type",
                            "Series Type",
@@ -314,123 +328,99 @@ malgtk_manga_new(void)
     return g_object_new(MALGTK_TYPE_MANGA, NULL);
 }
 
-static gboolean
-xform_series_type_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_MANGA_SERIES_TYPE, in);
-}
-
-static gboolean
-xform_series_status_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_MANGA_SERIES_STATUS, in);
-}
-
-static gboolean
-xform_status_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_MANGA_STATUS, in);
-}
-
-static gboolean
-xform_storage_type_enum(GValue *value, const xmlChar *in)
-{
-    return xform_enum(value, MALGTK_TYPE_MANGA_STORAGE_TYPE, in);
-}
-
-static const struct {
-    const xmlChar *xml_name;
-    gint prop_id;
-    gboolean (*xform)(GValue *out, const xmlChar* in);
-} field_map[] = {
-    {BAD_CAST"MALitem",           -1,                     NULL},
-    {BAD_CAST"manga",             -1,                     NULL},
-    {BAD_CAST"series_type",       PROP_SERIES_TYPE,       xform_series_type_enum},
-    {BAD_CAST"series_status",     PROP_SERIES_STATUS,     xform_series_status_enum},
-    {BAD_CAST"series_chapters",   PROP_SERIES_CHAPTERS,   xform_gint64},
-    {BAD_CAST"series_volumes",    PROP_SERIES_VOLUMES,    xform_gint64},
-    {BAD_CAST"status",            PROP_STATUS,            xform_status_enum},
-    {BAD_CAST"chapters",          PROP_CHAPTERS,          xform_gint64},
-    {BAD_CAST"volumes",           PROP_VOLUMES,           xform_gint64},
-    {BAD_CAST"rereading_chapter", PROP_REREADING_CHAPTER, xform_gint64},
-    {BAD_CAST"retail_volumes",    PROP_RETAIL_VOLUMES,    xform_gint64},
-    {BAD_CAST"storage_type",      PROP_STORAGE_TYPE,      xform_storage_type_enum},
-};
-
-static gint
-find_field_for_name(const xmlChar *name)
+static GOnce s_defs_once = G_ONCE_INIT;
+static struct malgtk_xml_serialization_defs s_defs[N_PROPERTIES] = { 0 };
+static GHashTable *s_defs_index;
+static MalgtkXmlPlan *s_plan;
+static MalgtkVariantPlan *s_variant_plan;
+static GVariantType *s_variant_type;
+static void* _init_s_defs(void* v);
+
+/* Returns the MALGTK_XML_PROP_BITs of what changed. The MALitem part
+ * notifies its own changes unless load is set, when nothing does. */
+static guint64
+_read_xml(MalgtkManga *manga, xmlTextReaderPtr reader, gboolean load)
 {
-    for (size_t i = 0; i < G_N_ELEMENTS(field_map); ++i)
-    {
-        if (xmlStrEqual(field_map[i].xml_name, name)) {
-            return i;
-        }
-    }
+    MalgtkMangaPrivate *priv;
+    const struct malgtk_xml_serialization_defs *def = NULL;
+    const xmlChar *element;
+    guint64 changed = 0;
 
-    return -1;
-}
-
-void
-malgtk_manga_set_from_xml(MalgtkManga *manga, xmlTextReaderPtr reader)
-{
-    gint offset = -1;
-    GValue value = G_VALUE_INIT;
-    gboolean is_default;
-    g_return_if_fail(MALGTK_IS_MANGA(manga));
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    priv = malgtk_manga_get_instance_private (manga);
 
-    for (; !(xmlStrEqual(BAD_CAST"manga", xmlTextReaderConstName(reader)) &&
-             xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT);
-         xmlTextReaderRead(reader))
+    while (!(xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT &&
+             xmlStrEqual(BAD_CAST"manga", xmlTextReaderConstName(reader))))
     {
         switch (xmlTextReaderNodeType(reader))
         {
             case XML_READER_TYPE_ELEMENT:
-                offset = find_field_for_name(xmlTextReaderConstName(reader));
-                if (-1 == offset) {
-                    g_warning("Unexpected field: %s", (const char*)xmlTextReaderConstName(reader));
-                }
-                if (0 == offset) {
-                    malgtk_malitem_set_from_xml (MALGTK_MALITEM(manga), reader);
-                    break;
+                element = xmlTextReaderConstName(reader);
+                def = NULL;
+                if (xmlStrEqual(BAD_CAST"MALitem", element)) {
+                    if (load)
+                        MALGTK_MALITEM_CLASS (malgtk_manga_parent_class)->load_xml (MALGTK_MALITEM(manga), reader);
+                    else
+                        malgtk_malitem_set_from_xml (MALGTK_MALITEM(manga), reader);
+                } else if (!g_hash_table_lookup_extended(s_defs_index, element, NULL, (gpointer*)&def)) {
+                    g_warning("Unexpected field: %s", (const char*)element);
+                    def = NULL;
                 }
                 break;
             case XML_READER_TYPE_TEXT:
-                switch (field_map[offset].prop_id) {
-                    case -1:
-                        break;
-                    default:
-                        is_default = field_map[offset].xform(&value,
-                                                             xmlTextReaderConstValue(reader));
-                        if (!is_default) {
-                            g_object_set_property(G_OBJECT(manga),
-                                                  obj_properties[field_map[offset].prop_id]->name, &value);
-                            g_value_unset(&value);
-                        }
-                        break;
-                }
+                if (def && malgtk_xml_deserialize(def, priv, xmlTextReaderConstValue(reader)))
+                    changed |= MALGTK_XML_PROP_BIT(def->prop_id);
+                break;
+            case XML_READER_TYPE_END_ELEMENT:
+                def = NULL;
                 break;
             default:
                 break;
         }
+
+        if (1 != xmlTextReaderRead(reader))
+            break;
     }
 
+    return changed;
+}
+
+void
+malgtk_manga_set_from_xml(MalgtkManga *manga, xmlTextReaderPtr reader)
+{
+    guint64 changed;
+    g_return_if_fail(MALGTK_IS_MANGA(manga));
+
+    /* The MALitem part notifies when this does */
+    g_object_freeze_notify (G_OBJECT (manga));
+
+    changed = _read_xml (manga, reader, FALSE);
+
+    malgtk_xml_notify_changed (G_OBJECT (manga), obj_properties, changed);
+    g_object_thaw_notify (G_OBJECT (manga));
+}
+
+static void
+malgtk_manga_load_xml(MalgtkMalitem *item, xmlTextReaderPtr reader)
+{
+    _read_xml (MALGTK_MANGA (item), reader, TRUE);
 }
 
-static GOnce s_defs_once = G_ONCE_INIT;
-static struct malgtk_xml_serialization_defs s_defs[N_PROPERTIES] = { 0 };
 static void*
 _init_s_defs(void* v)
 {
     (void)v;
     s_defs[0] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_MANGA_SERIES_TYPE, PROP_SERIES_TYPE, "series-type", "series_type",
-        NULL, offsetof(MalgtkMangaPrivate, series_type), sizeof(MalgtkMangaSeriesType) };
+        NULL, offsetof(MalgtkMangaPrivate, series_type), sizeof(MalgtkMangaSeriesType),
+        malgtk_manga_series_type_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkMangaSeriesType);
 
     s_defs[1] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_MANGA_SERIES_STATUS, PROP_SERIES_STATUS, "series-status", "series_status",
-        NULL, offsetof(MalgtkMangaPrivate, series_status), sizeof(MalgtkMangaSeriesStatus) };
+        NULL, offsetof(MalgtkMangaPrivate, series_status), sizeof(MalgtkMangaSeriesStatus),
+        malgtk_manga_series_status_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkMangaSeriesStatus);
 
@@ -444,7 +434,8 @@ _init_s_defs(void* v)
 
     s_defs[4] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_MANGA_STATUS, PROP_STATUS, "status", "status",
-        NULL, offsetof(MalgtkMangaPrivate, series_status), sizeof(MalgtkMangaStatus) };
+        NULL, offsetof(MalgtkMangaPrivate, status), sizeof(MalgtkMangaStatus),
+        malgtk_manga_status_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkMangaStatus);
 
@@ -466,10 +457,21 @@ _init_s_defs(void* v)
 
     s_defs[9] = (struct malgtk_xml_serialization_defs){
         MALGTK_TYPE_MANGA_STORAGE_TYPE, PROP_STORAGE_TYPE, "storage-type", "storage_type",
-        NULL, offsetof(MalgtkMangaPrivate, storage_type), sizeof(MalgtkMangaStorageType) };
+        NULL, offsetof(MalgtkMangaPrivate, storage_type), sizeof(MalgtkMangaStorageType),
+        malgtk_manga_storage_type_get_table() };
 
     MALGTK_ENUM_IS_SERIALIZABLE(MalgtkMangaStorageType);
 
+    s_defs_index = malgtk_xml_defs_index_new(s_defs, "manga");
+    s_plan       = malgtk_xml_plan_new(s_defs);
+
+    /* The MALitem fields, then ours */
+    s_variant_plan = malgtk_variant_plan_new(s_defs);
+    s_variant_type = g_variant_type_new_tuple(
+        (const GVariantType * const []){
+            g_variant_type_first(MALGTK_MALITEM_CLASS (malgtk_manga_parent_class)->get_variant_type ()),
+            malgtk_variant_plan_get_type(s_variant_plan) }, 2);
+
     return NULL;
 }
 
@@ -485,8 +487,66 @@ malgtk_manga_get_xml(const MalgtkManga *manga,
     xmlTextWriterWriteAttribute(writer, BAD_CAST"version", BAD_CAST"1");
     malgtk_malitem_get_xml(MALGTK_MALITEM((MalgtkManga*)manga), writer);
 
-    malgtk_xml_serialize(writer, s_defs, priv);
+    malgtk_xml_serialize(writer, s_plan, priv);
 
     xmlTextWriterEndElement(writer); /* manga */
 
 }
+
+static const GVariantType *
+malgtk_manga_get_variant_type(void)
+{
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    return s_variant_type;
+}
+
+static guint32
+malgtk_manga_get_variant_schema(void)
+{
+    g_once (&s_defs_once, _init_s_defs, NULL);
+    return MALGTK_MALITEM_CLASS (malgtk_manga_parent_class)->get_variant_schema () * 31 +
+        malgtk_variant_plan_get_schema(s_variant_plan);
+}
+
+static GVariant *
+malgtk_manga_get_variant(const MalgtkMalitem *item)
+{
+    g_autoptr(GVariant) malitem = NULL;
+    GVariant *children[2];
+    GVariant *variant;
+
+    g_once (&s_defs_once, _init_s_defs, NULL);
+
+    malitem     = g_variant_ref_sink (MALGTK_MALITEM_CLASS (malgtk_manga_parent_class)->get_variant (item));
+    children[0] = g_variant_get_child_value (malitem, 0);
+    children[1] = malgtk_variant_serialize (s_variant_plan,
+                                            malgtk_manga_get_instance_private_const (MALGTK_MANGA ((MalgtkMalitem*)item)));
+    variant     = g_variant_new_tuple (children, 2);
+
+    /* Only the new child was floating */
+    g_variant_unref (children[0]);
+    return variant;
+}
+
+static void
+malgtk_manga_set_from_variant(MalgtkMalitem *item,
+                              GVariant *variant)
+{
+    g_autoptr(GVariant) fields = NULL;
+    guint64 changed;
+
+    g_once (&s_defs_once, _init_s_defs, NULL);
+
+    /* The MALitem part notifies when this does */
+    g_object_freeze_notify (G_OBJECT (item));
+
+    MALGTK_MALITEM_CLASS (malgtk_manga_parent_class)->set_from_variant (item, variant);
+
+    fields  = g_variant_get_child_value (variant, 1);
+    changed = malgtk_variant_deserialize (s_variant_plan,
+                                          malgtk_manga_get_instance_private (MALGTK_MANGA (item)),
+                                          fields);
+
+    malgtk_xml_notify_changed (G_OBJECT (item), obj_properties, changed);
+    g_object_thaw_notify (G_OBJECT (item));
+}
@@ -0,0 +1,60 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Season keys, shared with the application's MAL::ItemDate, which is
+ * also built without libmalgtk; so everything here is inline.
+ *
+ * A key is the year shifted up by MALGTK_SEASON_BITS over the season,
+ * 1 for Winter through 4 for Autumn, or 0 when only the year is
+ * known. Keys order dates by season, those with only a year ahead of
+ * that year's seasons. December is the next year's winter. The key
+ * is 0 when the year is unknown. */
+#define MALGTK_SEASON_BITS 3
+
+static inline guint32
+malgtk_season_key(guint year, guint month)
+{
+    static const guint8 month_seasons[] = { 0, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 1 };
+    guint32 season;
+
+    if (0 == year)
+        return 0;
+
+    season = month <= 12 ? month_seasons[month] : 0;
+    return (guint32)(year + (12 == month)) << MALGTK_SEASON_BITS | season;
+}
+
+/* "Winter" and so on, or NULL for a key without a season */
+static inline const gchar*
+malgtk_season_key_get_name(guint32 season_key)
+{
+    static const gchar * const season_names[] = { NULL, "Winter", "Spring", "Summer", "Autumn", NULL, NULL, NULL };
+    return season_names[season_key & ((1 << MALGTK_SEASON_BITS) - 1)];
+}
+
+static inline guint
+malgtk_season_key_get_year(guint32 season_key)
+{
+    return season_key >> MALGTK_SEASON_BITS;
+}
+
+G_END_DECLS
@@ -0,0 +1,159 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "malgtk_string_set.h"
+#include <string.h>
+
+G_DEFINE_BOXED_TYPE (MalgtkStringSet, malgtk_string_set,
+                     malgtk_string_set_copy,
+                     malgtk_string_set_free)
+
+MalgtkStringSet*
+malgtk_string_set_new(void)
+{
+    return g_new0 (MalgtkStringSet, 1);
+}
+
+MalgtkStringSet*
+malgtk_string_set_copy(const MalgtkStringSet *set)
+{
+    MalgtkStringSet *s = g_new0 (MalgtkStringSet, 1);
+
+    if (set->len > 0) {
+        s->strs  = g_new (const gchar*, set->len);
+        memcpy (s->strs, set->strs, set->len * sizeof (const gchar*));
+        s->len   = set->len;
+        s->alloc = set->len;
+    }
+
+    return s;
+}
+
+void
+malgtk_string_set_free(MalgtkStringSet *set)
+{
+    malgtk_string_set_clear (set);
+    g_free (set);
+}
+
+void
+malgtk_string_set_clear(MalgtkStringSet *set)
+{
+    g_free (set->strs);
+    set->strs  = NULL;
+    set->len   = 0;
+    set->alloc = 0;
+}
+
+/* Returns TRUE if str wasn't already in the set */
+gboolean
+malgtk_string_set_add(MalgtkStringSet *set,
+                      const gchar *str)
+{
+    const gchar *interned;
+    guint lo = 0, hi = set->len;
+
+    g_return_val_if_fail(NULL != str, FALSE);
+
+    interned = g_intern_string (str);
+    for (guint i = 0; i < set->len; ++i) {
+        if (set->strs[i] == interned)
+            return FALSE;
+    }
+
+    /* Collation is only needed to place a new string */
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_utf8_collate (set->strs[mid], interned) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (set->len == set->alloc) {
+        set->alloc = set->alloc ? set->alloc * 2 : 4;
+        set->strs  = g_renew (const gchar*, set->strs, set->alloc);
+    }
+
+    memmove (set->strs + lo + 1, set->strs + lo, (set->len - lo) * sizeof (const gchar*));
+    set->strs[lo] = interned;
+    ++set->len;
+
+    return TRUE;
+}
+
+gboolean
+malgtk_string_set_contains(const MalgtkStringSet *set,
+                           const gchar *str)
+{
+    const gchar *interned;
+    GQuark quark;
+
+    /* A string that was never interned is in no set */
+    quark = g_quark_try_string (str);
+    if (0 == quark)
+        return FALSE;
+
+    interned = g_quark_to_string (quark);
+    for (guint i = 0; i < set->len; ++i) {
+        if (set->strs[i] == interned)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+gboolean
+malgtk_string_set_is_equal(const MalgtkStringSet *a,
+                           const MalgtkStringSet *b)
+{
+    return a->len == b->len &&
+        (0 == a->len || 0 == memcmp (a->strs, b->strs, a->len * sizeof (const gchar*)));
+}
+
+/* Replaces the contents of set with strv, which may be NULL or hold
+ * duplicates. Returns TRUE if that changed the set. */
+gboolean
+malgtk_string_set_assign_strv(MalgtkStringSet *set,
+                              const gchar * const *strv)
+{
+    MalgtkStringSet s = MALGTK_STRING_SET_INIT;
+
+    for (; NULL != strv && NULL != *strv; ++strv)
+        malgtk_string_set_add (&s, *strv);
+
+    if (malgtk_string_set_is_equal (set, &s)) {
+        malgtk_string_set_clear (&s);
+        return FALSE;
+    }
+
+    malgtk_string_set_clear (set);
+    *set = s;
+    return TRUE;
+}
+
+gchar**
+malgtk_string_set_to_strv(const MalgtkStringSet *set)
+{
+    gchar **strv = g_new (gchar*, set->len + 1);
+
+    for (guint i = 0; i < set->len; ++i)
+        strv[i] = g_strdup (set->strs[i]);
+    strv[set->len] = NULL;
+
+    return strv;
+}
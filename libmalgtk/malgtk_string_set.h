@@ -0,0 +1,54 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* A small set of strings, kept sorted by g_utf8_collate() in one
+ * array. The strings are interned with g_intern_string(), so every set
+ * holding the same string shares one copy and membership is a pointer
+ * comparison. An empty set allocates nothing; zero-filled memory, or
+ * MALGTK_STRING_SET_INIT, is an empty set.
+ */
+typedef struct _MalgtkStringSet
+{
+    const gchar **strs;
+    guint len;
+    guint alloc;
+} MalgtkStringSet;
+
+#define MALGTK_STRING_SET_INIT { NULL, 0, 0 }
+
+#define MALGTK_TYPE_STRING_SET malgtk_string_set_get_type()
+
+GType            malgtk_string_set_get_type    (void);
+MalgtkStringSet* malgtk_string_set_new         (void);
+MalgtkStringSet* malgtk_string_set_copy        (const MalgtkStringSet *set);
+void             malgtk_string_set_free        (MalgtkStringSet *set);
+void             malgtk_string_set_clear       (MalgtkStringSet *set);
+
+gboolean         malgtk_string_set_add         (MalgtkStringSet *set, const gchar *str);
+gboolean         malgtk_string_set_contains    (const MalgtkStringSet *set, const gchar *str);
+gboolean         malgtk_string_set_is_equal    (const MalgtkStringSet *a, const MalgtkStringSet *b);
+gboolean         malgtk_string_set_assign_strv (MalgtkStringSet *set, const gchar * const *strv);
+gchar**          malgtk_string_set_to_strv     (const MalgtkStringSet *set);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(MalgtkStringSet, malgtk_string_set_free)
+
+G_END_DECLS
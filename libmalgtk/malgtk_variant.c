@@ -0,0 +1,390 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "malgtk_variant.h"
+#include "malgtk_date.h"
+#include "malgtk_string_set.h"
+
+typedef GVariant *(*MalgtkVariantWriteFunc)(const struct malgtk_xml_serialization_defs *def,
+                                            gconstpointer priv);
+typedef gboolean  (*MalgtkVariantReadFunc) (const struct malgtk_xml_serialization_defs *def,
+                                            gpointer priv,
+                                            GVariant *value);
+
+struct _MalgtkVariantPlan
+{
+    GVariantType *type;
+    guint32 schema;
+    gsize n_steps;
+    struct {
+        MalgtkVariantWriteFunc write;
+        MalgtkVariantReadFunc read;
+        const struct malgtk_xml_serialization_defs *def;
+    } steps[];
+};
+
+static GVariant *
+write_int64(const struct malgtk_xml_serialization_defs *def,
+            gconstpointer priv)
+{
+    return g_variant_new_int64(G_STRUCT_MEMBER(gint64, priv, def->ofs));
+}
+
+static gboolean
+read_int64(const struct malgtk_xml_serialization_defs *def,
+           gpointer priv,
+           GVariant *value)
+{
+    gint64 i = g_variant_get_int64(value);
+    if (i == G_STRUCT_MEMBER(gint64, priv, def->ofs))
+        return FALSE;
+    G_STRUCT_MEMBER(gint64, priv, def->ofs) = i;
+    return TRUE;
+}
+
+static GVariant *
+write_int(const struct malgtk_xml_serialization_defs *def,
+          gconstpointer priv)
+{
+    return g_variant_new_int32(G_STRUCT_MEMBER(gint, priv, def->ofs));
+}
+
+static gboolean
+read_int(const struct malgtk_xml_serialization_defs *def,
+         gpointer priv,
+         GVariant *value)
+{
+    gint i = g_variant_get_int32(value);
+    if (i == G_STRUCT_MEMBER(gint, priv, def->ofs))
+        return FALSE;
+    G_STRUCT_MEMBER(gint, priv, def->ofs) = i;
+    return TRUE;
+}
+
+static GVariant *
+write_enum(const struct malgtk_xml_serialization_defs *def,
+           gconstpointer priv)
+{
+    return g_variant_new_int32(malgtk_xml_get_enum(def, priv));
+}
+
+static gboolean
+read_enum(const struct malgtk_xml_serialization_defs *def,
+          gpointer priv,
+          GVariant *value)
+{
+    gint i = g_variant_get_int32(value);
+
+    if (G_UNLIKELY(NULL == malgtk_enum_table_get_nick(def->enum_table, i))) {
+        g_warning("Invalid %s value: %d", malgtk_enum_table_get_name(def->enum_table), i);
+        return FALSE;
+    }
+
+    if (i == malgtk_xml_get_enum(def, priv))
+        return FALSE;
+    malgtk_xml_set_enum(def, priv, i);
+    return TRUE;
+}
+
+static GVariant *
+write_bool(const struct malgtk_xml_serialization_defs *def,
+           gconstpointer priv)
+{
+    return g_variant_new_boolean(G_STRUCT_MEMBER(gboolean, priv, def->ofs));
+}
+
+static gboolean
+read_bool(const struct malgtk_xml_serialization_defs *def,
+          gpointer priv,
+          GVariant *value)
+{
+    gboolean b = g_variant_get_boolean(value);
+    if (b == G_STRUCT_MEMBER(gboolean, priv, def->ofs))
+        return FALSE;
+    G_STRUCT_MEMBER(gboolean, priv, def->ofs) = b;
+    return TRUE;
+}
+
+static GVariant *
+write_double(const struct malgtk_xml_serialization_defs *def,
+             gconstpointer priv)
+{
+    return g_variant_new_double(G_STRUCT_MEMBER(gdouble, priv, def->ofs));
+}
+
+static gboolean
+read_double(const struct malgtk_xml_serialization_defs *def,
+            gpointer priv,
+            GVariant *value)
+{
+    gdouble d = g_variant_get_double(value);
+    if (d == G_STRUCT_MEMBER(gdouble, priv, def->ofs))
+        return FALSE;
+    G_STRUCT_MEMBER(gdouble, priv, def->ofs) = d;
+    return TRUE;
+}
+
+static GVariant *
+write_gstring(const struct malgtk_xml_serialization_defs *def,
+              gconstpointer priv)
+{
+    return g_variant_new_string(G_STRUCT_MEMBER(GString*, priv, def->ofs)->str);
+}
+
+static gboolean
+read_gstring(const struct malgtk_xml_serialization_defs *def,
+             gpointer priv,
+             GVariant *value)
+{
+    GString *gstr = G_STRUCT_MEMBER(GString*, priv, def->ofs);
+    gsize len;
+    const gchar *str = g_variant_get_string(value, &len);
+
+    if (len == gstr->len && 0 == memcmp(gstr->str, str, len))
+        return FALSE;
+    g_string_truncate(gstr, 0);
+    g_string_append_len(gstr, str, len);
+    return TRUE;
+}
+
+static GVariant *
+write_maldate(const struct malgtk_xml_serialization_defs *def,
+              gconstpointer priv)
+{
+    const MalgtkDate *date = (const MalgtkDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    return g_variant_new_uint32(malgtk_date_get_key(date));
+}
+
+static gboolean
+read_maldate(const struct malgtk_xml_serialization_defs *def,
+             gpointer priv,
+             GVariant *value)
+{
+    MalgtkDate *date = (MalgtkDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    MalgtkDate d;
+
+    malgtk_date_set_from_key(&d, g_variant_get_uint32(value));
+    if (malgtk_date_is_equal(&d, date))
+        return FALSE;
+    *date = d;
+    return TRUE;
+}
+
+static GVariant *
+write_gdate(const struct malgtk_xml_serialization_defs *def,
+            gconstpointer priv)
+{
+    const GDate *date = (const GDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    return g_variant_new_uint32(g_date_valid(date) ? g_date_get_julian(date) : 0);
+}
+
+static gboolean
+read_gdate(const struct malgtk_xml_serialization_defs *def,
+           gpointer priv,
+           GVariant *value)
+{
+    GDate *date = (GDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    guint32 julian = g_variant_get_uint32(value);
+
+    if (!g_date_valid_julian(julian)) {
+        if (!g_date_valid(date))
+            return FALSE;
+        g_date_clear(date, 1);
+        return TRUE;
+    }
+
+    if (g_date_valid(date) && julian == g_date_get_julian(date))
+        return FALSE;
+    g_date_set_julian(date, julian);
+    return TRUE;
+}
+
+static GVariant *
+write_gdatetime(const struct malgtk_xml_serialization_defs *def,
+                gconstpointer priv)
+{
+    return g_variant_new_int64(g_date_time_to_unix(G_STRUCT_MEMBER(GDateTime*, priv, def->ofs)));
+}
+
+static gboolean
+read_gdatetime(const struct malgtk_xml_serialization_defs *def,
+               gpointer priv,
+               GVariant *value)
+{
+    GDateTime **dt = (GDateTime**)G_STRUCT_MEMBER_P(priv, def->ofs);
+    gint64 t = g_variant_get_int64(value);
+
+    if (t == g_date_time_to_unix(*dt))
+        return FALSE;
+    g_date_time_unref(*dt);
+    *dt = g_date_time_new_from_unix_utc(t);
+    return TRUE;
+}
+
+static GVariant *
+write_string_set(const struct malgtk_xml_serialization_defs *def,
+                 gconstpointer priv)
+{
+    const MalgtkStringSet *set = (const MalgtkStringSet*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    return g_variant_new_strv((const gchar * const *)set->strs, set->len);
+}
+
+static gboolean
+read_string_set(const struct malgtk_xml_serialization_defs *def,
+                gpointer priv,
+                GVariant *value)
+{
+    MalgtkStringSet *set = (MalgtkStringSet*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    g_autofree const gchar **strv = g_variant_get_strv(value, NULL);
+
+    return malgtk_string_set_assign_strv(set, (const gchar * const *)strv);
+}
+
+/* djb2 over str and its terminator, so that ("ab", "c") and ("a", "bc")
+ * differ */
+static guint32
+_schema_add(guint32 hash, const gchar *str)
+{
+    do
+        hash = hash * 33 + (guchar)*str;
+    while ('\0' != *str++);
+    return hash;
+}
+
+MalgtkVariantPlan *
+malgtk_variant_plan_new(const struct malgtk_xml_serialization_defs *defs)
+{
+    MalgtkVariantPlan *plan;
+    GVariantType **types;
+    gsize n = 0;
+
+    while (0 != defs[n].prop_id)
+        ++n;
+
+    plan  = g_malloc(sizeof(MalgtkVariantPlan) + n * sizeof(plan->steps[0]));
+    types = g_new(GVariantType*, n);
+    plan->n_steps = n;
+    plan->schema  = 5381;
+
+    for (gsize i = 0; i < n; ++i) {
+        const struct malgtk_xml_serialization_defs *def = &defs[i];
+        const gchar *type;
+
+        if (G_TYPE_GSTRING == def->type) {
+            plan->steps[i].write = write_gstring;
+            plan->steps[i].read  = read_gstring;
+            type = "s";
+        } else if (MALGTK_TYPE_DATE == def->type) {
+            plan->steps[i].write = write_maldate;
+            plan->steps[i].read  = read_maldate;
+            type = "u";
+        } else if (MALGTK_TYPE_STRING_SET == def->type) {
+            plan->steps[i].write = write_string_set;
+            plan->steps[i].read  = read_string_set;
+            type = "as";
+        } else if (G_TYPE_DATE == def->type) {
+            plan->steps[i].write = write_gdate;
+            plan->steps[i].read  = read_gdate;
+            type = "u";
+        } else if (G_TYPE_INT64 == def->type) {
+            plan->steps[i].write = write_int64;
+            plan->steps[i].read  = read_int64;
+            type = "x";
+        } else if (G_TYPE_INT == def->type) {
+            plan->steps[i].write = write_int;
+            plan->steps[i].read  = read_int;
+            type = "i";
+        } else if (G_TYPE_DATE_TIME == def->type) {
+            plan->steps[i].write = write_gdatetime;
+            plan->steps[i].read  = read_gdatetime;
+            type = "x";
+        } else if (G_TYPE_DOUBLE == def->type) {
+            plan->steps[i].write = write_double;
+            plan->steps[i].read  = read_double;
+            type = "d";
+        } else if (G_TYPE_BOOLEAN == def->type) {
+            plan->steps[i].write = write_bool;
+            plan->steps[i].read  = read_bool;
+            type = "b";
+        } else if (G_TYPE_IS_ENUM(def->type)) {
+            g_assert(NULL != def->enum_table);
+            plan->steps[i].write = write_enum;
+            plan->steps[i].read  = read_enum;
+            type = "i";
+        } else {
+            g_error("Unserializable type %s for %s", g_type_name(def->type), def->xml_name);
+        }
+
+        plan->steps[i].def = def;
+        types[i] = g_variant_type_new(type);
+        plan->schema = _schema_add(plan->schema, def->xml_name);
+        plan->schema = _schema_add(plan->schema, def->xml_subname ? def->xml_subname : "");
+        plan->schema = _schema_add(plan->schema, type);
+    }
+
+    plan->type = g_variant_type_new_tuple((const GVariantType * const *)types, n);
+
+    for (gsize i = 0; i < n; ++i)
+        g_variant_type_free(types[i]);
+    g_free(types);
+
+    return plan;
+}
+
+const GVariantType *
+malgtk_variant_plan_get_type(const MalgtkVariantPlan *plan)
+{
+    return plan->type;
+}
+
+guint32
+malgtk_variant_plan_get_schema(const MalgtkVariantPlan *plan)
+{
+    return plan->schema;
+}
+
+GVariant *
+malgtk_variant_serialize(const MalgtkVariantPlan *plan,
+                         gconstpointer priv)
+{
+    GVariant **children = g_newa(GVariant*, plan->n_steps);
+
+    for (gsize i = 0; i < plan->n_steps; ++i)
+        children[i] = plan->steps[i].write(plan->steps[i].def, priv);
+
+    return g_variant_new_tuple(children, plan->n_steps);
+}
+
+guint64
+malgtk_variant_deserialize(const MalgtkVariantPlan *plan,
+                           gpointer priv,
+                           GVariant *tuple)
+{
+    guint64 changed = 0;
+
+    g_return_val_if_fail(g_variant_is_of_type(tuple, plan->type), 0);
+
+    for (gsize i = 0; i < plan->n_steps; ++i) {
+        GVariant *child = g_variant_get_child_value(tuple, i);
+        if (plan->steps[i].read(plan->steps[i].def, priv, child))
+            changed |= MALGTK_XML_PROP_BIT(plan->steps[i].def->prop_id);
+        g_variant_unref(child);
+    }
+
+    return changed;
+}
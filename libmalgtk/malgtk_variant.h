@@ -0,0 +1,55 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include "malgtk_xml.h"
+
+/* The same defs as the XML backend, compiled into a GVariant tuple
+ * with one child per field, in defs order:
+ *
+ *   G_TYPE_INT64, G_TYPE_DATE_TIME    x (unix time for G_TYPE_DATE_TIME)
+ *   G_TYPE_INT, enums                 i
+ *   G_TYPE_BOOLEAN                    b
+ *   G_TYPE_DOUBLE                     d
+ *   G_TYPE_GSTRING                    s
+ *   MALGTK_TYPE_DATE                  u (year << 16 | month << 8 | day)
+ *   G_TYPE_DATE                       u (julian day, 0 if invalid)
+ *   MALGTK_TYPE_STRING_SET            as
+ *
+ * Adding, removing or reordering defs usually changes the type, but
+ * swapping or renaming fields of the same type does not. Data that
+ * outlives the process should also record the plan's schema, a hash
+ * of each field's name and type, and be rejected if it differs.
+ */
+typedef struct _MalgtkVariantPlan MalgtkVariantPlan;
+
+/* defs must outlive the plan */
+MalgtkVariantPlan  *malgtk_variant_plan_new      (const struct malgtk_xml_serialization_defs *defs);
+const GVariantType *malgtk_variant_plan_get_type (const MalgtkVariantPlan *plan);
+guint32             malgtk_variant_plan_get_schema (const MalgtkVariantPlan *plan);
+
+/* Returns a floating reference */
+GVariant *malgtk_variant_serialize   (const MalgtkVariantPlan *plan, gconstpointer priv);
+
+/* Stores each child of tuple in its field of priv, bypassing the
+ * property system. Returns the MALGTK_XML_PROP_BITs of the fields that
+ * changed. GString fields are overwritten in place, reusing their
+ * buffers, and only when the value differs.
+ */
+guint64   malgtk_variant_deserialize (const MalgtkVariantPlan *plan, gpointer priv, GVariant *tuple);
@@ -15,174 +15,393 @@
  *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
 #include "malgtk_xml.h"
-#include "malgtk_gtree.h"
+#include "malgtk_string_set.h"
 #include "malgtk_date.h"
 
+/* Large enough for any gint64 */
+#define INT_BUF_SIZE 24
+
+/* Formats i into the end of buf, returning where it starts */
+static const char *
+format_int64(char buf[INT_BUF_SIZE],
+             gint64 i)
+{
+    char *p = buf + INT_BUF_SIZE - 1;
+    guint64 u = i < 0 ? -(guint64)i : (guint64)i;
+
+    *p = '\0';
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (0 != u);
+    if (i < 0)
+        *--p = '-';
+
+    return p;
+}
+
+gint
+malgtk_xml_get_enum(const struct malgtk_xml_serialization_defs *def,
+                    gconstpointer priv)
+{
+    switch (def->enum_size) {
+        case 1:
+            return G_STRUCT_MEMBER(gint8, priv, def->ofs);
+        case 2:
+            return G_STRUCT_MEMBER(gint16, priv, def->ofs);
+        case 4:
+            return G_STRUCT_MEMBER(gint32, priv, def->ofs);
+        case 8:
+            return G_STRUCT_MEMBER(gint64, priv, def->ofs);
+        default:
+            g_error("Invalid enum size %" G_GSIZE_FORMAT, def->enum_size);
+            return 0;
+    }
+}
+
+void
+malgtk_xml_set_enum(const struct malgtk_xml_serialization_defs *def,
+                    gpointer priv,
+                    gint value)
+{
+    switch (def->enum_size) {
+        case 1:
+            G_STRUCT_MEMBER(gint8, priv, def->ofs) = value;
+            break;
+        case 2:
+            G_STRUCT_MEMBER(gint16, priv, def->ofs) = value;
+            break;
+        case 4:
+            G_STRUCT_MEMBER(gint32, priv, def->ofs) = value;
+            break;
+        case 8:
+            G_STRUCT_MEMBER(gint64, priv, def->ofs) = value;
+            break;
+        default:
+            g_error("Invalid enum size %" G_GSIZE_FORMAT, def->enum_size);
+            break;
+    }
+}
+
 static void
 malgtk_xml_serialize_int64(xmlTextWriterPtr writer,
-                           const char *element,
-                           gint64 i)
+                           const struct malgtk_xml_serialization_defs *def,
+                           gconstpointer priv)
 {
-    xmlTextWriterWriteFormatElement(writer, BAD_CAST element,
-                                    "%" G_GINT64_FORMAT, i);
+    char buf[INT_BUF_SIZE];
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name,
+                              BAD_CAST format_int64(buf, G_STRUCT_MEMBER(gint64, priv, def->ofs)));
 }
 
 static void
 malgtk_xml_serialize_int(xmlTextWriterPtr writer,
-                         const char *element,
-                         gint i)
+                         const struct malgtk_xml_serialization_defs *def,
+                         gconstpointer priv)
 {
-    xmlTextWriterWriteFormatElement(writer, BAD_CAST element,
-                                    "%d", i);
+    char buf[INT_BUF_SIZE];
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name,
+                              BAD_CAST format_int64(buf, G_STRUCT_MEMBER(gint, priv, def->ofs)));
 }
 
 static void
 malgtk_xml_serialize_bool(xmlTextWriterPtr writer,
-                          const char *element,
-                          gboolean b)
+                          const struct malgtk_xml_serialization_defs *def,
+                          gconstpointer priv)
 {
-    xmlTextWriterWriteFormatElement(writer, BAD_CAST element, "%u", b);
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name,
+                              BAD_CAST (G_STRUCT_MEMBER(gboolean, priv, def->ofs) ? "1" : "0"));
 }
 
 static void
 malgtk_xml_serialize_double(xmlTextWriterPtr writer,
-                            const char *element,
-                            gdouble d)
+                            const struct malgtk_xml_serialization_defs *def,
+                            gconstpointer priv)
 {
-#if 0
-    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
-    g_ascii_dtostr(buf, G_ASCII_DTOSTR_BUF_SIZE, d);
-    xmlTextWriterWriteElement(writer, BAD_CAST element, BAD_CAST buf);
-#else
-    xmlTextWriterWriteFormatElement(writer, BAD_CAST element, "%f", d);
-#endif    
+    /* %f of G_MAXDOUBLE is 316 characters */
+    gchar buf[320];
+    g_ascii_formatd(buf, sizeof buf, "%f", G_STRUCT_MEMBER(gdouble, priv, def->ofs));
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name, BAD_CAST buf);
 }
 
 static void
 malgtk_xml_serialize_enum(xmlTextWriterPtr writer,
-                          GType enum_type,
-                          const char *element,
-                          gint value)
+                          const struct malgtk_xml_serialization_defs *def,
+                          gconstpointer priv)
 {
-    GEnumClass *enum_class = g_type_class_ref(enum_type);
-    GEnumValue *enum_value = g_enum_get_value(enum_class, value);
-    xmlTextWriterWriteElement(writer, BAD_CAST element, BAD_CAST enum_value->value_nick);
-    g_type_class_unref(enum_class);
+    const gint value = malgtk_xml_get_enum(def, priv);
+    const gchar *nick = malgtk_enum_table_get_nick(def->enum_table, value);
+    if (G_UNLIKELY(NULL == nick)) {
+        g_warning("Invalid %s value: %d", malgtk_enum_table_get_name(def->enum_table), value);
+        return;
+    }
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name, BAD_CAST nick);
 }
 
 static void
-malgtk_xml_serialize_gstring(xmlTextWriterPtr writer, 
-                             const char *element,
-                             GString *str)
+malgtk_xml_serialize_gstring(xmlTextWriterPtr writer,
+                             const struct malgtk_xml_serialization_defs *def,
+                             gconstpointer priv)
 {
-    xmlTextWriterWriteElement(writer, BAD_CAST element, BAD_CAST str->str);
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name,
+                              BAD_CAST G_STRUCT_MEMBER(GString*, priv, def->ofs)->str);
 }
 
 static void
 malgtk_xml_serialize_maldate(xmlTextWriterPtr writer,
-                             const char *element,
-                             const MalgtkDate *date)
+                             const struct malgtk_xml_serialization_defs *def,
+                             gconstpointer priv)
 {
-    g_autofree char *str = malgtk_date_get_string(date);
-    xmlTextWriterWriteElement(writer, BAD_CAST element, BAD_CAST str);
+    const MalgtkDate *date = (const MalgtkDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    char buf[MALGTK_DATE_STRING_SIZE];
+
+    malgtk_date_format(date, buf);
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name, BAD_CAST buf);
 }
 
 static void
 malgtk_xml_serialize_gdate(xmlTextWriterPtr writer,
-                           const char *element,
-                           const GDate *date)
+                           const struct malgtk_xml_serialization_defs *def,
+                           gconstpointer priv)
 {
+    const GDate *date = (const GDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+    char buf[16];
+
     if (!g_date_valid(date)) {
-        xmlTextWriterWriteElement(writer, BAD_CAST element, BAD_CAST "0000-00-00");
+        xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name, BAD_CAST "0000-00-00");
         return;
     }
 
-    xmlTextWriterWriteFormatElement(writer, BAD_CAST element, "%d-%02d-%02d",
-                                    g_date_get_year(date),
-                                    g_date_get_month(date),
-                                    g_date_get_day(date));
+    g_snprintf(buf, sizeof buf, "%d-%02d-%02d",
+               g_date_get_year(date),
+               g_date_get_month(date),
+               g_date_get_day(date));
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name, BAD_CAST buf);
 }
 
 static void
 malgtk_xml_serialize_gdatetime(xmlTextWriterPtr writer,
-                               const char *element,
-                               GDateTime *datetime)
+                               const struct malgtk_xml_serialization_defs *def,
+                               gconstpointer priv)
 {
-    malgtk_xml_serialize_int64(writer, element, g_date_time_to_unix(datetime));
+    char buf[INT_BUF_SIZE];
+    GDateTime *datetime = G_STRUCT_MEMBER(GDateTime*, priv, def->ofs);
+    xmlTextWriterWriteElement(writer, BAD_CAST def->xml_name,
+                              BAD_CAST format_int64(buf, g_date_time_to_unix(datetime)));
 }
 
-struct key_writer_pair
+static void
+malgtk_xml_serialize_string_set(xmlTextWriterPtr writer,
+                                const struct malgtk_xml_serialization_defs *def,
+                                gconstpointer priv)
 {
-    const char *element;
-    xmlTextWriterPtr writer;
-};
+    const MalgtkStringSet *set = (const MalgtkStringSet*)G_STRUCT_MEMBER_P(priv, def->ofs);
 
+    xmlTextWriterStartElement(writer, BAD_CAST def->xml_name);
+    for (guint i = 0; i < set->len; ++i)
+        xmlTextWriterWriteElement(writer, BAD_CAST def->xml_subname, BAD_CAST set->strs[i]);
+    xmlTextWriterEndElement(writer);
+}
 
-static gboolean
-_gtree_to_writer_cb(gpointer key,
-                    gpointer value __attribute__((unused)),
-                    gpointer data)
+typedef void (*MalgtkXmlWriteFunc)(xmlTextWriterPtr writer,
+                                   const struct malgtk_xml_serialization_defs *def,
+                                   gconstpointer priv);
+
+struct _MalgtkXmlPlan
 {
-    struct key_writer_pair *pair = (struct key_writer_pair*)data;
-    xmlTextWriterWriteElement(pair->writer, BAD_CAST pair->element, BAD_CAST key);
-    return FALSE;
-}
+    gsize n_steps;
+    struct {
+        MalgtkXmlWriteFunc write;
+        const struct malgtk_xml_serialization_defs *def;
+    } steps[];
+};
 
-static void malgtk_xml_serialize_tree(xmlTextWriterPtr writer,
-                                      const char *element,
-                                      const char *subelement,
-                                      GTree *tree)
+MalgtkXmlPlan *
+malgtk_xml_plan_new(const struct malgtk_xml_serialization_defs *defs)
 {
-    struct key_writer_pair pair = { subelement, writer };
+    MalgtkXmlPlan *plan;
+    gsize n = 0;
 
-    xmlTextWriterStartElement(writer, BAD_CAST element);
-    g_tree_foreach (tree, _gtree_to_writer_cb, &pair);
-    xmlTextWriterEndElement(writer);
+    while (0 != defs[n].prop_id)
+        ++n;
+
+    plan = g_malloc(sizeof(MalgtkXmlPlan) + n * sizeof(plan->steps[0]));
+    plan->n_steps = n;
+
+    for (gsize i = 0; i < n; ++i) {
+        const struct malgtk_xml_serialization_defs *def = &defs[i];
+        MalgtkXmlWriteFunc write;
+
+        if (G_TYPE_GSTRING == def->type) {
+            write = malgtk_xml_serialize_gstring;
+        } else if (MALGTK_TYPE_DATE == def->type) {
+            write = malgtk_xml_serialize_maldate;
+        } else if (MALGTK_TYPE_STRING_SET == def->type) {
+            write = malgtk_xml_serialize_string_set;
+        } else if (G_TYPE_DATE == def->type) {
+            write = malgtk_xml_serialize_gdate;
+        } else if (G_TYPE_INT64 == def->type) {
+            write = malgtk_xml_serialize_int64;
+        } else if (G_TYPE_INT == def->type) {
+            write = malgtk_xml_serialize_int;
+        } else if (G_TYPE_DATE_TIME == def->type) {
+            write = malgtk_xml_serialize_gdatetime;
+        } else if (G_TYPE_DOUBLE == def->type) {
+            write = malgtk_xml_serialize_double;
+        } else if (G_TYPE_BOOLEAN == def->type) {
+            write = malgtk_xml_serialize_bool;
+        } else if (G_TYPE_IS_ENUM(def->type)) {
+            g_assert(NULL != def->enum_table);
+            write = malgtk_xml_serialize_enum;
+        } else {
+            g_error("Unserializable type %s for %s", g_type_name(def->type), def->xml_name);
+        }
+
+        plan->steps[i].write = write;
+        plan->steps[i].def   = def;
+    }
+
+    return plan;
 }
 
+void
+malgtk_xml_serialize(xmlTextWriterPtr writer,
+                     const MalgtkXmlPlan *plan,
+                     gconstpointer priv)
+{
+    for (gsize i = 0; i < plan->n_steps; ++i)
+        plan->steps[i].write(writer, plan->steps[i].def, priv);
+}
 
-void malgtk_xml_serialize(xmlTextWriterPtr writer, struct malgtk_xml_serialization_defs *defs, gconstpointer priv)
+GHashTable *
+malgtk_xml_defs_index_new(const struct malgtk_xml_serialization_defs *defs,
+                          const gchar *root)
 {
+    GHashTable *index = g_hash_table_new(g_str_hash, g_str_equal);
+
+    g_hash_table_insert(index, (gpointer)root, NULL);
     for (; 0 != defs->prop_id; ++defs) {
-        if (G_TYPE_GSTRING == defs->type) {
-            malgtk_xml_serialize_gstring(writer, defs->xml_name, G_STRUCT_MEMBER(GString*, priv, defs->ofs));
-        } else if (MALGTK_TYPE_DATE == defs->type) {
-            malgtk_xml_serialize_maldate(writer, defs->xml_name, (MalgtkDate*)G_STRUCT_MEMBER_P(priv, defs->ofs));
-        } else if (G_TYPE_TREE == defs->type) {
-            malgtk_xml_serialize_tree(writer, defs->xml_name, defs->xml_subname, G_STRUCT_MEMBER(GTree*, priv, defs->ofs));
-        } else if (G_TYPE_DATE == defs->type) {
-            malgtk_xml_serialize_gdate(writer, defs->xml_name, (GDate*)G_STRUCT_MEMBER_P(priv, defs->ofs));
-        } else if (G_TYPE_INT64 == defs->type) {
-            malgtk_xml_serialize_int64(writer, defs->xml_name, G_STRUCT_MEMBER(gint64, priv, defs->ofs));
-        } else if (G_TYPE_INT == defs->type) {
-            malgtk_xml_serialize_int(writer, defs->xml_name, G_STRUCT_MEMBER(gint64, priv, defs->ofs));
-        } else if (G_TYPE_DATE_TIME == defs->type) {
-            malgtk_xml_serialize_gdatetime(writer, defs->xml_name, G_STRUCT_MEMBER(GDateTime*, priv, defs->ofs));
-        } else if (G_TYPE_DOUBLE == defs->type) {
-            malgtk_xml_serialize_double(writer, defs->xml_name, G_STRUCT_MEMBER(gdouble, priv, defs->ofs));
-        } else if (G_TYPE_BOOLEAN == defs->type) {
-            malgtk_xml_serialize_bool(writer, defs->xml_name, G_STRUCT_MEMBER(gboolean, priv, defs->ofs));
-        } else if (G_TYPE_IS_ENUM(defs->type)) {
-            gint val;
-            switch (defs->enum_size) {
-                case 1:
-                    val = G_STRUCT_MEMBER(gint8, priv, defs->ofs);
-                    break;
-                case 2:
-                    val = G_STRUCT_MEMBER(gint16, priv, defs->ofs);
-                    break;
-                case 4:
-                    val = G_STRUCT_MEMBER(gint32, priv, defs->ofs);
-                    break;
-                case 8:
-                    val = G_STRUCT_MEMBER(gint64, priv, defs->ofs);
-                    break;
-                default:
-                    g_error("Invalid enum size %" G_GSIZE_FORMAT, defs->enum_size);
-                    break;
-            }
-            malgtk_xml_serialize_enum(writer, defs->type, defs->xml_name, val);
+        g_assert(!G_TYPE_IS_ENUM(defs->type) || NULL != defs->enum_table);
+        if (MALGTK_TYPE_STRING_SET == defs->type) {
+            g_hash_table_insert(index, (gpointer)defs->xml_name, NULL);
+            g_hash_table_insert(index, (gpointer)defs->xml_subname, (gpointer)defs);
+        } else {
+            g_hash_table_insert(index, (gpointer)defs->xml_name, (gpointer)defs);
         }
     }
+
+    return index;
+}
+
+static gboolean
+deserialize_enum(const struct malgtk_xml_serialization_defs *def,
+                 gpointer priv,
+                 const gchar *str)
+{
+    gint value;
+
+    if (G_UNLIKELY(!malgtk_enum_table_lookup_nick(def->enum_table, str, &value))) {
+        g_warning("Unrecognized %s nick: %s", malgtk_enum_table_get_name(def->enum_table), str);
+        return FALSE;
+    }
+
+    if (value == malgtk_xml_get_enum(def, priv))
+        return FALSE;
+
+    malgtk_xml_set_enum(def, priv, value);
+    return TRUE;
+}
+
+gboolean
+malgtk_xml_deserialize(const struct malgtk_xml_serialization_defs *def,
+                       gpointer priv,
+                       const xmlChar *xml_str)
+{
+    const gchar *str = (const gchar*)xml_str;
+
+    if (G_TYPE_GSTRING == def->type) {
+        GString *gstr = G_STRUCT_MEMBER(GString*, priv, def->ofs);
+        if (0 == strcmp(gstr->str, str))
+            return FALSE;
+        g_string_assign(gstr, str);
+        return TRUE;
+    } else if (MALGTK_TYPE_DATE == def->type) {
+        MalgtkDate *date = (MalgtkDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+        MalgtkDate d;
+        malgtk_date_set_from_string(&d, str);
+        if (malgtk_date_is_equal(&d, date))
+            return FALSE;
+        *date = d;
+        return TRUE;
+    } else if (G_TYPE_DATE == def->type) {
+        /* Incomplete dates, like 0000-00-00, leave the date alone */
+        GDate *date = (GDate*)G_STRUCT_MEMBER_P(priv, def->ofs);
+        GDate d;
+        MalgtkDate md;
+        malgtk_date_set_from_string(&md, str);
+        if (!malgtk_date_is_complete(&md))
+            return FALSE;
+        g_date_clear(&d, 1);
+        g_date_set_dmy(&d, md.day, md.month, md.year);
+        if (g_date_valid(date) && 0 == g_date_compare(&d, date))
+            return FALSE;
+        *date = d;
+        return TRUE;
+    } else if (G_TYPE_INT64 == def->type) {
+        gint64 i = g_ascii_strtoll(str, NULL, 0);
+        if (i == G_STRUCT_MEMBER(gint64, priv, def->ofs))
+            return FALSE;
+        G_STRUCT_MEMBER(gint64, priv, def->ofs) = i;
+        return TRUE;
+    } else if (G_TYPE_INT == def->type) {
+        gint i = g_ascii_strtoll(str, NULL, 0);
+        if (i == G_STRUCT_MEMBER(gint, priv, def->ofs))
+            return FALSE;
+        G_STRUCT_MEMBER(gint, priv, def->ofs) = i;
+        return TRUE;
+    } else if (G_TYPE_DATE_TIME == def->type) {
+        GDateTime **dt = (GDateTime**)G_STRUCT_MEMBER_P(priv, def->ofs);
+        gint64 t = g_ascii_strtoll(str, NULL, 0);
+        if (t == g_date_time_to_unix(*dt))
+            return FALSE;
+        g_date_time_unref(*dt);
+        *dt = g_date_time_new_from_unix_utc(t);
+        return TRUE;
+    } else if (G_TYPE_DOUBLE == def->type) {
+        gdouble d = g_ascii_strtod(str, NULL);
+        if (d == G_STRUCT_MEMBER(gdouble, priv, def->ofs))
+            return FALSE;
+        G_STRUCT_MEMBER(gdouble, priv, def->ofs) = d;
+        return TRUE;
+    } else if (G_TYPE_BOOLEAN == def->type) {
+        gboolean b = 0 != g_ascii_strtoll(str, NULL, 0);
+        if (b == G_STRUCT_MEMBER(gboolean, priv, def->ofs))
+            return FALSE;
+        G_STRUCT_MEMBER(gboolean, priv, def->ofs) = b;
+        return TRUE;
+    } else if (MALGTK_TYPE_STRING_SET == def->type) {
+        /* Each element adds to the set */
+        return malgtk_string_set_add((MalgtkStringSet*)G_STRUCT_MEMBER_P(priv, def->ofs), str);
+    } else if (G_TYPE_IS_ENUM(def->type)) {
+        return deserialize_enum(def, priv, str);
+    }
+
+    return FALSE;
+}
+
+void
+malgtk_xml_notify_changed(GObject *object,
+                          GParamSpec **pspecs,
+                          guint64 changed)
+{
+    if (0 == changed)
+        return;
+
+    g_object_freeze_notify(object);
+    for (guint prop_id = 1; 0 != changed >> prop_id; ++prop_id) {
+        if (changed & MALGTK_XML_PROP_BIT(prop_id))
+            g_object_notify_by_pspec(object, pspecs[prop_id]);
+    }
+    g_object_thaw_notify(object);
 }
@@ -21,6 +21,7 @@
 #include <glib-object.h>
 #include <libxml/xmlreader.h>
 #include <libxml/xmlwriter.h>
+#include "malgtk_enum_table.h"
 
 struct malgtk_xml_serialization_defs
 {
@@ -31,11 +32,40 @@ struct malgtk_xml_serialization_defs
     const gchar *xml_subname;
     goffset ofs;
     gsize enum_size;
+    const MalgtkEnumTable *enum_table;
 };
 
 #define MALGTK_ENUM_IS_SERIALIZABLE(e) static_assert(sizeof(e) == 1 || sizeof(e) == 2 || sizeof(e) == 4 || sizeof(e) == 8, "Unexpected enum width")
 
-void malgtk_xml_serialize(xmlTextWriterPtr writer, struct malgtk_xml_serialization_defs *defs, gconstpointer priv);
+/* defs compiled into a list of writer calls, one per field */
+typedef struct _MalgtkXmlPlan MalgtkXmlPlan;
+
+/* defs must outlive the plan */
+MalgtkXmlPlan *malgtk_xml_plan_new(const struct malgtk_xml_serialization_defs *defs);
+
+void malgtk_xml_serialize(xmlTextWriterPtr writer, const MalgtkXmlPlan *plan, gconstpointer priv);
+
+/* Maps each field's xml_name to its entry in defs, for looking up the
+ * element being read. MALGTK_TYPE_STRING_SET fields are found by
+ * xml_subname; their xml_name and the root element map to NULL, as
+ * they hold no value.
+ */
+GHashTable *malgtk_xml_defs_index_new(const struct malgtk_xml_serialization_defs *defs, const gchar *root);
+
+/* Parses str and stores it in the field of priv that def describes,
+ * bypassing the property system. Returns TRUE if the stored value
+ * changed. For MALGTK_TYPE_STRING_SET fields str is added to the set.
+ */
+gboolean malgtk_xml_deserialize(const struct malgtk_xml_serialization_defs *def, gpointer priv, const xmlChar *str);
+
+/* The value of an enum field, whatever its enum_size */
+gint malgtk_xml_get_enum(const struct malgtk_xml_serialization_defs *def, gconstpointer priv);
+void malgtk_xml_set_enum(const struct malgtk_xml_serialization_defs *def, gpointer priv, gint value);
+
+#define MALGTK_XML_PROP_BIT(prop_id) (G_GUINT64_CONSTANT(1) << (prop_id))
+
+/* Notifies each property whose MALGTK_XML_PROP_BIT is set in changed */
+void malgtk_xml_notify_changed(GObject *object, GParamSpec **pspecs, guint64 changed);
 
 
 
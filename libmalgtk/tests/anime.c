@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "malgtk_anime.h"
+#include "perf.h"
 
 
 static void
@@ -206,6 +207,148 @@ test_anime_notify(void)
     TEST_NOTIFY("storage-value", 12.2, 159.2);
 }
 
+static void
+count_notify (GObject    *gobject,
+              GParamSpec *pspec,
+              gpointer    user_data)
+{
+    GHashTable *counts = user_data;
+    g_hash_table_insert(counts, (gpointer)pspec->name,
+                        GINT_TO_POINTER(GPOINTER_TO_INT(g_hash_table_lookup(counts, pspec->name)) + 1));
+}
+
+static void
+test_anime_xmlnotify(void)
+{
+    static const char xml[] = "<anime version=\"1\"><MALitem version=\"1\"><series_itemdb_id>1</series_itemdb_id><series_title>Cowboy Bebop</series_title><series_date_begin>1998-04-03</series_date_begin><series_synonyms><series_synonym>Cowboy Bebop</series_synonym></series_synonyms><tags><tag>space</tag><tag>western</tag></tags></MALitem><series_type>TV</series_type><series_episodes>26</series_episodes><status>Completed</status><episodes>26</episodes></anime>";
+    g_autoptr(MalgtkAnime) anime  = malgtk_anime_new();
+    g_autoptr(GHashTable)  counts = g_hash_table_new(g_str_hash, g_str_equal);
+    xmlTextReaderPtr       reader;
+
+    g_signal_connect(G_OBJECT(anime), "notify", G_CALLBACK (count_notify), counts);
+
+    /* Each changed property is notified once, after the whole item is read */
+    reader = xmlReaderForMemory(xml, G_N_ELEMENTS(xml) - 1, NULL, NULL, 0);
+    xmlTextReaderRead(reader);
+    malgtk_anime_set_from_xml(anime, reader);
+    xmlFreeTextReader(reader);
+
+    g_assert_cmpuint(g_hash_table_size(counts), ==, 10);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "mal-db-id")),         ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "series-title")),      ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "series-date-begin")), ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "season-begin")),      ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "series-synonyms")),   ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "tags")),              ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "series-type")),       ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "series-episodes")),   ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "status")),            ==, 1);
+    g_assert_cmpint(GPOINTER_TO_INT(g_hash_table_lookup(counts, "episodes")),          ==, 1);
+
+    /* Reading the same values again changes nothing */
+    g_hash_table_remove_all(counts);
+    reader = xmlReaderForMemory(xml, G_N_ELEMENTS(xml) - 1, NULL, NULL, 0);
+    xmlTextReaderRead(reader);
+    malgtk_anime_set_from_xml(anime, reader);
+    xmlFreeTextReader(reader);
+
+    g_assert_cmpuint(g_hash_table_size(counts), ==, 0);
+}
+
+/* Properties drawn from the test's random seed, so a run can be
+ * repeated with --seed */
+static MalgtkAnime *
+new_random_anime (gint64 mal_db_id)
+{
+    static const MalgtkAnimeStatus statuses[] = {
+        MALGTK_ANIME_STATUS_WATCHING, MALGTK_ANIME_STATUS_COMPLETED, MALGTK_ANIME_STATUS_ON_HOLD,
+        MALGTK_ANIME_STATUS_DROPPED,  MALGTK_ANIME_STATUS_PLAN_TO_WATCH
+    };
+    g_autofree gchar *title           = g_strdup_printf ("Series %" G_GINT64_FORMAT, mal_db_id);
+    gint              series_episodes = g_test_rand_int_range (1, 500);
+
+    return g_object_new (MALGTK_TYPE_ANIME,
+                         "mal-db-id",       mal_db_id,
+                         "series-title",    title,
+                         "series-type",     g_test_rand_int_range (MALGTK_ANIME_SERIES_TYPE_TV, MALGTK_ANIME_SERIES_TYPE_MUSIC + 1),
+                         "series-status",   g_test_rand_int_range (MALGTK_ANIME_SERIES_STATUS_AIRING, MALGTK_ANIME_SERIES_STATUS_NOTYETAIRED + 1),
+                         "series-episodes", series_episodes,
+                         "status",          statuses[g_test_rand_int_range (0, G_N_ELEMENTS (statuses))],
+                         "episodes",        g_test_rand_int_range (0, series_episodes + 1),
+                         "storage-value",   g_test_rand_double_range (0.0, 100.0),
+                         NULL);
+}
+
+static void
+test_anime_perf_new (void)
+{
+    g_test_timer_start ();
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        g_object_unref (new_random_anime (i + 1));
+    malgtk_perf_check ("anime", "new", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+}
+
+static void
+test_anime_perf_getset (void)
+{
+    g_autoptr(MalgtkAnime) anime = new_random_anime (1);
+    gint                   episodes;
+    MalgtkAnimeStatus      status;
+
+    g_test_timer_start ();
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i) {
+        g_object_set (anime,
+                      "episodes", g_test_rand_int_range (0, 500),
+                      "status",   g_test_rand_bit () ? MALGTK_ANIME_STATUS_WATCHING : MALGTK_ANIME_STATUS_COMPLETED,
+                      NULL);
+        g_object_get (anime, "episodes", &episodes, "status", &status, NULL);
+    }
+    malgtk_perf_check ("anime", "getset", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+}
+
+static void
+test_anime_perf_xml (void)
+{
+    MalgtkAnime       **items  = g_new (MalgtkAnime*, MALGTK_PERF_N_ITEMS);
+    xmlBufferPtr      buffer = xmlBufferCreate ();
+    xmlTextWriterPtr  writer;
+    xmlTextReaderPtr  reader;
+    guint             n_read = 0;
+
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        items[i] = new_random_anime (i + 1);
+
+    g_test_timer_start ();
+
+    writer = xmlNewTextWriterMemory (buffer, 0);
+    xmlTextWriterStartDocument (writer, NULL, "UTF-8", NULL);
+    xmlTextWriterStartElement (writer, BAD_CAST "anime_list");
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        malgtk_anime_get_xml (items[i], writer);
+    xmlTextWriterEndElement (writer);
+    xmlTextWriterEndDocument (writer);
+    xmlFreeTextWriter (writer);
+
+    reader = xmlReaderForMemory ((const char*)xmlBufferContent (buffer), xmlBufferLength (buffer), NULL, NULL, 0);
+    while (1 == xmlTextReaderRead (reader)) {
+        if (XML_READER_TYPE_ELEMENT == xmlTextReaderNodeType (reader) &&
+            xmlStrEqual (BAD_CAST "anime", xmlTextReaderConstName (reader))) {
+            g_autoptr(MalgtkAnime) anime = malgtk_anime_new ();
+            malgtk_anime_set_from_xml (anime, reader);
+            ++n_read;
+        }
+    }
+    xmlFreeTextReader (reader);
+
+    malgtk_perf_check ("anime", "xml", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+    g_assert_cmpuint (n_read, ==, MALGTK_PERF_N_ITEMS);
+
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        g_object_unref (items[i]);
+    g_free (items);
+    xmlBufferFree (buffer);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -215,6 +358,13 @@ main(int argc, char *argv[])
     g_test_add_func("/malgtk/anime/xmlset", test_anime_xmlset);
     g_test_add_func("/malgtk/anime/notify", test_anime_notify);
     g_test_add_func("/malgtk/anime/xmlget", test_anime_xmlget);
+    g_test_add_func("/malgtk/anime/xmlnotify", test_anime_xmlnotify);
+
+    if (g_test_perf ()) {
+        g_test_add_func("/malgtk/anime/perf/new", test_anime_perf_new);
+        g_test_add_func("/malgtk/anime/perf/getset", test_anime_perf_getset);
+        g_test_add_func("/malgtk/anime/perf/xml", test_anime_perf_xml);
+    }
 
 
     int res = g_test_run ();
@@ -0,0 +1,87 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <locale.h>
+#include <string.h>
+#include "malgtk_date.h"
+
+static void
+test_date_parse (void)
+{
+    static const struct {
+        const gchar *str;
+        const gchar *formatted;
+        const gchar *season;
+    } cases[] = {
+        { "2014-02-01", "2014-02-01", "Winter 2014" },
+        { "2014-12-00", "2014-12",    "Winter 2015" },
+        { "1998-04",    "1998-04",    "Spring 1998" },
+        { "2015",       "2015",       "2015"        },
+        { "2014-02-30", "2014-02",    "Winter 2014" },
+        { "0000-00-00", "0000-00-00", "Unknown"     },
+        { "98",         "0000-00-00", "Unknown"     },
+        { "",           "0000-00-00", "Unknown"     },
+    };
+
+    for (guint i = 0; i < G_N_ELEMENTS (cases); ++i) {
+        MalgtkDate date;
+        gchar      buf[MALGTK_DATE_STRING_SIZE];
+        gchar      season[MALGTK_DATE_SEASON_SIZE];
+
+        malgtk_date_set_from_string (&date, cases[i].str);
+        g_assert_cmpuint (malgtk_date_format (&date, buf), ==, strlen (cases[i].formatted));
+        g_assert_cmpstr  (buf, ==, cases[i].formatted);
+        g_assert_cmpuint (malgtk_date_format_season (&date, season), ==, strlen (cases[i].season));
+        g_assert_cmpstr  (season, ==, cases[i].season);
+    }
+}
+
+static void
+test_date_keys (void)
+{
+    MalgtkDate a, b;
+
+    malgtk_date_set_dmy (&a, 31, G_DATE_DECEMBER, 2013);
+    malgtk_date_set_dmy (&b, 1, G_DATE_JANUARY, 2014);
+    g_assert_cmpint  (malgtk_date_compare (&a, &b), <, 0);
+    g_assert_cmpuint (malgtk_date_get_key (&a), <, malgtk_date_get_key (&b));
+
+    /* December is the next year's winter */
+    g_assert_cmpuint (malgtk_date_get_season_key (&a), ==, malgtk_date_get_season_key (&b));
+    g_assert_cmpstr  (malgtk_date_season_key_get_name (malgtk_date_get_season_key (&a)), ==, "Winter");
+    g_assert_cmpuint (malgtk_date_season_key_get_year (malgtk_date_get_season_key (&a)), ==, 2014);
+
+    /* A year alone comes before that year's seasons */
+    malgtk_date_set_from_string (&a, "2014");
+    g_assert_cmpuint (malgtk_date_get_season_key (&a), <, malgtk_date_get_season_key (&b));
+    g_assert_null    (malgtk_date_season_key_get_name (malgtk_date_get_season_key (&a)));
+
+    malgtk_date_set_from_key (&a, malgtk_date_get_key (&b));
+    g_assert_true (malgtk_date_is_equal (&a, &b));
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale (LC_ALL, "");
+    g_test_init (&argc, &argv, NULL);
+    g_test_add_func("/malgtk/date/parse", test_date_parse);
+    g_test_add_func("/malgtk/date/keys", test_date_keys);
+
+    return g_test_run();
+}
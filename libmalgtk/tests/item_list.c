@@ -0,0 +1,367 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+#include <unistd.h>
+#include "malgtk_anime.h"
+#include "malgtk_manga.h"
+#include "malgtk_item_list.h"
+
+typedef struct
+{
+    guint position;
+    guint removed;
+    guint added;
+} ItemsChanged;
+
+static void
+items_changed_cb (GListModel *model,
+                  guint       position,
+                  guint       removed,
+                  guint       added,
+                  gpointer    user_data)
+{
+    ItemsChanged change = { position, removed, added };
+    g_array_append_val ((GArray*)user_data, change);
+}
+
+static MalgtkMalitem *
+new_anime (gint64 mal_db_id)
+{
+    return MALGTK_MALITEM (g_object_new (MALGTK_TYPE_ANIME, "mal-db-id", mal_db_id, NULL));
+}
+
+static void
+assert_change (GArray *changes,
+               guint   i,
+               guint   position,
+               guint   removed,
+               guint   added)
+{
+    ItemsChanged *change = &g_array_index (changes, ItemsChanged, i);
+    g_assert_cmpuint (change->position, ==, position);
+    g_assert_cmpuint (change->removed,  ==, removed);
+    g_assert_cmpuint (change->added,    ==, added);
+}
+
+static void
+test_item_list_merge (void)
+{
+    g_autoptr(MalgtkItemList) list    = malgtk_item_list_new (MALGTK_TYPE_ANIME);
+    g_autoptr(GArray)         changes = g_array_new (FALSE, FALSE, sizeof(ItemsChanged));
+    MalgtkMalitem            *items[6];
+    guint                     position;
+
+    g_signal_connect (list, "items-changed", G_CALLBACK (items_changed_cb), changes);
+
+    for (gint i = 0; i < 5; ++i)
+        items[i] = new_anime (i + 1);
+    malgtk_item_list_merge (list, items, 5);
+    for (gint i = 0; i < 5; ++i)
+        g_object_unref (items[i]);
+
+    g_assert_cmpuint (changes->len, ==, 1);
+    assert_change (changes, 0, 0, 0, 5);
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 5);
+    g_assert_true (g_list_model_get_item_type (G_LIST_MODEL (list)) == MALGTK_TYPE_ANIME);
+
+    /* 2 and 3 replace their items in place as one run, 5 on its own,
+     * and 6 and 7 are appended together */
+    g_array_set_size (changes, 0);
+    items[0] = new_anime (3);
+    items[1] = new_anime (6);
+    items[2] = new_anime (2);
+    items[3] = new_anime (5);
+    items[4] = new_anime (7);
+    items[5] = new_anime (6);
+    malgtk_item_list_merge (list, items, 6);
+
+    g_assert_cmpuint (changes->len, ==, 3);
+    assert_change (changes, 0, 1, 2, 2);
+    assert_change (changes, 1, 4, 1, 1);
+    assert_change (changes, 2, 5, 0, 2);
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 7);
+
+    g_assert_true (malgtk_item_list_lookup (list, 3) == items[0]);
+    g_assert_true (malgtk_item_list_lookup (list, 6) == items[5]);
+    g_assert_true (malgtk_item_list_get (list, 1) == items[2]);
+    g_assert_true (malgtk_item_list_find (list, 7, &position));
+    g_assert_cmpuint (position, ==, 6);
+    g_assert_null (malgtk_item_list_lookup (list, 8));
+
+    for (gint i = 0; i < 6; ++i)
+        g_object_unref (items[i]);
+}
+
+static void
+test_item_list_remove (void)
+{
+    g_autoptr(MalgtkItemList) list    = malgtk_item_list_new (MALGTK_TYPE_MALITEM);
+    g_autoptr(GArray)         changes = g_array_new (FALSE, FALSE, sizeof(ItemsChanged));
+    guint                     position;
+
+    for (gint i = 0; i < 4; ++i) {
+        g_autoptr(MalgtkMalitem) item = new_anime ((i + 1) * 10);
+        malgtk_item_list_append (list, item);
+    }
+
+    g_signal_connect (list, "items-changed", G_CALLBACK (items_changed_cb), changes);
+
+    g_assert_true (malgtk_item_list_remove (list, 20));
+    g_assert_false (malgtk_item_list_remove (list, 20));
+    g_assert_cmpuint (changes->len, ==, 1);
+    assert_change (changes, 0, 1, 1, 0);
+
+    /* Everything after the removed item has moved up */
+    g_assert_true (malgtk_item_list_find (list, 30, &position));
+    g_assert_cmpuint (position, ==, 1);
+    g_assert_true (malgtk_item_list_find (list, 40, &position));
+    g_assert_cmpuint (position, ==, 2);
+    g_assert_cmpint (malgtk_malitem_get_mal_db_id (malgtk_item_list_get (list, 2)), ==, 40);
+
+    malgtk_item_list_remove_all (list);
+    g_assert_cmpuint (changes->len, ==, 2);
+    assert_change (changes, 1, 0, 3, 0);
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 0);
+    g_assert_null (malgtk_item_list_lookup (list, 10));
+}
+
+static void
+test_item_list_variant (void)
+{
+    g_autoptr(MalgtkItemList) list   = malgtk_item_list_new (MALGTK_TYPE_ANIME);
+    g_autoptr(MalgtkItemList) loaded = NULL;
+    g_autoptr(GError)         error  = NULL;
+    g_autofree gchar         *path   = NULL;
+    g_autofree gchar         *title  = NULL;
+    MalgtkMalitem            *item;
+    gint                      episodes;
+    gint                      fd;
+
+    for (gint i = 0; i < 3; ++i) {
+        g_autofree gchar *t = g_strdup_printf ("Title %d", i);
+        g_autoptr(MalgtkMalitem) anime = MALGTK_MALITEM (g_object_new (MALGTK_TYPE_ANIME,
+                                                                       "mal-db-id", (gint64)(i + 1) * 100,
+                                                                       "series-title", t,
+                                                                       "episodes", i * 4,
+                                                                       NULL));
+        malgtk_malitem_add_tag (anime, "Mecha");
+        malgtk_item_list_append (list, anime);
+    }
+
+    fd = g_file_open_tmp ("malgtk-item-list-XXXXXX", &path, &error);
+    g_assert_no_error (error);
+    close (fd);
+
+    g_assert_true (malgtk_item_list_save_file (list, path, &error));
+    g_assert_no_error (error);
+
+    loaded = malgtk_item_list_new_from_file (MALGTK_TYPE_ANIME, path, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (loaded);
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (loaded)), ==, 3);
+
+    item = malgtk_item_list_lookup (loaded, 300);
+    g_assert_nonnull (item);
+    g_object_get (item, "series-title", &title, "episodes", &episodes, NULL);
+    g_assert_cmpstr (title, ==, "Title 2");
+    g_assert_cmpint (episodes, ==, 8);
+    g_assert_true (malgtk_item_list_lookup (loaded, 300) == item);
+
+    /* Once changed, the list no longer reads from the file */
+    g_assert_true (malgtk_item_list_remove (loaded, 100));
+    g_unlink (path);
+    g_assert_cmpint (malgtk_malitem_get_mal_db_id (malgtk_item_list_get (loaded, 0)), ==, 200);
+
+    /* A manga list can't be read as anime */
+    g_clear_object (&loaded);
+    {
+        g_autoptr(MalgtkItemList) manga = malgtk_item_list_new (MALGTK_TYPE_MANGA);
+        g_assert_true (malgtk_item_list_save_file (manga, path, &error));
+        g_assert_no_error (error);
+    }
+    loaded = malgtk_item_list_new_from_file (MALGTK_TYPE_ANIME, path, &error);
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_assert_null (loaded);
+    g_unlink (path);
+}
+
+static void
+test_item_list_variant_edit (void)
+{
+    g_autoptr(MalgtkItemList) list   = malgtk_item_list_new (MALGTK_TYPE_ANIME);
+    g_autoptr(MalgtkItemList) loaded = NULL;
+    g_autoptr(GError)         error  = NULL;
+    g_autofree gchar         *path   = NULL;
+    gint                      episodes;
+    gint                      fd;
+
+    for (gint i = 0; i < 3; ++i) {
+        g_autoptr(MalgtkMalitem) anime = new_anime (i + 1);
+        malgtk_item_list_append (list, anime);
+    }
+
+    fd = g_file_open_tmp ("malgtk-item-list-XXXXXX", &path, &error);
+    g_assert_no_error (error);
+    close (fd);
+    g_assert_true (malgtk_item_list_save_file (list, path, &error));
+    g_assert_no_error (error);
+
+    /* An item read from the file and changed, without the list itself
+     * changing, must still be saved as changed */
+    loaded = malgtk_item_list_new_from_file (MALGTK_TYPE_ANIME, path, &error);
+    g_assert_no_error (error);
+    g_object_set (malgtk_item_list_lookup (loaded, 2), "episodes", 12, NULL);
+    g_assert_true (malgtk_item_list_save_file (loaded, path, &error));
+    g_assert_no_error (error);
+    g_clear_object (&loaded);
+
+    loaded = malgtk_item_list_new_from_file (MALGTK_TYPE_ANIME, path, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (loaded)), ==, 3);
+    g_object_get (malgtk_item_list_lookup (loaded, 2), "episodes", &episodes, NULL);
+    g_assert_cmpint (episodes, ==, 12);
+    g_assert_cmpint (malgtk_malitem_get_mal_db_id (malgtk_item_list_get (loaded, 2)), ==, 3);
+
+    g_unlink (path);
+}
+
+static void
+test_item_list_variant_duplicates (void)
+{
+    g_autoptr(MalgtkItemList) list   = NULL;
+    g_autoptr(GTypeClass)     klass  = g_type_class_ref (MALGTK_TYPE_ANIME);
+    const gint64              ids[]  = { 1, 2, 1, 3 };
+    GVariant                 *children[G_N_ELEMENTS (ids)];
+    GVariant                 *variant;
+
+    for (guint i = 0; i < G_N_ELEMENTS (ids); ++i) {
+        g_autoptr(MalgtkMalitem) anime = new_anime (ids[i]);
+        g_object_set (anime, "episodes", (gint)i, NULL);
+        children[i] = malgtk_malitem_get_variant (anime);
+    }
+    variant = g_variant_new_array (MALGTK_MALITEM_CLASS (klass)->get_variant_type (),
+                                   children, G_N_ELEMENTS (children));
+
+    /* The second 1 is dropped, so every position is indexed */
+    g_test_expect_message (NULL, G_LOG_LEVEL_WARNING, "Dropping duplicate mal-db-id*");
+    list = malgtk_item_list_new_from_variant (MALGTK_TYPE_ANIME, variant);
+    g_test_assert_expected_messages ();
+
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 3);
+    g_assert_cmpint (malgtk_malitem_get_mal_db_id (malgtk_item_list_get (list, 2)), ==, 3);
+
+    g_assert_true (malgtk_item_list_remove (list, 1));
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 2);
+    g_assert_null (malgtk_item_list_lookup (list, 1));
+    g_assert_cmpint (malgtk_malitem_get_mal_db_id (malgtk_item_list_lookup (list, 2)), ==, 2);
+    g_assert_cmpint (malgtk_malitem_get_mal_db_id (malgtk_item_list_lookup (list, 3)), ==, 3);
+    g_assert_true (malgtk_item_list_lookup (list, 3) == malgtk_item_list_get (list, 1));
+}
+
+static void
+test_item_list_file_schema (void)
+{
+    g_autoptr(MalgtkItemList)      list   = malgtk_item_list_new (MALGTK_TYPE_ANIME);
+    g_autoptr(MalgtkItemList)      loaded = NULL;
+    g_autoptr(MalgtkMalitem)       anime  = new_anime (1);
+    g_autoptr(GVariant)            items  = NULL;
+    g_autoptr(GVariant)            file   = NULL;
+    g_autoptr(GError)              error  = NULL;
+    g_autoptr(GTypeClass)          klass  = g_type_class_ref (MALGTK_TYPE_ANIME);
+    g_autoptr(GTypeClass)          manga  = g_type_class_ref (MALGTK_TYPE_MANGA);
+    g_autofree gchar              *path   = NULL;
+    guint32                        schema;
+    gint                           fd;
+
+    malgtk_item_list_append (list, anime);
+    items  = malgtk_item_list_get_variant (list);
+    schema = MALGTK_MALITEM_CLASS (klass)->get_variant_schema ();
+
+    fd = g_file_open_tmp ("malgtk-item-list-XXXXXX", &path, &error);
+    g_assert_no_error (error);
+    close (fd);
+
+    /* The bare boxed list that files used to hold */
+    file = g_variant_ref_sink (g_variant_new_variant (items));
+    g_assert_true (g_file_set_contents (path, g_variant_get_data (file), g_variant_get_size (file), &error));
+    loaded = malgtk_item_list_new_from_file (MALGTK_TYPE_ANIME, path, &error);
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_assert_null (loaded);
+    g_clear_error (&error);
+    g_clear_pointer (&file, g_variant_unref);
+
+    /* Same layout, written when the fields were different */
+    file = g_variant_ref_sink (g_variant_new ("(suuv)", "malgtk-item-list", 1, schema + 1, items));
+    g_assert_true (g_file_set_contents (path, g_variant_get_data (file), g_variant_get_size (file), &error));
+    loaded = malgtk_item_list_new_from_file (MALGTK_TYPE_ANIME, path, &error);
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_assert_null (loaded);
+    g_clear_error (&error);
+
+    /* Anime and manga fields differ, so neither reads the other's */
+    g_assert_cmpuint (schema, !=, MALGTK_MALITEM_CLASS (manga)->get_variant_schema ());
+
+    g_unlink (path);
+}
+
+static void
+test_item_list_load_xml (void)
+{
+    static const char xml[] =
+        "<anime_list>"
+        "<anime><MALitem><series_itemdb_id>1</series_itemdb_id><series_title>Cowboy Bebop</series_title></MALitem><episodes>26</episodes></anime>"
+        "<anime version=\"1\"><MALitem><series_itemdb_id>71</series_itemdb_id><series_title>Full Metal Panic!</series_title></MALitem><episodes>24</episodes></anime>"
+        "<anime><MALitem><series_itemdb_id>1</series_itemdb_id><series_title>Cowboy Bebop</series_title></MALitem><episodes>5</episodes></anime>"
+        "</anime_list>";
+    g_autoptr(MalgtkItemList) list    = malgtk_item_list_new (MALGTK_TYPE_ANIME);
+    g_autoptr(GArray)         changes = g_array_new (FALSE, FALSE, sizeof(ItemsChanged));
+    g_autofree gchar         *title   = NULL;
+    gint                      episodes;
+
+    g_signal_connect (list, "items-changed", G_CALLBACK (items_changed_cb), changes);
+
+    g_assert_cmpuint (malgtk_item_list_load_xml_buffer (list, xml, G_N_ELEMENTS(xml) - 1), ==, 3);
+
+    /* One batch, in which the later copy of 1 wins */
+    g_assert_cmpuint (changes->len, ==, 1);
+    assert_change (changes, 0, 0, 0, 2);
+
+    g_object_get (malgtk_item_list_lookup (list, 1), "series-title", &title, "episodes", &episodes, NULL);
+    g_assert_cmpstr (title, ==, "Cowboy Bebop");
+    g_assert_cmpint (episodes, ==, 5);
+    g_object_get (malgtk_item_list_get (list, 1), "episodes", &episodes, NULL);
+    g_assert_cmpint (episodes, ==, 24);
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale (LC_ALL, "");
+    g_test_init (&argc, &argv, NULL);
+    g_test_add_func("/malgtk/item_list/merge", test_item_list_merge);
+    g_test_add_func("/malgtk/item_list/remove", test_item_list_remove);
+    g_test_add_func("/malgtk/item_list/variant", test_item_list_variant);
+    g_test_add_func("/malgtk/item_list/variant-edit", test_item_list_variant_edit);
+    g_test_add_func("/malgtk/item_list/variant-duplicates", test_item_list_variant_duplicates);
+    g_test_add_func("/malgtk/item_list/file-schema", test_item_list_file_schema);
+    g_test_add_func("/malgtk/item_list/load_xml", test_item_list_load_xml);
+
+    return g_test_run();
+}
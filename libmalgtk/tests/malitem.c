@@ -22,6 +22,7 @@
 #include <libxml/encoding.h>
 #include "malgtk_malitem.h"
 #include "malgtk_date.h"
+#include "perf.h"
 
 typedef struct {
     MalgtkMalitem *item;
@@ -115,6 +116,33 @@ test_malitem_test3 (MalitemFixture *fixture,
     g_assert_null   (strv[2]);
 }
 
+static gboolean
+first_str_cb (const gchar *str,
+              gpointer user_data)
+{
+    *(const gchar**)user_data = str;
+    return TRUE;
+}
+
+static void
+test_malitem_test5 (MalitemFixture *fixture,
+                    gconstpointer user_data)
+{
+    g_autoptr(MalgtkMalitem) other = malgtk_malitem_new ();
+    const gchar *tag       = NULL;
+    const gchar *other_tag = NULL;
+
+    malgtk_malitem_add_tag(fixture->item, "Zebra");
+    malgtk_malitem_add_tag(fixture->item, "Mecha");
+    malgtk_malitem_add_tag(other, "Mecha");
+
+    /* foreach stops at the first TRUE, and items share their strings */
+    malgtk_malitem_foreach_tag(fixture->item, first_str_cb, &tag);
+    malgtk_malitem_foreach_tag(other, first_str_cb, &other_tag);
+    g_assert_cmpstr (tag, ==, "Mecha");
+    g_assert_true   (tag == other_tag);
+}
+
 static void
 test_malitem_test4 (MalitemFixture *fixture,
                     gconstpointer user_data)
@@ -497,6 +525,52 @@ test_malitem_notify (MalitemFixture *fixture,
 #undef TEST_NOTIFY
 }
 
+static void
+test_malitem_perf_dates (void)
+{
+    gchar      (*strs)[MALGTK_DATE_STRING_SIZE] = g_malloc_n (MALGTK_PERF_N_ITEMS, MALGTK_DATE_STRING_SIZE);
+    gchar        buf[MALGTK_DATE_SEASON_SIZE];
+    MalgtkDate   date;
+
+    /* Including MAL's zeros for unknown months and days */
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        g_snprintf (strs[i], sizeof strs[i], "%04d-%02d-%02d",
+                    g_test_rand_int_range (1900, 2030),
+                    g_test_rand_int_range (0, 13),
+                    g_test_rand_int_range (0, 32));
+
+    g_test_timer_start ();
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i) {
+        malgtk_date_set_from_string (&date, strs[i]);
+        malgtk_date_format (&date, buf);
+        malgtk_date_format_season (&date, buf);
+    }
+    malgtk_perf_check ("malitem", "dates", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+
+    g_free (strs);
+}
+
+static void
+test_malitem_perf_getset (void)
+{
+    g_autoptr(MalgtkMalitem) item   = malgtk_malitem_new ();
+    g_auto(GStrv)            titles = g_new0 (gchar*, MALGTK_PERF_N_ITEMS + 1);
+
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        titles[i] = g_strdup_printf ("Series %d", g_test_rand_int ());
+
+    g_test_timer_start ();
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i) {
+        g_autofree gchar *title = NULL;
+
+        g_object_set (item, "series-title", titles[i], NULL);
+        g_object_get (item, "series-title", &title, NULL);
+        /* A small pool, so most of these are already there */
+        malgtk_malitem_add_tag (item, titles[i % 64]);
+    }
+    malgtk_perf_check ("malitem", "getset", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+}
+
 int main(int argc, char *argv[])
 {
     setlocale (LC_ALL, "");
@@ -514,6 +588,10 @@ int main(int argc, char *argv[])
                 malitem_fixture_set_up, test_malitem_test3,
                 malitem_fixture_tear_down);
 
+    g_test_add ("/malgtk/malitem/tags", MalitemFixture, NULL,
+                malitem_fixture_set_up, test_malitem_test5,
+                malitem_fixture_tear_down);
+
     g_test_add ("/malgtk/malitem/getset", MalitemFixture, NULL,
                 malitem_fixture_set_up, test_malitem_test4,
                 malitem_fixture_tear_down);
@@ -530,6 +608,11 @@ int main(int argc, char *argv[])
                 malitem_fixture_set_up, test_malitem_xmlget,
                 malitem_fixture_tear_down);
 
+    if (g_test_perf ()) {
+        g_test_add_func ("/malgtk/malitem/perf/dates", test_malitem_perf_dates);
+        g_test_add_func ("/malgtk/malitem/perf/getset", test_malitem_perf_getset);
+    }
+
     int res = g_test_run ();
 
     return res;
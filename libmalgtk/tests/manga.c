@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "malgtk_manga.h"
+#include "perf.h"
 
 static void
 test_manga_getset(void)
@@ -245,6 +246,117 @@ test_manga_notify(void)
     TEST_NOTIFY("storage-type", MALGTK_MANGA_STORAGE_TYPE_HARD_DRIVE, MALGTK_MANGA_STORAGE_TYPE_INVALID);
 }
 
+static void
+test_manga_xmlset_unknown_nick (void)
+{
+    static const char xml[] = "<manga version=\"1\"><series_type>Manga</series_type><status>Reading Later</status><chapters>77</chapters><storage_type>Harddrive</storage_type></manga>";
+    g_autoptr(MalgtkManga) manga  = malgtk_manga_new();
+    xmlTextReaderPtr       reader = xmlReaderForMemory(xml, G_N_ELEMENTS(xml) - 1, NULL, NULL, 0);
+    xmlTextReaderRead(reader);
+
+    /* An unknown nick leaves the field alone and the rest is still read */
+    g_test_expect_message(NULL, G_LOG_LEVEL_WARNING, "Unrecognized MalgtkMangaStatus nick: Reading Later");
+    malgtk_manga_set_from_xml(manga, reader);
+    g_test_assert_expected_messages();
+
+    MalgtkMangaSeriesType  _series_type;
+    MalgtkMangaStatus      _status;
+    gint                   _chapters;
+    MalgtkMangaStorageType _storage_type;
+
+    g_object_get(G_OBJECT(manga),
+                 "series-type",  &_series_type,
+                 "status",       &_status,
+                 "chapters",     &_chapters,
+                 "storage-type", &_storage_type,
+                 NULL);
+
+    g_assert_cmpint(_series_type,  ==, MALGTK_MANGA_SERIES_TYPE_MANGA);
+    g_assert_cmpint(_status,       ==, MALGTK_MANGA_STATUS_INVALID);
+    g_assert_cmpint(_chapters,     ==, 77);
+    g_assert_cmpint(_storage_type, ==, MALGTK_MANGA_STORAGE_TYPE_HARD_DRIVE);
+
+    xmlFreeTextReader(reader);
+}
+
+/* Properties drawn from the test's random seed, so a run can be
+ * repeated with --seed */
+static MalgtkManga *
+new_random_manga (gint64 mal_db_id)
+{
+    static const MalgtkMangaStatus statuses[] = {
+        MALGTK_MANGA_STATUS_READING, MALGTK_MANGA_STATUS_COMPLETED, MALGTK_MANGA_STATUS_ON_HOLD,
+        MALGTK_MANGA_STATUS_DROPPED, MALGTK_MANGA_STATUS_PLAN_TO_READ
+    };
+    g_autofree gchar *title           = g_strdup_printf ("Series %" G_GINT64_FORMAT, mal_db_id);
+    gint              series_chapters = g_test_rand_int_range (1, 1000);
+    gint              series_volumes  = g_test_rand_int_range (1, 100);
+
+    return g_object_new (MALGTK_TYPE_MANGA,
+                         "mal-db-id",       mal_db_id,
+                         "series-title",    title,
+                         "series-type",     g_test_rand_int_range (MALGTK_MANGA_SERIES_TYPE_MANGA, MALGTK_MANGA_SERIES_TYPE_OEL + 1),
+                         "series-status",   g_test_rand_int_range (MALGTK_MANGA_SERIES_STATUS_PUBLISHING, MALGTK_MANGA_SERIES_STATUS_NOT_YET_PUBLISHED + 1),
+                         "series-chapters", series_chapters,
+                         "series-volumes",  series_volumes,
+                         "status",          statuses[g_test_rand_int_range (0, G_N_ELEMENTS (statuses))],
+                         "chapters",        g_test_rand_int_range (0, series_chapters + 1),
+                         "volumes",         g_test_rand_int_range (0, series_volumes + 1),
+                         NULL);
+}
+
+static void
+test_manga_perf_new (void)
+{
+    g_test_timer_start ();
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        g_object_unref (new_random_manga (i + 1));
+    malgtk_perf_check ("manga", "new", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+}
+
+static void
+test_manga_perf_xml (void)
+{
+    MalgtkManga       **items  = g_new (MalgtkManga*, MALGTK_PERF_N_ITEMS);
+    xmlBufferPtr      buffer = xmlBufferCreate ();
+    xmlTextWriterPtr  writer;
+    xmlTextReaderPtr  reader;
+    guint             n_read = 0;
+
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        items[i] = new_random_manga (i + 1);
+
+    g_test_timer_start ();
+
+    writer = xmlNewTextWriterMemory (buffer, 0);
+    xmlTextWriterStartDocument (writer, NULL, "UTF-8", NULL);
+    xmlTextWriterStartElement (writer, BAD_CAST "manga_list");
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        malgtk_manga_get_xml (items[i], writer);
+    xmlTextWriterEndElement (writer);
+    xmlTextWriterEndDocument (writer);
+    xmlFreeTextWriter (writer);
+
+    reader = xmlReaderForMemory ((const char*)xmlBufferContent (buffer), xmlBufferLength (buffer), NULL, NULL, 0);
+    while (1 == xmlTextReaderRead (reader)) {
+        if (XML_READER_TYPE_ELEMENT == xmlTextReaderNodeType (reader) &&
+            xmlStrEqual (BAD_CAST "manga", xmlTextReaderConstName (reader))) {
+            g_autoptr(MalgtkManga) manga = malgtk_manga_new ();
+            malgtk_manga_set_from_xml (manga, reader);
+            ++n_read;
+        }
+    }
+    xmlFreeTextReader (reader);
+
+    malgtk_perf_check ("manga", "xml", MALGTK_PERF_N_ITEMS, g_test_timer_elapsed ());
+    g_assert_cmpuint (n_read, ==, MALGTK_PERF_N_ITEMS);
+
+    for (guint i = 0; i < MALGTK_PERF_N_ITEMS; ++i)
+        g_object_unref (items[i]);
+    g_free (items);
+    xmlBufferFree (buffer);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -254,6 +366,12 @@ main(int argc, char *argv[])
     g_test_add_func("/malgtk/manga/xmlset", test_manga_xmlset);
     g_test_add_func("/malgtk/manga/notify", test_manga_notify);
     g_test_add_func("/malgtk/manga/xmlget", test_manga_xmlget);
+    g_test_add_func("/malgtk/manga/xmlset-unknown-nick", test_manga_xmlset_unknown_nick);
+
+    if (g_test_perf ()) {
+        g_test_add_func("/malgtk/manga/perf/new", test_manga_perf_new);
+        g_test_add_func("/malgtk/manga/perf/xml", test_manga_perf_xml);
+    }
 
     int res = g_test_run ();
 
@@ -0,0 +1,116 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perf.h"
+
+#define DEFAULT_MARGIN 0.2
+
+/* Describes the machine and build in the [reference] group */
+#define REFERENCE "reference"
+
+static const gchar *
+buildtype (void)
+{
+    const gchar *type = g_getenv ("MALGTK_PERF_BUILDTYPE");
+    return type ? type : "unknown";
+}
+
+static void
+record (const gchar *path,
+        const gchar *group,
+        const gchar *name,
+        gdouble      rate)
+{
+    g_autoptr(GKeyFile) key_file = g_key_file_new ();
+    g_autoptr(GError)   error    = NULL;
+    const gchar        *machine  = g_getenv ("MALGTK_PERF_MACHINE");
+    const gchar        *compiler = g_getenv ("MALGTK_PERF_COMPILER");
+
+    /* Start afresh if it isn't there yet */
+    g_key_file_load_from_file (key_file, path, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    g_key_file_set_string (key_file, REFERENCE, "machine", machine ? machine : g_get_host_name ());
+    g_key_file_set_string (key_file, REFERENCE, "buildtype", buildtype ());
+    g_key_file_set_string (key_file, REFERENCE, "compiler", compiler ? compiler : "unknown");
+    g_key_file_set_double (key_file, group, name, rate);
+
+    if (!g_key_file_save_to_file (key_file, path, &error))
+        g_test_message ("Could not record %s/%s in %s: %s", group, name, path, error->message);
+}
+
+void
+malgtk_perf_check (const gchar *group,
+                   const gchar *name,
+                   guint        n_ops,
+                   gdouble      elapsed)
+{
+    g_autoptr(GKeyFile) baseline = g_key_file_new ();
+    g_autoptr(GError)   error    = NULL;
+    g_autofree gchar   *recorded = NULL;
+    const gchar        *path;
+    const gchar        *margin_str;
+    gdouble             rate;
+    gdouble             expected;
+    gdouble             margin   = DEFAULT_MARGIN;
+
+    rate = n_ops / MAX (elapsed, 1e-9);
+    g_test_maximized_result (rate, "%s/%s: %.0f ops/s", group, name, rate);
+
+    path = g_getenv ("MALGTK_PERF_RECORD");
+    if (path)
+        record (path, group, name, rate);
+
+    path = g_getenv ("MALGTK_PERF_BASELINE");
+    if (NULL == path)
+        return;
+
+    if (!g_key_file_load_from_file (baseline, path, G_KEY_FILE_NONE, &error)) {
+        g_test_message ("Could not read baseline %s: %s", path, error->message);
+        g_test_fail ();
+        return;
+    }
+
+    /* Rates only compare against ones measured the same way */
+    recorded = g_key_file_get_string (baseline, REFERENCE, "buildtype", NULL);
+    if (NULL == recorded) {
+        g_test_message ("%s was never recorded; see the comment at its top", path);
+        g_test_fail ();
+        return;
+    }
+    if (0 != g_strcmp0 (recorded, buildtype ())) {
+        g_test_message ("%s was recorded from a %s build, not %s", path, recorded, buildtype ());
+        g_test_fail ();
+        return;
+    }
+
+    expected = g_key_file_get_double (baseline, group, name, &error);
+    if (error) {
+        /* A new case must come with its baseline */
+        g_test_message ("No baseline for %s/%s in %s: %s", group, name, path, error->message);
+        g_test_fail ();
+        return;
+    }
+
+    margin_str = g_getenv ("MALGTK_PERF_MARGIN");
+    if (margin_str)
+        margin = g_ascii_strtod (margin_str, NULL);
+
+    if (rate < expected * (1.0 - margin)) {
+        g_test_message ("%s/%s: %.0f ops/s is more than %.0f%% below the baseline of %.0f ops/s",
+                        group, name, rate, margin * 100, expected);
+        g_test_fail ();
+    }
+}
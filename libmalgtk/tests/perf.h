@@ -0,0 +1,37 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+/* Items each perf case works through */
+#define MALGTK_PERF_N_ITEMS 10000
+
+/* Reports n_ops in elapsed seconds as a throughput for group/name,
+ * as a maximized result in the TAP output.
+ *
+ * The case fails if that is below the rate recorded for it in the
+ * $MALGTK_PERF_BASELINE key file by more than $MALGTK_PERF_MARGIN, a
+ * fraction that defaults to 0.2. It also fails if the file has no
+ * rate for it, or was recorded from a different
+ * $MALGTK_PERF_BUILDTYPE. With $MALGTK_PERF_RECORD set to a key
+ * file, the rate is also stored there along with the machine
+ * ($MALGTK_PERF_MACHINE, or the host name), build type and
+ * $MALGTK_PERF_COMPILER, to make a new baseline.
+ */
+void malgtk_perf_check (const gchar *group, const gchar *name, guint n_ops, gdouble elapsed);
@@ -291,6 +291,21 @@ namespace MAL {
         return std::make_shared<Anime>(*this);
     }
 
+    bool
+    Anime::equals(const MALItem& other) const
+    {
+        auto const& o = static_cast<const Anime&>(other);
+        return MALItem::equals(other)
+            && series_type     == o.series_type
+            && series_status   == o.series_status
+            && series_episodes == o.series_episodes
+            && status          == o.status
+            && episodes        == o.episodes
+            && rewatch_episode == o.rewatch_episode
+            && storage_type    == o.storage_type
+            && storage_value   == o.storage_value;
+    }
+
     void
     Anime::serialize(XmlWriter& writer) const
     {
@@ -88,15 +88,16 @@ namespace MAL {
         Anime();
         Anime(XmlReader& reader);
         virtual std::shared_ptr<MALItem> clone() const override;
+        virtual bool equals(const MALItem& other) const override;
         virtual void serialize(XmlWriter&) const override;
         
         SeriesType            series_type;
         SeriesStatus          series_status;
-        int_fast16_t          series_episodes;
+        std::int32_t          series_episodes;
 
         AnimeStatus           status;          // We know how to serialize /
-        int_fast16_t          episodes;        // deserialize these fields
-        int_fast16_t          rewatch_episode; //
+        std::int32_t          episodes;        // deserialize these fields
+        std::int32_t          rewatch_episode; //
 
         AnimeStorageType      storage_type;    // We know how to serialize
         float                 storage_value;   // these fields, but not
@@ -19,9 +19,9 @@
 #include <cstring>
 #include <memory>
 #include <libxml/xmlreader.h>
-#include <libxml/HTMLparser.h>
 #include "anime_serializer.hpp"
 #include "xml_writer.hpp"
+#include "html_form_scanner.hpp"
 
 namespace MAL {
 	enum FIELDS : int_fast8_t { FIELDNONE, FIELDTEXT,
@@ -117,35 +117,12 @@ namespace {
 		}
 	};
 
-    struct htmlParserCtxtDeleter {
-        void operator()(htmlParserCtxtPtr parser) const {
-            htmlFreeParserCtxt (parser);
-        }
-    };
-
-    struct XmlCharDeleter {
-        void operator()(xmlChar* str) const {
-            if (str) xmlFree(str);
-        }
-    };
-
-    struct XmlDocDeleter {
-        void operator()(xmlDocPtr doc) const {
-            if (doc) xmlFreeDoc(doc);
-        }
-    };
-
     static std::string xmlchar_to_str(const xmlChar* str) {
 		if (str)
 			return std::string(reinterpret_cast<const char*>(str));
 		else
 			return std::string();
 	}
-
-    constexpr const xmlChar* operator"" _xml(const char* str, size_t) {
-        return reinterpret_cast<const xmlChar*>(str);
-    }
-
 }
 
 namespace MAL {
@@ -247,107 +224,29 @@ namespace MAL {
 
     /** Parse the 'detailed' Anime fields from HTML
      *
-     * 
+     * Returns nullptr if the page could not be parsed.
      */
     std::shared_ptr<Anime> AnimeSerializer::deserialize_details(const std::string& xml) const
     {
-        typedef std::unique_ptr<xmlChar, XmlCharDeleter> xmlStringUPtr;
         auto res = std::make_shared<Anime>();
-		std::unique_ptr<char[]> cstr(new char[xml.size()]);
-		std::memcpy(cstr.get(), xml.c_str(), xml.size());
-        std::unique_ptr<xmlDoc, XmlDocDeleter> doc(htmlReadMemory(cstr.get(), xml.size(), "http://myanimelist.net/",
-                                                                   nullptr, HTML_PARSE_RECOVER
-                                                                   | HTML_PARSE_NOERROR 
-                                                                   | HTML_PARSE_NOWARNING
-                                                                   | HTML_PARSE_NONET));
-		std::unique_ptr<xmlTextReader, xmlTextReaderDeleter> reader(xmlReaderWalker(doc.get()));
-		if (!reader) {
-			std::cerr << "Error: Couldn't create XML reader" << std::endl;
-            std::cerr << "XML follows: " << xml << std::endl;
+        Anime& anime = *res;
+
+        HtmlFormScanner scanner;
+        scanner.input("fansub_group",        [&anime](std::string&& v) { anime.set_fansub_group(std::move(v)); });
+        scanner.input("list_downloaded_eps", [&anime](std::string&& v) { anime.set_downloaded_items(std::move(v)); });
+        scanner.input("list_times_watched",  [&anime](std::string&& v) { anime.set_times_consumed(std::move(v)); });
+        scanner.input("storageVal",          [&anime](std::string&& v) { anime.set_storage_value(std::move(v)); });
+        scanner.select("priority",           [&anime](std::string&& v) { anime.set_priority(std::move(v)); });
+        scanner.select("storage",            [&anime](std::string&& v) { anime.set_storage_type(std::move(v)); });
+        scanner.select("list_rewatch_value", [&anime](std::string&& v) { anime.set_reconsume_value(std::move(v)); });
+        scanner.select("discuss",            [&anime](std::string&& v) { anime.set_enable_discussion(std::move(v)); });
+        scanner.textarea("list_comments",    [&anime](std::string&& v) { anime.set_comments(std::move(v)); });
+
+        if (!scanner.scan(xml)) {
+			std::cerr << "Error: Couldn't parse the details page" << std::endl;
 			return nullptr;
-		}
-        
-        enum { PRIORITY, STORAGE, REWATCHVALUE, DISCUSS, SELECTOR_NONE } selector = SELECTOR_NONE;
-        enum { TAGS, COMMENTS, NONE } textarea = NONE;
-        std::string textbuf;
-        int ret = 1;
-		for( ret = xmlTextReaderRead(reader.get()); ret == 1;
-		     ret = xmlTextReaderRead(reader.get()) ) {
-			const std::string name  = xmlchar_to_str(xmlTextReaderConstName (reader.get()));
-
-            if (name == "input") {
-                xmlStringUPtr type(xmlTextReaderGetAttribute(reader.get(), "type"_xml));
-                xmlStringUPtr attr_name(xmlTextReaderGetAttribute(reader.get(), "name"_xml));
-                xmlStringUPtr attr_value(xmlTextReaderGetAttribute(reader.get(), "value"_xml));
-                if (type) {
-                    if (xmlStrEqual(type.get(), "text"_xml) || xmlStrEqual(type.get(), "checkbox"_xml)) {
-                        if (xmlStrEqual(attr_name.get(), "fansub_group"_xml))
-                            res->set_fansub_group(xmlchar_to_str(attr_value.get()));
-                        else if (xmlStrEqual(attr_name.get(), "list_downloaded_eps"_xml))
-                            res->set_downloaded_items(xmlchar_to_str(attr_value.get()));
-                        else if (xmlStrEqual(attr_name.get(), "list_times_watched"_xml))
-                            res->set_times_consumed(xmlchar_to_str(attr_value.get()));
-                        else if (xmlStrEqual(attr_name.get(), "storageVal"_xml))
-                            res->set_storage_value(xmlchar_to_str(attr_value.get()));
-                    }
-                }
-            } else if (name == "textarea" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
-                xmlStringUPtr attr_name(xmlTextReaderGetAttribute(reader.get(), "name"_xml));
-                if (xmlStrEqual(attr_name.get(), "tags"_xml)) textarea = TAGS;
-                else if (xmlStrEqual(attr_name.get(), "list_comments"_xml)) textarea = COMMENTS;
-                else textarea = NONE;
-                textbuf.clear();
-            } else if (name == "textarea" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_END_ELEMENT) {
-                if (textarea != NONE) {
-                    switch (textarea) {
-                        case TAGS:
-                            /* Not a 'detailed' field */
-                            break;
-                        case COMMENTS:
-                            res->set_comments(std::string(textbuf));
-                            break;
-                        case NONE:
-                        default:
-                            break;
-                    }
-                    textarea = NONE;
-                }
-            } else if (name == "#text" && textarea != NONE) {
-                textbuf.append(xmlchar_to_str(xmlTextReaderConstValue(reader.get())));
-            } else if (name == "select" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
-                xmlStringUPtr attr_name(xmlTextReaderGetAttribute(reader.get(), "name"_xml));
-                if (xmlStrEqual(attr_name.get(), "priority"_xml)) selector = PRIORITY;
-                if (xmlStrEqual(attr_name.get(), "storage"_xml)) selector = STORAGE;
-                if (xmlStrEqual(attr_name.get(), "list_rewatch_value"_xml)) selector = REWATCHVALUE;
-                if (xmlStrEqual(attr_name.get(), "discuss"_xml)) selector = DISCUSS;                
-            } else if (name == "select" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_END_ELEMENT)  {
-                selector = SELECTOR_NONE;
-            } else if (name == "option" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
-                xmlStringUPtr value(xmlTextReaderGetAttribute(reader.get(), "value"_xml));
-                if (xmlTextReaderMoveToAttribute(reader.get(), "selected"_xml) == 1) {
-                    switch (selector) {
-                        case PRIORITY:
-                            res->set_priority(xmlchar_to_str(value.get()));
-                            break;
-                        case STORAGE:
-                            res->set_storage_value(xmlchar_to_str(value.get()));
-                            break;
-                        case REWATCHVALUE:
-                            res->set_reconsume_value(xmlchar_to_str(value.get()));
-                            break;
-                        case DISCUSS:
-                            res->set_enable_discussion(xmlchar_to_str(value.get()));
-                            break;
-                        case SELECTOR_NONE:
-                        default:
-                            break;
-                    }
-                }
-            }
         }
 
-        if (ret != 0) return nullptr; // Some sort of parsing error
-        
         return res;
     }
 
@@ -365,14 +264,12 @@ namespace MAL {
             writer.writeElement("times_rewatched", std::to_string(anime.times_consumed));
             writer.writeElement("rewatch_value",   std::to_string(static_cast<int>(anime.reconsume_value)));
         }
-        auto start = Glib::Date();
-        start.set_parse(anime.date_start);
+        auto start = anime.date_start.to_glib_date();
         if (start.valid()) {
             writer.writeElement("date_start", start.format_string("%m%d%Y"));
         }
 
-        auto finish = Glib::Date();
-        finish.set_parse(anime.date_finish);
+        auto finish = anime.date_finish.to_glib_date();
         if (finish.valid()) {
             writer.writeElement("date_finish", finish.format_string("%m%d%Y"));
         }
@@ -384,7 +281,7 @@ namespace MAL {
         writer.writeElement("enable_rewatching", anime.enable_reconsuming?"1":"0");
         if (anime.has_details) {
             writer.writeElement("comments", anime.comments);
-            writer.writeElement("fansub_group", anime.fansub_group);
+            writer.writeElement("fansub_group", anime.fansub_group.str());
         }
 
         std::string tags;
@@ -393,7 +290,7 @@ namespace MAL {
 		while (iter != anime.tags.end()) {
 			if (!was_first)
 				tags += ", ";
-			tags += *iter;
+			tags += iter->str();
 			was_first = false;
 			++iter;
 		}
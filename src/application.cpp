@@ -20,6 +20,7 @@
 #include "application.hpp"
 #include "mal.hpp"
 #include "user_info.hpp"
+#include "latency_monitor.hpp"
 
 namespace MAL {
 	Application::Application(int& argc, char**& argv) :
@@ -31,10 +32,30 @@ namespace MAL {
         action->signal_activate().connect(sigc::hide(sigc::mem_fun(app.operator->(), &Gtk::Application::quit)));
         app->add_action(action);
         app->add_accelerator("<Control>q", "app.quit", nullptr);
+
+        auto requests = Gio::SimpleAction::create("requests");
+        requests->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &Application::show_request_trace)));
+        app->add_action(requests);
+        app->add_accelerator("<Control><Shift>r", "app.requests", nullptr);
+	}
+
+	void Application::show_request_trace() {
+		if (!request_trace_window) {
+			request_trace_window.reset(new RequestTraceWindow(mal));
+			request_trace_window->set_transient_for(window);
+			app->add_window(*request_trace_window);
+		} else {
+			request_trace_window->refresh();
+		}
+		request_trace_window->present();
 	}
 
 	int Application::run() {
-		return app->run(window);
+		auto& monitor = LatencyMonitor::get();
+		monitor.start();
+		const int status = app->run(window);
+		monitor.stop();
+		return status;
 	}
 
 }
@@ -17,6 +17,7 @@
 
 #include <gtkmm/application.h>
 #include "gui/main_window.hpp"
+#include "gui/request_trace_window.hpp"
 #include "mal.hpp"
 
 namespace MAL {
@@ -32,6 +33,9 @@ namespace MAL {
 		Glib::RefPtr<Gtk::Application> app;
 		std::shared_ptr<MAL> mal;
 		MainWindow window;
+		std::unique_ptr<RequestTraceWindow> request_trace_window;
+
+		void show_request_trace();
 
 	};
 	
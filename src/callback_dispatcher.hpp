@@ -16,10 +16,17 @@
  */
 
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <mutex>
-#include <queue>
+#include <unordered_map>
+#include <vector>
 #include <functional>
+#include <glib.h>
 #include <glibmm/dispatcher.h>
+#include <glibmm/main.h>
+#include "latency_monitor.hpp"
 
 namespace MAL {
 
@@ -27,19 +34,33 @@ namespace MAL {
      *
      * To execute a callback on the GTK+ main thread, bind the
      * parameters to Functor fn and then call send(fn).
+     *
+     * Senders only hold the lock long enough to append to a vector,
+     * which the main thread swaps out before running anything.
+     * Callbacks run outside the lock, in the order they were sent,
+     * for at most budget_us per main loop iteration; the rest run
+     * from an idle handler so redraws are not held off.
      */
     class CallbackDispatcher {
     public:
         typedef std::function<void ()> Callback;
+        typedef std::uint64_t          Key;
 
         CallbackDispatcher(const CallbackDispatcher&) = delete;
         CallbackDispatcher& operator=(const CallbackDispatcher&) = delete;
 
-        CallbackDispatcher() {
+        CallbackDispatcher() :
+            m_next_key(1),
+            m_notified(false)
+        {
             m_dispatcher.connect(sigc::mem_fun(*this,
                                                &CallbackDispatcher::on_dispatch));
         };
 
+        ~CallbackDispatcher() {
+            m_idle.disconnect();
+        }
+
         /** Sends a 0 argument functor to be executed on the GTK+ main
          * thread.
          *
@@ -50,22 +71,107 @@ namespace MAL {
          */
         template<typename Fn>
         void send(Fn&& fn) {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_msgs.push(std::forward<Fn>(fn));
-            m_dispatcher();
+            push(0, Callback(std::forward<Fn>(fn)));
+        }
+
+        /** Returns a key no other caller of make_key() will get, for
+         * send(key, fn). Take one per request, not per kind of
+         * callback, so two requests never drop each other's updates.
+         */
+        Key make_key() {
+            return m_next_key.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /** As send(), but drops any callback sent with the same key
+         * that the main thread has not picked up yet.
+         *
+         * For callbacks where only the latest matters, such as
+         * download progress. key comes from make_key(). fn runs
+         * where it was sent, after everything sent before it.
+         */
+        template<typename Fn>
+        void send(Key key, Fn&& fn) {
+            push(key, Callback(std::forward<Fn>(fn)));
+        }
+
+        /** Same as send(), so a Future can continue on the GTK+ main
+         * thread with future.then(callback_dispatcher, fn).
+         */
+        void post(Callback callback) {
+            push(0, std::move(callback));
         }
 
     private:
-        std::queue<Callback> m_msgs;
-        mutable std::mutex   m_mutex;
-        Glib::Dispatcher     m_dispatcher;
+        /* Time spent running callbacks per main loop iteration, half
+         * a 60 Hz frame */
+        static constexpr gint64 budget_us = G_USEC_PER_SEC / 120;
+
+        std::atomic<Key>                             m_next_key;
+
+        /* Guarded by m_mutex */
+        std::mutex                                   m_mutex;
+        std::vector<Callback>                        m_incoming;
+        std::unordered_map<Key, std::size_t>         m_keyed; /* Index into m_incoming */
+        bool                                         m_notified;
+
+        /* Main thread only */
+        std::deque<Callback>                         m_backlog;
+        sigc::connection                             m_idle;
+        Glib::Dispatcher                             m_dispatcher;
+
+        void push(Key key, Callback&& callback) {
+            bool notify;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (key) {
+                    auto keyed = m_keyed.emplace(key, m_incoming.size());
+                    if (!keyed.second) {
+                        m_incoming[keyed.first->second] = nullptr;
+                        keyed.first->second = m_incoming.size();
+                    }
+                }
+                m_incoming.push_back(std::move(callback));
+                notify = !m_notified;
+                m_notified = true;
+            }
+
+            /* One wakeup per batch, not per callback */
+            if (notify)
+                m_dispatcher();
+        }
 
         void on_dispatch() {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            while (!m_msgs.empty()) {
-                m_msgs.front()();
-                m_msgs.pop();
+            std::vector<Callback> incoming;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                incoming.swap(m_incoming);
+                m_keyed.clear();
+                m_notified = false;
+            }
+
+            for (auto& callback : incoming) {
+                if (callback)
+                    m_backlog.push_back(std::move(callback));
+            }
+
+            if (run_backlog() && !m_idle.connected())
+                m_idle = Glib::signal_idle().connect(sigc::mem_fun(*this, &CallbackDispatcher::run_backlog));
+        }
+
+        /* Returns true while callbacks are left, as an idle handler */
+        bool run_backlog() {
+            const gint64 deadline = g_get_monotonic_time() + budget_us;
+            while (!m_backlog.empty()) {
+                auto callback = std::move(m_backlog.front());
+                m_backlog.pop_front();
+                {
+                    LatencyMonitor::Scope scope("CallbackDispatcher callback");
+                    callback();
+                }
+                if (g_get_monotonic_time() >= deadline)
+                    break;
             }
+            return !m_backlog.empty();
         }
     };
 }
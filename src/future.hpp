@@ -0,0 +1,253 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace MAL {
+
+    template<typename T> class Future;
+
+    namespace detail {
+        /* Stands in for the value of a Future<void> */
+        struct Unit {};
+
+        template<typename T> struct Stored       { typedef T    type; };
+        template<>           struct Stored<void> { typedef Unit type; };
+
+        template<typename T>
+        class SharedState {
+        public:
+            typedef typename Stored<T>::type value_type;
+
+            SharedState() : m_ready(false), m_handed_on(false) {}
+
+            /* Nothing took the error, so nobody else will report it */
+            ~SharedState() {
+                if (!m_error || m_handed_on)
+                    return;
+
+                try {
+                    std::rethrow_exception(m_error);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Uncaught exception in task: " << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "Error: Uncaught exception in task" << std::endl;
+                }
+            }
+
+            void set_value(value_type&& value) {
+                complete([&] { m_value.reset(new value_type(std::move(value))); });
+            }
+
+            void set_error(std::exception_ptr error) {
+                complete([&] { m_error = error; });
+            }
+
+            /* Runs fn on the completing thread, or now if already
+             * complete. Only one continuation is supported. */
+            void on_ready(std::function<void ()>&& fn) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_ready) {
+                        m_continuation = std::move(fn);
+                        return;
+                    }
+                }
+                fn();
+            }
+
+            void wait() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this] { return m_ready; });
+            }
+
+            /* Only valid once ready, and only once */
+            value_type take() {
+                m_handed_on = true;
+                if (m_error)
+                    std::rethrow_exception(m_error);
+                return std::move(*m_value);
+            }
+
+            bool has_error() const { return static_cast<bool>(m_error); }
+
+            /* Only valid once ready */
+            std::exception_ptr take_error() {
+                m_handed_on = true;
+                return m_error;
+            }
+
+        private:
+            std::mutex                  m_mutex;
+            std::condition_variable     m_cond;
+            bool                        m_ready;
+            std::unique_ptr<value_type> m_value;
+            std::exception_ptr          m_error;
+            bool                        m_handed_on; /* take() or take_error() was called */
+            std::function<void ()>      m_continuation;
+
+            template<typename Fn>
+            void complete(Fn&& store) {
+                std::function<void ()> continuation;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    store();
+                    m_ready = true;
+                    continuation.swap(m_continuation);
+                }
+                m_cond.notify_all();
+                if (continuation)
+                    continuation();
+            }
+        };
+
+        /* Calls fn with args and stores the result, or the
+         * exception, in state */
+        template<typename R>
+        struct Fulfil {
+            template<typename Fn, typename... Args>
+            static void run(SharedState<R>& state, Fn& fn, Args&&... args) {
+                try {
+                    state.set_value(fn(std::forward<Args>(args)...));
+                } catch (...) {
+                    state.set_error(std::current_exception());
+                }
+            }
+        };
+
+        template<>
+        struct Fulfil<void> {
+            template<typename Fn, typename... Args>
+            static void run(SharedState<void>& state, Fn& fn, Args&&... args) {
+                try {
+                    fn(std::forward<Args>(args)...);
+                    state.set_value(Unit());
+                } catch (...) {
+                    state.set_error(std::current_exception());
+                }
+            }
+        };
+
+        /* Passes the value of a ready state on to a continuation,
+         * or no value for Future<void> */
+        template<typename T>
+        struct Continue {
+            template<typename Fn>
+            using result = typename std::result_of<Fn&(T&&)>::type;
+
+            template<typename R, typename Fn>
+            static void run(SharedState<T>& from, SharedState<R>& to, Fn& fn) {
+                T value = from.take();
+                Fulfil<R>::run(to, fn, std::move(value));
+            }
+        };
+
+        template<>
+        struct Continue<void> {
+            template<typename Fn>
+            using result = typename std::result_of<Fn&()>::type;
+
+            template<typename R, typename Fn>
+            static void run(SharedState<void>&, SharedState<R>& to, Fn& fn) {
+                Fulfil<R>::run(to, fn);
+            }
+        };
+    }
+
+    /** The result of a task that may not have finished yet.
+     *
+     * Chain work onto it with then(), naming where the continuation
+     * runs: a WorkStealingPool, an IOExecutor, or the
+     * CallbackDispatcher for the GTK+ main thread. If a task throws,
+     * the continuations after it are skipped and get() rethrows; an
+     * exception nothing takes is printed to std::cerr.
+     */
+    template<typename T>
+    class Future {
+    public:
+        typedef detail::SharedState<T> State;
+
+        Future() = default;
+        explicit Future(std::shared_ptr<State> state) :
+            m_state(std::move(state))
+        {
+        }
+
+        bool valid() const { return static_cast<bool>(m_state); }
+
+        /** Blocks until the value is ready and returns it. Never call
+         * this on the thread that would complete it.
+         */
+        typename State::value_type get() {
+            auto state = std::move(m_state);
+            state->wait();
+            return state->take();
+        }
+
+        /** Runs fn(value) with exec once the value is ready, and
+         * returns a Future for what fn returns.
+         *
+         * Exec is anything with post(std::function<void ()>).
+         */
+        template<typename Exec, typename Fn>
+        Future<typename detail::Continue<T>::template result<Fn> > then(Exec& exec, Fn fn) {
+            typedef typename detail::Continue<T>::template result<Fn> R;
+
+            auto from = std::move(m_state);
+            auto to   = std::make_shared<detail::SharedState<R> >();
+            auto raw  = from.get();
+            raw->on_ready([&exec, from, to, fn] () mutable {
+                if (from->has_error()) {
+                    to->set_error(from->take_error());
+                    return;
+                }
+
+                exec.post([from, to, fn] () mutable {
+                    detail::Continue<T>::run(*from, *to, fn);
+                });
+            });
+
+            return Future<R>(to);
+        }
+
+    private:
+        std::shared_ptr<State> m_state;
+    };
+
+    /** Runs fn() with exec and returns a Future for its result.
+     */
+    template<typename Exec, typename Fn>
+    Future<typename std::result_of<Fn&()>::type> run_async(Exec& exec, Fn fn)
+    {
+        typedef typename std::result_of<Fn&()>::type R;
+
+        auto state = std::make_shared<detail::SharedState<R> >();
+        exec.post([state, fn] () mutable {
+            detail::Fulfil<R>::run(*state, fn);
+        });
+
+        return Future<R>(state);
+    }
+}
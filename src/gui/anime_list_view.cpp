@@ -447,6 +447,7 @@ namespace MAL {
         auto const status = anime_status(row.get_value(columns->status));
         if (status != anime->status) {
             is_changed = true;
+            detach_row_from_store(row);
             new_anime->status = status;
             row.set_value(columns->item, std::static_pointer_cast<MALItem>(new_anime));
             row.set_value(columns->anime, new_anime);
@@ -527,10 +528,11 @@ namespace MAL {
         m_list_view(list_view),
         m_detail_view(detail_view),
         m_status_combo(Gtk::manage(new AnimeStatusComboBox(true))),
-        last_pulse(g_get_monotonic_time())
+        last_pulse(g_get_monotonic_time()),
+        m_filter_status(AnimeStatus::WATCHING)
     {
         m_list_view->set_visible_func(sigc::mem_fun(this, &AnimeFilteredListPage::m_visible_func));
-        m_status_combo->signal_changed().connect(sigc::mem_fun(static_cast<MALItemListViewBase*>(m_list_view), &MALItemListViewEditable::refilter));
+        m_status_combo->signal_changed().connect(sigc::mem_fun(*this, &AnimeFilteredListPage::on_status_changed));
 
         auto label = Gtk::manage(new Gtk::Label("Filter: "));
         m_button_row->attach(*m_status_combo, -1, 0, 1, 1);
@@ -538,7 +540,7 @@ namespace MAL {
         m_status_combo->set_hexpand(true);
         m_status_combo->set_anime_status(AnimeStatus::WATCHING);
         m_status_combo->show();
-        mal->signal_anime_added.connect(sigc::mem_fun(*this, &AnimeFilteredListPage::on_mal_update));
+        mal->signal_anime_changed.connect(sigc::mem_fun(*this, &AnimeFilteredListPage::on_mal_changed));
     }
 
     bool AnimeFilteredListPage::m_filter_func(const std::shared_ptr<MALItem>& item) const
@@ -549,26 +551,42 @@ namespace MAL {
 
     bool AnimeFilteredListPage::m_visible_func(const Gtk::TreeModel::const_iterator& iter) const
     {
+        if (G_UNLIKELY(m_filter_status == AnimeStatus::NONE))
+            return true;
+
+        const auto index = m_list_view->store_row(iter);
+        if (G_LIKELY(index < m_status_mask.size()))
+            return m_status_mask[index];
+
+        /* Row was edited since the store was built */
         auto anime = iter->get_value(m_columns->anime);
-        if (G_LIKELY(anime)) {
-            auto status = m_status_combo->get_anime_status();
-            if (G_UNLIKELY(status == AnimeStatus::NONE))
-                return true;
-            else
-                return status == anime->status;
-        } else {
+        if (G_LIKELY(anime))
+            return m_filter_status == anime->status;
+        else
             return true;
-        }
+    }
+
+    void AnimeFilteredListPage::update_status_mask()
+    {
+        m_filter_status = m_status_combo->get_anime_status();
+        if (m_store && m_filter_status != AnimeStatus::NONE)
+            m_store->match_status(m_filter_status, m_status_mask);
+        else
+            m_status_mask.clear();
+    }
+
+    void AnimeFilteredListPage::on_status_changed()
+    {
+        update_status_mask();
+        m_list_view->refilter();
     }
 
     void AnimeFilteredListPage::refresh()
     {
-        auto complete_cb = [this](bool success) { 
+        auto complete_cb = [this](bool) {
             m_refresh_button->set_sensitive(true);
             m_refresh_button->show();
             m_progressbar->hide();
-            if (success)
-                on_mal_update();
         };
 
         auto prog_cb = [this](int_fast64_t bytes) {
@@ -588,7 +606,19 @@ namespace MAL {
 
     void AnimeFilteredListPage::on_mal_update()
     {
-        using std::placeholders::_1;
-        m_list_view->refresh_items(std::bind(&MAL::for_each_anime, m_mal, _1));
+        m_store = m_mal->anime_columns();
+        update_status_mask();
+        m_list_view->refresh_items(m_store);
+    }
+
+    void AnimeFilteredListPage::on_mal_changed(const ItemChanges& changes)
+    {
+        if (!m_list_view->has_store()) {
+            on_mal_update();
+        } else {
+            m_store = m_mal->anime_columns();
+            update_status_mask();
+            m_list_view->apply_changes(m_store, changes);
+        }
     }
 }
@@ -261,8 +261,16 @@ namespace MAL {
         AnimeStatusComboBox *m_status_combo;
         gint64 last_pulse;
 
+        /* Status filter evaluated over the store's status column */
+        std::shared_ptr<const AnimeColumns> m_store;
+        std::vector<std::uint8_t>           m_status_mask;
+        AnimeStatus                         m_filter_status;
+
         bool m_filter_func(const std::shared_ptr<MALItem>&) const;
         bool m_visible_func(const Gtk::TreeModel::const_iterator& iter) const;
+        void on_status_changed();
+        void update_status_mask();
+        void on_mal_changed(const ItemChanges& changes);
 
     };
 }
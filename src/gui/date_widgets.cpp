@@ -20,16 +20,10 @@
 #include <iostream>
 
 namespace {
-    Glib::ustring mal_date_to_locale(const std::string& date)
+    Glib::ustring mal_date_to_locale(const MAL::ItemDate& date)
     {
-        int year = 0, month = 0, day = 0;
-        try {
-            year  = std::stoi(date.substr(0,4));
-            month = std::stoi(date.substr(5,2));
-            day   = std::stoi(date.substr(8,2));
-        } catch (std::exception e) {
-        }
-        
+        const int year = date.year(), month = date.month(), day = date.day();
+
         if (year > 0 && month > 0 && day > 0) {
             if (Glib::Date::valid_dmy(day, static_cast<Glib::Date::Month>(month), year)) {
                 const Glib::Date d(day, static_cast<Glib::Date::Month>(month), year);
@@ -64,6 +58,11 @@ namespace MAL {
      * Returns true if the date was valid in some fashion.
      */
     bool DateLabel::set_date(const std::string& date)
+    {
+        return set_date(ItemDate::parse(date));
+    }
+
+    bool DateLabel::set_date(const ItemDate& date)
     {
         auto str = mal_date_to_locale(date);
         const bool ret = !(str.compare("Unknown") == 0);
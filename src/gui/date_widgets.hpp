@@ -19,6 +19,7 @@
 #include <gtkmm/label.h>
 #include <gtkmm/entry.h>
 #include <glibmm/date.h>
+#include "item_date.hpp"
 
 namespace MAL {
 
@@ -27,6 +28,7 @@ namespace MAL {
         DateLabel(const Glib::ustring& prefix);
 
         bool set_date(const std::string&);
+        bool set_date(const ItemDate&);
 
     private:
         Glib::ustring m_prefix;
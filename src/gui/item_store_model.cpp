@@ -0,0 +1,632 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "item_store_model.hpp"
+#include "latency_monitor.hpp"
+#include <algorithm>
+#include <climits>
+#include <glibmm/main.h>
+
+namespace {
+    template <typename T>
+    static inline void set_cell(Glib::ValueBase& value, const T& data)
+    {
+        Glib::Value<T> typed;
+        typed.init(Glib::Value<T>::value_type());
+        typed.set(data);
+        value.init(typed.gobj());
+    }
+}
+
+namespace MAL {
+
+    constexpr gsize ItemStoreModel::not_visible;
+    constexpr gint64 ItemStoreModel::populate_budget_us;
+
+    Glib::RefPtr<ItemStoreModel> ItemStoreModel::create(const Gtk::TreeModelColumnRecord&                     columns,
+                                                        const Gtk::TreeModelColumn<gint64>&                   series_itemdb_id,
+                                                        const Gtk::TreeModelColumn<guint>&                    store_index,
+                                                        const Gtk::TreeModelColumn<std::shared_ptr<MALItem> >& item,
+                                                        const SlotFill&                                       fill)
+    {
+        return Glib::RefPtr<ItemStoreModel>(new ItemStoreModel(columns, series_itemdb_id, store_index, item, fill));
+    }
+
+    ItemStoreModel::ItemStoreModel(const Gtk::TreeModelColumnRecord&                     columns,
+                                   const Gtk::TreeModelColumn<gint64>&                   series_itemdb_id,
+                                   const Gtk::TreeModelColumn<guint>&                    store_index,
+                                   const Gtk::TreeModelColumn<std::shared_ptr<MALItem> >& item,
+                                   const SlotFill&                                       fill) :
+        Glib::ObjectBase (typeid(ItemStoreModel)),
+        Glib::Object     (),
+        m_column_types   (columns.types(), columns.types() + columns.size()),
+        m_id_column      (series_itemdb_id.index()),
+        m_index_column   (store_index.index()),
+        m_item_column    (item.index()),
+        m_fill           (fill),
+        m_sort_column    (Gtk::TreeSortable::DEFAULT_SORT_COLUMN_ID),
+        m_sort_order     (Gtk::SORT_ASCENDING),
+        m_stamp          (1),
+        m_pending_next   (0),
+        m_scratch        (columns.size()),
+        m_scratch_index  (MALItemColumns::npos),
+        m_filling        (false)
+    {
+        for (std::size_t column = 0; column < m_scratch.size(); ++column)
+            m_scratch[column].init(m_column_types[column]);
+    }
+
+    ItemStoreModel::~ItemStoreModel()
+    {
+        m_recheck_connection.disconnect();
+        m_populate_connection.disconnect();
+    }
+
+    /* Rows */
+
+    void ItemStoreModel::set_store(const std::shared_ptr<const MALItemColumns>& store)
+    {
+        reset(store);
+        publish_pending(m_pending.size());
+    }
+
+    void ItemStoreModel::populate(const std::shared_ptr<const MALItemColumns>& store, std::size_t first_rows)
+    {
+        reset(store);
+        publish_pending(first_rows);
+        if (has_pending()) {
+            /* Redraws run at a higher priority than default idle, so
+             * the view is painted between slices */
+            m_populate_connection = Glib::signal_idle().connect(sigc::mem_fun(*this, &ItemStoreModel::on_populate_idle));
+        }
+    }
+
+    void ItemStoreModel::reset(const std::shared_ptr<const MALItemColumns>& store)
+    {
+        m_populate_connection.disconnect();
+        m_pending.clear();
+        m_pending_next = 0;
+
+        invalidate_iters();
+        while (!m_rows.empty()) {
+            m_rows.pop_back();
+            row_deleted(make_path(m_rows.size()));
+        }
+
+        m_store = store;
+        m_positions.assign(m_store ? m_store->size() : 0, not_visible);
+        m_edits.clear();
+        m_edited_rows.clear();
+        m_scratch_index = MALItemColumns::npos;
+        if (!m_store)
+            return;
+
+        /* Sorted once here; publishing only appends */
+        m_pending.reserve(m_store->size());
+        for (std::size_t index = 0; index < m_store->size(); ++index) {
+            if (is_visible(index))
+                m_pending.push_back(static_cast<guint>(index));
+        }
+        std::stable_sort(m_pending.begin(), m_pending.end(), [this](guint a, guint b) {
+                return is_sorted_before(a, b);
+            });
+        m_rows.reserve(m_pending.size());
+    }
+
+    void ItemStoreModel::publish_pending(std::size_t n)
+    {
+        const auto last = std::min(m_pending.size(), m_pending_next + std::min(n, m_pending.size()));
+        for (; m_pending_next < last; ++m_pending_next) {
+            const auto index = m_pending[m_pending_next];
+            m_positions[index] = m_rows.size();
+            m_rows.push_back(index);
+            row_inserted(make_path(m_rows.size() - 1), make_iter(index, m_rows.size() - 1));
+        }
+
+        if (!has_pending()) {
+            m_populate_connection.disconnect();
+            std::vector<guint>().swap(m_pending);
+            m_pending_next = 0;
+        }
+    }
+
+    void ItemStoreModel::finish_populating()
+    {
+        if (has_pending())
+            publish_pending(m_pending.size());
+    }
+
+    bool ItemStoreModel::on_populate_idle()
+    {
+        /* Rows per clock check */
+        constexpr std::size_t slice = 64;
+
+        LatencyMonitor::Scope scope("ItemStoreModel populate slice");
+        const gint64 deadline = g_get_monotonic_time() + populate_budget_us;
+        do {
+            publish_pending(slice);
+        } while (has_pending() && g_get_monotonic_time() < deadline);
+
+        return has_pending();
+    }
+
+    void ItemStoreModel::clear()
+    {
+        set_store(nullptr);
+    }
+
+    void ItemStoreModel::apply_changes(const std::shared_ptr<const MALItemColumns>& store, const ItemChanges& changes)
+    {
+        if (!m_store || !store) {
+            set_store(store);
+            return;
+        }
+
+        finish_populating();
+
+        /* Drop removed rows while the old store still describes them */
+        for (auto const id : changes.removed) {
+            drop_edits(id);
+            auto const index = m_store->index_of(id);
+            if (index == MALItemColumns::npos)
+                continue;
+            auto const position = position_of(index);
+            if (position != not_visible)
+                erase_row(position);
+        }
+
+        /* store may be newer than changes, so every row is looked up
+         * again. Items keep their index unless something before them
+         * was inserted or removed, which resolve() checks first. */
+        std::vector<std::size_t> remapped(m_rows.size());
+        for (std::size_t position = 0; position < m_rows.size(); ++position)
+            remapped[position] = store->resolve(m_rows[position], m_store->series_itemdb_id[m_rows[position]]);
+        for (std::size_t position = m_rows.size(); position-- > 0;) {
+            if (remapped[position] == MALItemColumns::npos) {
+                erase_row(position);
+                remapped.erase(remapped.begin() + position);
+            }
+        }
+
+        m_store = store;
+        m_scratch_index = MALItemColumns::npos;
+        invalidate_iters();
+        std::copy(remapped.cbegin(), remapped.cend(), m_rows.begin());
+        m_positions.assign(m_store->size(), not_visible);
+        update_positions(0);
+
+        auto refresh = [this](int_fast64_t id) {
+            drop_edits(id);
+            auto const index = m_store->index_of(id);
+            if (index == MALItemColumns::npos)
+                return;
+
+            auto position = position_of(index);
+            const bool visible = is_visible(index);
+            if (position == not_visible) {
+                if (visible)
+                    insert_row(index);
+            } else if (!visible) {
+                erase_row(position);
+            } else {
+                position = reposition_row(position);
+                row_changed(make_path(position), make_iter(index, position));
+            }
+        };
+        std::for_each(changes.inserted.cbegin(), changes.inserted.cend(), refresh);
+        std::for_each(changes.updated.cbegin(), changes.updated.cend(), refresh);
+    }
+
+    void ItemStoreModel::refilter()
+    {
+        if (!m_store)
+            return;
+        finish_populating();
+
+        LatencyMonitor::Scope scope("ItemStoreModel::refilter");
+        enum : std::uint8_t { UNSEEN, SHOWN, HIDDEN };
+        std::vector<std::uint8_t> seen(m_store->size(), UNSEEN);
+
+        /* Backwards, so that the positions still to visit stay put */
+        for (std::size_t position = m_rows.size(); position-- > 0;) {
+            auto const index = m_rows[position];
+            if (is_visible(index)) {
+                seen[index] = SHOWN;
+            } else {
+                seen[index] = HIDDEN;
+                erase_row(position);
+            }
+        }
+
+        for (std::size_t index = 0; index < seen.size(); ++index) {
+            if (seen[index] == UNSEEN && is_visible(index))
+                insert_row(index);
+        }
+    }
+
+    ItemStoreModel::iterator ItemStoreModel::find(int_fast64_t series_itemdb_id)
+    {
+        if (!m_store)
+            return iterator();
+
+        auto const index = m_store->index_of(series_itemdb_id);
+        if (index == MALItemColumns::npos)
+            return iterator();
+
+        auto const position = position_of(index);
+        if (position == not_visible)
+            return iterator();
+
+        return make_iter(index, position);
+    }
+
+    std::size_t ItemStoreModel::store_index(const const_iterator& iter) const
+    {
+        auto const index = index_of(iter);
+        if (!m_store || index >= m_store->size())
+            return MALItemColumns::npos;
+        return index;
+    }
+
+    bool ItemStoreModel::is_visible(std::size_t index) const
+    {
+        return !m_visible_func || m_visible_func(make_iter(index, not_visible));
+    }
+
+    std::size_t ItemStoreModel::position_of(std::size_t index) const
+    {
+        if (index >= m_positions.size())
+            return not_visible;
+        return m_positions[index];
+    }
+
+    std::size_t ItemStoreModel::sorted_position(std::size_t index) const
+    {
+        auto iter = std::upper_bound(m_rows.cbegin(), m_rows.cend(), static_cast<guint>(index),
+                                     [this](guint a, guint b) { return is_sorted_before(a, b); });
+        return static_cast<std::size_t>(iter - m_rows.cbegin());
+    }
+
+    std::size_t ItemStoreModel::insert_row(std::size_t index)
+    {
+        auto const position = sorted_position(index);
+        m_rows.insert(m_rows.begin() + position, static_cast<guint>(index));
+        update_positions(position);
+        invalidate_iters();
+        row_inserted(make_path(position), make_iter(index, position));
+        return position;
+    }
+
+    void ItemStoreModel::erase_row(std::size_t position)
+    {
+        m_positions[m_rows[position]] = not_visible;
+        m_rows.erase(m_rows.begin() + position);
+        update_positions(position);
+        invalidate_iters();
+        row_deleted(make_path(position));
+    }
+
+    /* Rows from position on have moved */
+    void ItemStoreModel::update_positions(std::size_t from)
+    {
+        for (std::size_t position = from; position < m_rows.size(); ++position)
+            m_positions[m_rows[position]] = position;
+    }
+
+    std::size_t ItemStoreModel::reposition_row(std::size_t position)
+    {
+        auto const index = m_rows[position];
+        const bool in_order = (position == 0 || !is_sorted_before(index, m_rows[position - 1]))
+            && (position + 1 == m_rows.size() || !is_sorted_before(m_rows[position + 1], index));
+        if (in_order)
+            return position;
+
+        erase_row(position);
+        return insert_row(index);
+    }
+
+    void ItemStoreModel::invalidate_iters()
+    {
+        if (++m_stamp == 0)
+            m_stamp = 1; /* A zero stamp marks an invalid iterator */
+    }
+
+    /* Sorting */
+
+    void ItemStoreModel::set_sort_func(int sort_column_id, const SlotCompare& slot)
+    {
+        m_sort_funcs[sort_column_id] = slot;
+        if (sort_column_id == m_sort_column)
+            sort_rows();
+    }
+
+    void ItemStoreModel::set_sort_column(int sort_column_id, Gtk::SortType order)
+    {
+        if (sort_column_id == m_sort_column && order == m_sort_order)
+            return;
+
+        m_sort_column = sort_column_id;
+        m_sort_order  = order;
+        sort_rows();
+    }
+
+    bool ItemStoreModel::is_sorted_before(std::size_t a, std::size_t b) const
+    {
+        auto func = m_sort_funcs.find(m_sort_column);
+        if (func == m_sort_funcs.end())
+            return false;
+
+        const int result = func->second(a, b);
+        return m_sort_order == Gtk::SORT_ASCENDING ? result < 0 : result > 0;
+    }
+
+    void ItemStoreModel::sort_rows()
+    {
+        finish_populating();
+        if (m_rows.size() < 2)
+            return;
+
+        LatencyMonitor::Scope scope("ItemStoreModel::sort_rows");
+
+        std::vector<guint> sorted(m_rows);
+        std::stable_sort(sorted.begin(), sorted.end(), [this](guint a, guint b) {
+                return is_sorted_before(a, b);
+            });
+
+        /* new_order[new position] = old position */
+        std::vector<int> new_order(sorted.size());
+        for (std::size_t position = 0; position < sorted.size(); ++position)
+            new_order[position] = static_cast<int>(m_positions[sorted[position]]);
+
+        m_rows.swap(sorted);
+        update_positions(0);
+        invalidate_iters();
+        Path root;
+        gtk_tree_model_rows_reordered(Gtk::TreeModel::gobj(), root.gobj(), nullptr, new_order.data());
+    }
+
+    /* Edits */
+
+    void ItemStoreModel::drop_edits(int_fast64_t series_itemdb_id)
+    {
+        auto first = m_edits.lower_bound(std::make_pair(series_itemdb_id, INT_MIN));
+        auto last  = m_edits.upper_bound(std::make_pair(series_itemdb_id, INT_MAX));
+        m_edits.erase(first, last);
+    }
+
+    void ItemStoreModel::set_value_impl(const iterator& row, int column, const Glib::ValueBase& value)
+    {
+        if (m_filling) {
+            if (column >= 0 && static_cast<std::size_t>(column) < m_scratch.size())
+                m_scratch[column] = value;
+            return;
+        }
+
+        auto const index = index_of(row);
+        if (!m_store || index >= m_store->size())
+            return;
+
+        auto const id  = m_store->series_itemdb_id[index];
+        auto const key = std::make_pair(id, column);
+        m_edits.erase(key);
+        m_edits.emplace(key, value);
+
+        /* Views edit rows from inside row_changed handlers, so leave
+         * filtering and sorting the row until they are done */
+        m_edited_rows.insert(id);
+        if (!m_recheck_connection.connected())
+            m_recheck_connection = Glib::signal_idle().connect(sigc::mem_fun(*this, &ItemStoreModel::recheck_edited_rows));
+
+        auto hint = GPOINTER_TO_SIZE(row.gobj()->user_data2);
+        auto const position = (hint < m_rows.size() && m_rows[hint] == index) ? hint : position_of(index);
+        if (position != not_visible)
+            row_changed(make_path(position), make_iter(index, position));
+    }
+
+    bool ItemStoreModel::recheck_edited_rows()
+    {
+        std::set<int_fast64_t> edited;
+        edited.swap(m_edited_rows);
+        if (!m_store)
+            return false;
+        finish_populating();
+
+        for (auto const id : edited) {
+            auto const index = m_store->index_of(id);
+            if (index == MALItemColumns::npos)
+                continue;
+
+            auto const position = position_of(index);
+            const bool visible = is_visible(index);
+            if (position == not_visible) {
+                if (visible)
+                    insert_row(index);
+            } else if (!visible) {
+                erase_row(position);
+            } else {
+                reposition_row(position);
+            }
+        }
+
+        return false;
+    }
+
+    /* Gtk::TreeModel */
+
+    ItemStoreModel::Path ItemStoreModel::make_path(std::size_t position)
+    {
+        Path path;
+        path.push_back(static_cast<int>(position));
+        return path;
+    }
+
+    void ItemStoreModel::set_iter(iterator& iter, std::size_t position) const
+    {
+        iter.set_stamp(m_stamp);
+        iter.gobj()->user_data  = GSIZE_TO_POINTER(m_rows[position]);
+        iter.gobj()->user_data2 = GSIZE_TO_POINTER(position);
+        iter.gobj()->user_data3 = nullptr;
+    }
+
+    ItemStoreModel::iterator ItemStoreModel::make_iter(std::size_t index, gsize position) const
+    {
+        iterator iter(const_cast<ItemStoreModel*>(this));
+        iter.set_stamp(m_stamp);
+        iter.gobj()->user_data  = GSIZE_TO_POINTER(index);
+        iter.gobj()->user_data2 = GSIZE_TO_POINTER(position);
+        iter.gobj()->user_data3 = nullptr;
+        return iter;
+    }
+
+    Gtk::TreeModelFlags ItemStoreModel::get_flags_vfunc() const
+    {
+        return Gtk::TREE_MODEL_LIST_ONLY;
+    }
+
+    int ItemStoreModel::get_n_columns_vfunc() const
+    {
+        return static_cast<int>(m_column_types.size());
+    }
+
+    GType ItemStoreModel::get_column_type_vfunc(int index) const
+    {
+        if (index < 0 || static_cast<std::size_t>(index) >= m_column_types.size())
+            return G_TYPE_INVALID;
+        return m_column_types[index];
+    }
+
+    void ItemStoreModel::get_value_vfunc(const iterator& iter, int column, Glib::ValueBase& value) const
+    {
+        /* GTK reads value whatever happens, so even a bad request
+         * gets an initialised value, holding its type's default */
+        if (column < 0 || static_cast<std::size_t>(column) >= m_column_types.size()) {
+            value.init(G_TYPE_POINTER);
+            return;
+        }
+
+        auto const index = index_of(iter);
+        if (!m_store || iter.gobj()->stamp != m_stamp || index >= m_store->size()) {
+            value.init(m_column_types[column]);
+            return;
+        }
+
+        if (!m_edits.empty()) {
+            auto edit = m_edits.find(std::make_pair(m_store->series_itemdb_id[index], column));
+            if (edit != m_edits.end()) {
+                value.init(edit->second.gobj());
+                return;
+            }
+        }
+
+        if (column == m_id_column) {
+            set_cell<gint64>(value, m_store->series_itemdb_id[index]);
+        } else if (column == m_index_column) {
+            set_cell<guint>(value, static_cast<guint>(index));
+        } else if (column == m_item_column) {
+            set_cell<std::shared_ptr<MALItem> >(value, m_store->item(index));
+        } else {
+            /* Views read a row's cells one after another, so format
+             * the whole row once and serve it until another row is
+             * asked for. Cells the fill slot leaves alone read as
+             * their type's default */
+            if (m_scratch_index != index) {
+                for (auto& cell : m_scratch)
+                    cell.reset();
+                /* Set first, so the fill slot reads back its own cells */
+                m_scratch_index = index;
+                m_filling = true;
+                m_fill(index, *make_iter(index, not_visible));
+                m_filling = false;
+            }
+            value.init(m_scratch[column].gobj());
+        }
+    }
+
+    bool ItemStoreModel::iter_next_vfunc(const iterator& iter, iterator& iter_next) const
+    {
+        auto const index = index_of(iter);
+        auto position = GPOINTER_TO_SIZE(iter.gobj()->user_data2);
+        if (position >= m_rows.size() || m_rows[position] != index)
+            position = position_of(index);
+
+        if (position == not_visible || position + 1 >= m_rows.size())
+            return false;
+
+        set_iter(iter_next, position + 1);
+        return true;
+    }
+
+    bool ItemStoreModel::iter_children_vfunc(const iterator&, iterator&) const
+    {
+        return false;
+    }
+
+    bool ItemStoreModel::iter_has_child_vfunc(const iterator&) const
+    {
+        return false;
+    }
+
+    int ItemStoreModel::iter_n_children_vfunc(const iterator&) const
+    {
+        return 0;
+    }
+
+    int ItemStoreModel::iter_n_root_children_vfunc() const
+    {
+        return static_cast<int>(m_rows.size());
+    }
+
+    bool ItemStoreModel::iter_nth_child_vfunc(const iterator&, int, iterator&) const
+    {
+        return false;
+    }
+
+    bool ItemStoreModel::iter_nth_root_child_vfunc(int n, iterator& iter) const
+    {
+        if (n < 0 || static_cast<std::size_t>(n) >= m_rows.size())
+            return false;
+
+        set_iter(iter, static_cast<std::size_t>(n));
+        return true;
+    }
+
+    bool ItemStoreModel::iter_parent_vfunc(const iterator&, iterator&) const
+    {
+        return false;
+    }
+
+    ItemStoreModel::Path ItemStoreModel::get_path_vfunc(const iterator& iter) const
+    {
+        auto const index = index_of(iter);
+        auto position = GPOINTER_TO_SIZE(iter.gobj()->user_data2);
+        if (position >= m_rows.size() || m_rows[position] != index)
+            position = position_of(index);
+
+        if (position == not_visible)
+            return Path();
+        return make_path(position);
+    }
+
+    bool ItemStoreModel::get_iter_vfunc(const Path& path, iterator& iter) const
+    {
+        if (path.size() != 1 || path[0] < 0 || static_cast<std::size_t>(path[0]) >= m_rows.size())
+            return false;
+
+        set_iter(iter, static_cast<std::size_t>(path[0]));
+        return true;
+    }
+}
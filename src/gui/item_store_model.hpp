@@ -0,0 +1,208 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+#include <glibmm/object.h>
+#include <sigc++/connection.h>
+#include <gtkmm/treemodel.h>
+#include <gtkmm/treesortable.h>
+#include <sigc++/slot.h>
+#include "malitem.hpp"
+#include "mal.hpp"
+#include "item_columns.hpp"
+
+namespace MAL {
+
+    /** A flat Gtk::TreeModel that reads its rows straight from a
+     * MALItemColumns store.
+     *
+     * Nothing is copied per row. The visible rows are an array of
+     * store indices, filtered and sorted in place, with the position
+     * of each store row kept alongside. Cells are formatted when the
+     * view asks for them: the fill slot is run on the row itself, its
+     * values are cached, and they are served until a different row is
+     * asked for.
+     *
+     * Values set through Gtk::TreeRow::set_value() are kept as
+     * per-row edits on top of the store, so editable views work as
+     * they did on a Gtk::ListStore. A row's edits are dropped when
+     * the store brings a new version of its item.
+     *
+     * Iterators do not persist across changes to the visible rows,
+     * but get_value() and set_value() keep working on an iterator
+     * whose row has since been filtered out.
+     */
+    class ItemStoreModel final : public Glib::Object, public Gtk::TreeModel {
+    public:
+        /* Fills every column of row for store row index */
+        typedef sigc::slot<void, std::size_t, const Gtk::TreeRow&>          SlotFill;
+        typedef sigc::slot<bool, const Gtk::TreeModel::const_iterator&>    SlotVisible;
+        /* Compares two store rows, returning <0, 0 or >0 */
+        typedef sigc::slot<int, std::size_t, std::size_t>                   SlotCompare;
+
+        static Glib::RefPtr<ItemStoreModel> create(const Gtk::TreeModelColumnRecord&                     columns,
+                                                   const Gtk::TreeModelColumn<gint64>&                   series_itemdb_id,
+                                                   const Gtk::TreeModelColumn<guint>&                    store_index,
+                                                   const Gtk::TreeModelColumn<std::shared_ptr<MALItem> >& item,
+                                                   const SlotFill&                                       fill);
+        virtual ~ItemStoreModel();
+
+        const std::shared_ptr<const MALItemColumns>& get_store() const { return m_store; }
+
+        /** Replaces every row with the visible rows of store.
+         *
+         * Emits a signal per row, so detach the model from any view
+         * first when store is large.
+         */
+        void set_store(const std::shared_ptr<const MALItemColumns>& store);
+
+        /** As set_store(), but only the first first_rows rows are
+         * added now. The rest are added from an idle handler, a time
+         * slice at a time, so the main loop keeps drawing while a
+         * large store loads.
+         *
+         * Any other change to the rows adds the remaining rows first.
+         */
+        void populate(const std::shared_ptr<const MALItemColumns>& store, std::size_t first_rows);
+
+        /** Moves to store, a newer version of the current store, and
+         * emits signals only for the rows named in changes.
+         */
+        void apply_changes(const std::shared_ptr<const MALItemColumns>& store, const ItemChanges& changes);
+
+        /** Clears all rows and drops the store.
+         */
+        void clear();
+
+        void set_visible_func(const SlotVisible& slot) { m_visible_func = slot; }
+
+        /** Re-runs the visible func on every store row.
+         */
+        void refilter();
+
+        void set_sort_func(int sort_column_id, const SlotCompare& slot);
+        void set_default_sort_func(const SlotCompare& slot) { set_sort_func(Gtk::TreeSortable::DEFAULT_SORT_COLUMN_ID, slot); }
+        void set_sort_column(int sort_column_id, Gtk::SortType order);
+        int get_sort_column() const { return m_sort_column; }
+        Gtk::SortType get_sort_order() const { return m_sort_order; }
+
+        /** The store row iter points to.
+         */
+        std::size_t store_index(const const_iterator& iter) const;
+
+        /** Returns the visible row for series_itemdb_id, or an
+         * invalid iterator.
+         */
+        iterator find(int_fast64_t series_itemdb_id);
+
+    protected:
+        ItemStoreModel(const Gtk::TreeModelColumnRecord&                     columns,
+                       const Gtk::TreeModelColumn<gint64>&                   series_itemdb_id,
+                       const Gtk::TreeModelColumn<guint>&                    store_index,
+                       const Gtk::TreeModelColumn<std::shared_ptr<MALItem> >& item,
+                       const SlotFill&                                       fill);
+
+        virtual Gtk::TreeModelFlags get_flags_vfunc() const override;
+        virtual int get_n_columns_vfunc() const override;
+        virtual GType get_column_type_vfunc(int index) const override;
+        virtual void get_value_vfunc(const iterator& iter, int column, Glib::ValueBase& value) const override;
+        virtual void set_value_impl(const iterator& row, int column, const Glib::ValueBase& value) override;
+
+        virtual bool iter_next_vfunc(const iterator& iter, iterator& iter_next) const override;
+        virtual bool iter_children_vfunc(const iterator& parent, iterator& iter) const override;
+        virtual bool iter_has_child_vfunc(const iterator& iter) const override;
+        virtual int iter_n_children_vfunc(const iterator& iter) const override;
+        virtual int iter_n_root_children_vfunc() const override;
+        virtual bool iter_nth_child_vfunc(const iterator& parent, int n, iterator& iter) const override;
+        virtual bool iter_nth_root_child_vfunc(int n, iterator& iter) const override;
+        virtual bool iter_parent_vfunc(const iterator& child, iterator& iter) const override;
+        virtual Path get_path_vfunc(const iterator& iter) const override;
+        virtual bool get_iter_vfunc(const Path& path, iterator& iter) const override;
+
+    private:
+        static constexpr gsize not_visible = G_MAXSIZE;
+
+        /* Time spent adding rows per idle call, half a 60 Hz frame */
+        static constexpr gint64 populate_budget_us = G_USEC_PER_SEC / 120;
+
+        /* iter.user_data is the store row, user_data2 the position in
+         * m_rows when the iterator was made */
+        void set_iter(iterator& iter, std::size_t position) const;
+        iterator make_iter(std::size_t index, gsize position) const;
+        static std::size_t index_of(const const_iterator& iter) {
+            return GPOINTER_TO_SIZE(iter.gobj()->user_data);
+        }
+        static Path make_path(std::size_t position);
+
+        bool is_visible(std::size_t index) const;
+        bool is_sorted_before(std::size_t a, std::size_t b) const;
+        std::size_t position_of(std::size_t index) const;
+        std::size_t sorted_position(std::size_t index) const;
+        void sort_rows();
+
+        void reset(const std::shared_ptr<const MALItemColumns>& store);
+        bool has_pending() const { return m_pending_next < m_pending.size(); }
+        void publish_pending(std::size_t n);
+        void finish_populating();
+        bool on_populate_idle();
+        void invalidate_iters();
+
+        std::size_t insert_row(std::size_t index);
+        void erase_row(std::size_t position);
+        void update_positions(std::size_t from);
+        std::size_t reposition_row(std::size_t position);
+        void drop_edits(int_fast64_t series_itemdb_id);
+
+        bool recheck_edited_rows();
+
+        std::vector<GType>                    m_column_types;
+        int                                   m_id_column;
+        int                                   m_index_column;
+        int                                   m_item_column;
+        SlotFill                              m_fill;
+        SlotVisible                           m_visible_func;
+        std::map<int, SlotCompare>            m_sort_funcs;
+        int                                   m_sort_column;
+        Gtk::SortType                         m_sort_order;
+        int                                   m_stamp;
+
+        std::shared_ptr<const MALItemColumns> m_store;
+        std::vector<guint>                    m_rows;  /* Visible store rows, in sort order */
+        std::vector<gsize>                    m_positions; /* Store row to m_rows position, or not_visible */
+
+        /* Sorted rows still to be added by populate() */
+        std::vector<guint>                    m_pending;
+        std::size_t                           m_pending_next;
+        sigc::connection                      m_populate_connection;
+
+        /* Values set by views, keyed by (series_itemdb_id, column) */
+        std::map<std::pair<int_fast64_t, int>, Glib::ValueBase> m_edits;
+        std::set<int_fast64_t>                m_edited_rows; /* Waiting for recheck_edited_rows() */
+        sigc::connection                      m_recheck_connection;
+
+        /* Cells of store row m_scratch_index, as the fill slot set
+         * them. m_filling routes set_value() here while it runs */
+        mutable std::vector<Glib::ValueBase>  m_scratch;
+        mutable std::size_t                   m_scratch_index;
+        mutable bool                          m_filling;
+    };
+}
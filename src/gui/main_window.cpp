@@ -88,18 +88,24 @@ namespace MAL {
 
         mal->signal_mal_error.connect(sigc::mem_fun(this, &MainWindow::mal_error_cb));
         mal->signal_mal_info.connect(sigc::mem_fun(this, &MainWindow::mal_info_cb));
+
+        /* MAL may have sent some while it was being set up, before
+         * there was a window to show them */
+        mal_error_cb();
+        mal_info_cb();
 	}
 
     void MainWindow::mal_error_cb()
     {
+        auto errors = m_mal->signal_mal_error.take_all();
+        if (errors.empty())
+            return;
+
         Glib::ustring msg;
-        while (!m_mal->signal_mal_error.empty()) {
-            msg.append(m_mal->signal_mal_error.front());
-            m_mal->signal_mal_error.pop();
-            if (!m_mal->signal_mal_error.empty())
+        for (auto const& error : errors) {
+            if (!msg.empty())
                 msg.append("\n");
-            else
-                break;
+            msg.append(error);
         }
         m_infobar_label->set_text(msg);
         m_infobar_label->show();
@@ -109,10 +115,8 @@ namespace MAL {
 
     void MainWindow::mal_info_cb()
     {
-        while (!m_mal->signal_mal_info.empty()) {
-            m_status_messages.push_back(m_mal->signal_mal_info.front());
-            m_mal->signal_mal_info.pop();
-        }
+        for (auto& info : m_mal->signal_mal_info.take_all())
+            m_status_messages.push_back(std::move(info));
 
         if (!m_status_timeout.connected() && !m_status_messages.empty()) {
             m_status_timeout = Glib::signal_timeout().connect_seconds(sigc::mem_fun(this, &MainWindow::status_timeout_cb), 3);
@@ -16,6 +16,8 @@
  */
 
 #include "malitem_list_view.hpp"
+#include "latency_monitor.hpp"
+#include <algorithm>
 #include <array>
 #include <iostream>
 #include <iomanip>
@@ -337,6 +339,7 @@ namespace MAL {
         }
 
         try {
+            LatencyMonitor::Scope scope("Pixbuf load");
             auto pixbuf = Gdk::Pixbuf::create_from_stream(image_stream);
             m_image->set(pixbuf);
             m_image->show();
@@ -511,7 +514,7 @@ namespace MAL {
             m_priority_combo->set_sensitive(true);
             m_reconsume_value_combo->set_sensitive(true);
             
-            m_fansub_group_entry->set_text(m_item->fansub_group);
+            m_fansub_group_entry->set_text(m_item->fansub_group.str());
             m_downloaded_items_entry->set_entry_text(std::to_string(item->downloaded_items));
             m_times_consumed_entry->set_entry_text(std::to_string(item->times_consumed));
             m_priority_combo->set_priority(item->priority);
@@ -595,9 +598,9 @@ namespace MAL {
 		Gtk::Grid      (),
         m_columns      (columns),
 		m_mal          (mal),
-		m_root_model   (Gtk::ListStore::create(*m_columns)),
-        m_filter_model (Gtk::TreeModelFilter::create(m_root_model)),
-        m_model        (Gtk::TreeModelSort::create(m_filter_model)),
+        m_model        (ItemStoreModel::create(*m_columns, m_columns->series_itemdb_id,
+                                               m_columns->store_index, m_columns->item,
+                                               sigc::mem_fun(*this, &MALItemListViewBase::fill_row))),
 		m_treeview     (Gtk::manage(new Gtk::TreeView(m_model)))
 	{
 		Gtk::ScrolledWindow *sw = Gtk::manage(new Gtk::ScrolledWindow());
@@ -607,7 +610,7 @@ namespace MAL {
 		add(*sw);
 
 		m_title_column = Gtk::manage(new Gtk::TreeViewColumn("Title", m_columns->series_title));
-		m_title_column->set_sort_column(m_columns->series_title);
+		set_sort_column(m_title_column, m_columns->series_title.index());
 		m_title_column->set_expand(true);
         auto title_cr = static_cast<Gtk::CellRendererText*>(m_title_column->get_first_cell());
         title_cr->property_ellipsize().set_value(Pango::ELLIPSIZE_END);
@@ -617,28 +620,58 @@ namespace MAL {
 		auto season_cr = season->get_first_cell();
 		season_cr->set_alignment(1.0, 0.5);
 		m_treeview->append_column(*season);
-		season->set_sort_column(m_columns->series_start_date);
+		set_sort_column(season, m_columns->series_season.index());
 
 		show_all();
 		m_treeview->signal_row_activated().connect(sigc::mem_fun(*this, &MALItemListViewBase::on_my_row_activated));
         m_treeview->set_rules_hint(true);
-        m_root_model->set_default_sort_func(sigc::mem_fun(*this, &MALItemListViewBase::malitem_comparitor));
-        m_root_model->set_sort_column(Gtk::TreeSortable::DEFAULT_SORT_COLUMN_ID, Gtk::SORT_DESCENDING);
+        m_model->set_visible_func(sigc::mem_fun(*this, &MALItemListViewBase::is_row_visible));
+        m_model->set_default_sort_func(sigc::mem_fun(*this, &MALItemListViewBase::malitem_comparitor));
+        m_model->set_sort_func(m_columns->series_title.index(), sigc::mem_fun(*this, &MALItemListViewBase::title_comparitor));
+        m_model->set_sort_func(m_columns->series_season.index(), sigc::mem_fun(*this, &MALItemListViewBase::malitem_comparitor));
+        m_model->set_sort_column(Gtk::TreeSortable::DEFAULT_SORT_COLUMN_ID, Gtk::SORT_DESCENDING);
 #if GTK_CHECK_VERSION(3,8,0)
         m_treeview->set_activate_on_single_click(true);
 #endif
 	}
 
-    int MALItemListViewBase::malitem_comparitor(const Gtk::TreeModel::iterator& a, const Gtk::TreeModel::iterator& b)
+    /* Rows sort by season, newest first, then by title: two
+     * integer compares and at most one memcmp.
+     */
+    int MALItemListViewBase::malitem_comparitor(std::size_t a, std::size_t b) const
     {
-        auto & season_column = m_columns->series_start_date;
-        auto season = a->get_value(season_column).compare(0, 7, b->get_value(season_column));
-        if (season == 0) {
-            auto & title_column = m_columns->series_title;
-            return b->get_value(title_column).compare(a->get_value(title_column));
-        } else {
-            return season;
-        }
+        auto const& store = *m_model->get_store();
+        const auto ak = store.season_key[a];
+        const auto bk = store.season_key[b];
+        if (ak != bk)
+            return (ak > bk) - (ak < bk);
+        return store.title_key[b].compare(store.title_key[a]);
+    }
+
+    int MALItemListViewBase::title_comparitor(std::size_t a, std::size_t b) const
+    {
+        auto const& store = *m_model->get_store();
+        return store.title_key[a].compare(store.title_key[b]);
+    }
+
+    void MALItemListViewBase::set_sort_column(Gtk::TreeViewColumn *column, int sort_column_id)
+    {
+        column->set_clickable(true);
+        column->signal_clicked().connect(sigc::bind(sigc::mem_fun(*this, &MALItemListViewBase::on_sort_column_clicked),
+                                                    column, sort_column_id));
+    }
+
+    void MALItemListViewBase::on_sort_column_clicked(Gtk::TreeViewColumn *column, int sort_column_id)
+    {
+        auto order = Gtk::SORT_ASCENDING;
+        if (m_model->get_sort_column() == sort_column_id && m_model->get_sort_order() == Gtk::SORT_ASCENDING)
+            order = Gtk::SORT_DESCENDING;
+
+        for (auto c : m_treeview->get_columns())
+            c->set_sort_indicator(false);
+        column->set_sort_indicator(true);
+        column->set_sort_order(order);
+        m_model->set_sort_column(sort_column_id, order);
     }
 
     void MALItemListViewBase::set_filter_func(const sigc::slot<bool, const std::shared_ptr<MALItem>&>& slot)
@@ -649,17 +682,14 @@ namespace MAL {
     void MALItemListViewBase::refresh_item_cb(const std::shared_ptr<MALItem>& item, const Gtk::TreeRow& row) {
         row.set_value(m_columns->series_title, Glib::ustring(item->series_title));
         row.set_value(m_columns->series_season, Glib::ustring(item->get_season_began()));
-        auto sort_text = item->series_date_begin.substr(0,7);
-        row.set_value(m_columns->series_start_date, Glib::ustring(sort_text));
         row.set_value(m_columns->item, item);
     }
 
     /** Clear the list view and repopulate from the for_each_functor
      *
-     * Because the MALItems are stored behind a std::mutex, we can not
-     * access them directly. Instead the mutex is taken and
-     * std::for_each(items.begin(), items.end(), ItemFunctor) is
-     * called. Unfortunately, ItemFunctor can not be a public version
+     * The MALItems are owned by MAL, so we can not access them
+     * directly. Instead std::for_each(items.begin(), items.end(),
+     * ItemFunctor) is called on a snapshot. Unfortunately, ItemFunctor can not be a public version
      * of append_item() because the model_changed_connection needs to
      * be blocked.
      *
@@ -671,22 +701,73 @@ namespace MAL {
      */
     void MALItemListViewBase::refresh_items(const std::function<void (const std::function<void (const std::shared_ptr<MALItem>&)>&)>& for_each_functor)
     {
-        m_root_model->clear();
+        std::vector<std::shared_ptr<MALItem> > items;
+        for_each_functor([&items](const std::shared_ptr<MALItem>& item) {
+                items.push_back(item);
+            });
+        refresh_items(std::make_shared<const ItemVectorColumns>(std::move(items)));
+    }
+
+    void MALItemListViewBase::refresh_items(const std::shared_ptr<const MALItemColumns>& store)
+    {
+        /* More than fills a window; the rest are added while idle */
+        constexpr std::size_t first_rows = 200;
+
+        LatencyMonitor::Scope scope("MALItemListView::refresh_items");
+        /* Detached, the view does not handle a signal per old row */
         m_model_changed_connection.block();
-        for_each_functor(std::bind(&MALItemListViewBase::append_item, this, std::placeholders::_1));
+        m_treeview->unset_model();
+        m_model->populate(store, first_rows);
+        m_treeview->set_model(m_model);
         m_model_changed_connection.unblock();
     }
 
-    void MALItemListViewBase::append_item(const std::shared_ptr<MALItem>& item)
+    void MALItemListViewBase::fill_row(std::size_t index, const Gtk::TreeRow& row)
     {
-        if (m_filter_func) {
-            if (m_filter_func(item)) {
-                auto iter = m_root_model->append();
-                refresh_item_cb(item, *iter);
-            }
-        } else {
-            auto iter = m_root_model->append();
-            refresh_item_cb(item, *iter);
+        refresh_item_cb(m_model->get_store()->item(index), row);
+    }
+
+    bool MALItemListViewBase::is_row_visible(const Gtk::TreeModel::const_iterator& iter) const
+    {
+        if (m_filter_func && !m_filter_func(iter->get_value(m_columns->item)))
+            return false;
+        return !m_visible_func || m_visible_func(iter);
+    }
+
+    void MALItemListViewBase::apply_changes(const std::shared_ptr<const MALItemColumns>& store, const ItemChanges& changes)
+    {
+        LatencyMonitor::Scope scope("MALItemListView::apply_changes");
+        const bool was_blocked = m_model_changed_connection.block();
+        m_model->apply_changes(store, changes);
+        m_model_changed_connection.block(was_blocked);
+
+        if (!m_detailed_item)
+            return;
+
+        const auto id = m_detailed_item->series_itemdb_id;
+        const bool changed = std::find(changes.inserted.cbegin(), changes.inserted.cend(), id) != changes.inserted.cend()
+            || std::find(changes.updated.cbegin(), changes.updated.cend(), id) != changes.updated.cend();
+        const auto index = store->index_of(id);
+        if (changed && index != MALItemColumns::npos) {
+            m_detailed_item = store->item(index);
+            if (m_row_activated_cb)
+                m_row_activated_cb(m_detailed_item);
+        }
+    }
+
+    std::size_t MALItemListViewBase::store_row(const Gtk::TreeModel::const_iterator& iter) const
+    {
+        if (G_UNLIKELY(iter->get_value(m_columns->store_index) == G_MAXUINT))
+            return MALItemColumns::npos;
+        return m_model->store_index(iter);
+    }
+
+    void MALItemListViewBase::detach_row_from_store(const Gtk::TreeRow& row)
+    {
+        if (row.get_value(m_columns->store_index) != G_MAXUINT) {
+            const bool was_blocked = m_model_changed_connection.block();
+            row.set_value(m_columns->store_index, G_MAXUINT);
+            m_model_changed_connection.block(was_blocked);
         }
     }
 
@@ -724,7 +805,7 @@ namespace MAL {
         m_score_column->add_attribute(m_score_cellrenderer->property_score(), columns->score);
         //m_score_column->set_alignment(Pango::ALIGN_CENTER);
         m_score_cellrenderer->signal_edited().connect(sigc::mem_fun(*this, &MALItemListViewEditable::score_edited_cb));
-        m_model_changed_connection = m_root_model->signal_row_changed().connect(sigc::mem_fun(*this, &MALItemListViewEditable::on_model_changed));
+        m_model_changed_connection = m_model->signal_row_changed().connect(sigc::mem_fun(*this, &MALItemListViewEditable::on_model_changed));
         m_treeview->append_column(*m_score_column);
 		m_treeview->signal_row_activated().connect([this](const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn*)->void{
                 auto iter = this->m_model->get_iter(path);
@@ -740,11 +821,11 @@ namespace MAL {
         MALItemListViewBase::refresh_item_cb(item, row);
         auto columns = std::dynamic_pointer_cast<MALItemModelColumnsEditable>(m_columns);
         row.set_value(columns->score, static_cast<int>(item->score));
-        row.set_value(columns->begin_date, Glib::ustring(item->date_start));
-        row.set_value(columns->end_date, Glib::ustring(item->date_finish));
+        row.set_value(columns->begin_date, Glib::ustring(item->date_start.to_string()));
+        row.set_value(columns->end_date, Glib::ustring(item->date_finish.to_string()));
         row.set_value(columns->enable_reconsuming, item->enable_reconsuming);
         if (item->has_details) {
-            row.set_value(columns->fansub_group, Glib::ustring(item->fansub_group));
+            row.set_value(columns->fansub_group, Glib::ustring(item->fansub_group.str()));
             row.set_value(columns->downloaded_items, static_cast<int>(item->downloaded_items));
             row.set_value(columns->times_consumed, static_cast<int>(item->times_consumed));
             row.set_value(columns->priority, item->priority);
@@ -756,7 +837,7 @@ namespace MAL {
     {
         if (m_detailed_item->has_details) {
             auto columns = std::dynamic_pointer_cast<MALItemModelColumnsEditable>(m_columns);
-            row.set_value(columns->fansub_group, Glib::ustring(m_detailed_item->fansub_group));
+            row.set_value(columns->fansub_group, Glib::ustring(m_detailed_item->fansub_group.str()));
             row.set_value(columns->downloaded_items, static_cast<int>(m_detailed_item->downloaded_items));
             row.set_value(columns->times_consumed, static_cast<int>(m_detailed_item->times_consumed));
             row.set_value(columns->priority, m_detailed_item->priority);
@@ -811,7 +892,7 @@ namespace MAL {
             row.set_value(columns->item, item);
         }
 
-        auto const begin = row.get_value(columns->begin_date);
+        auto const begin = ItemDate::parse(row.get_value(columns->begin_date).raw());
         if (begin != item->date_start) {
             is_changed = true;
             auto new_item = item->clone();
@@ -820,7 +901,7 @@ namespace MAL {
             row.set_value(columns->item, item);
         }
 
-        auto const end = row.get_value(columns->end_date);
+        auto const end = ItemDate::parse(row.get_value(columns->end_date).raw());
         if (end != item->date_finish) {
             is_changed = true;
             auto new_item = item->clone();
@@ -839,8 +920,8 @@ namespace MAL {
         }
 
         if (item->has_details) {
-            auto const fansubgroup = row.get_value(columns->fansub_group);
-            if (fansubgroup != item->fansub_group) {
+            auto const fansubgroup = row.get_value(columns->fansub_group).raw();
+            if (fansubgroup != item->fansub_group.str()) {
                 is_changed = true;
                 auto new_item = item->clone();
                 new_item->fansub_group = fansubgroup;
@@ -904,7 +985,7 @@ namespace MAL {
 
     void MALItemListViewEditable::do_model_foreach(const Gtk::TreeModel::SlotForeachPathAndIter& slot)
     {
-        m_root_model->foreach(slot);
+        m_model->foreach(slot);
     }
 
 	MALItemListPage::MALItemListPage(const std::shared_ptr<MAL>& mal,
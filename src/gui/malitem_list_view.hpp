@@ -37,9 +37,11 @@
 #include <sigc++/slot.h>
 #include "malitem.hpp"
 #include "mal.hpp"
+#include "item_columns.hpp"
 #include "increment_entry.hpp"
 #include "date_widgets.hpp"
 #include "cellrendererscore.hpp"
+#include "item_store_model.hpp"
 
 namespace MAL {
 	class MALItemPriorityComboBox final : public Gtk::ComboBoxText {
@@ -86,12 +88,14 @@ namespace MAL {
         Gtk::TreeModelColumn<Glib::ustring> series_title;
         Gtk::TreeModelColumn<std::shared_ptr<MALItem> > item;
         Gtk::TreeModelColumn<Glib::ustring> series_season;
-        Gtk::TreeModelColumn<Glib::ustring> series_start_date;
+        Gtk::TreeModelColumn<gint64> series_itemdb_id;
+        Gtk::TreeModelColumn<guint> store_index; /* Row in the MALItemColumns, or G_MAXUINT */
 
         MALItemModelColumns() { add(series_title);
             add(item);
             add(series_season);
-            add(series_start_date);
+            add(series_itemdb_id);
+            add(store_index);
         } 
     };
 
@@ -240,24 +244,38 @@ namespace MAL {
 
         void set_filter_func(const sigc::slot<bool, const std::shared_ptr<MALItem>&>& slot);
 
-        void set_visible_func(const Gtk::TreeModelFilter::SlotVisible &slot) {
-            m_filter_model->set_visible_func(slot);
+        void set_visible_func(const ItemStoreModel::SlotVisible &slot) {
+            m_visible_func = slot;
         }
 
         void refilter() {
-            m_filter_model->refilter();
+            m_model->refilter();
         }
 
 
         void refresh_items(const std::function<void (const std::function<void (const std::shared_ptr<MALItem>&)>& )>& for_each_functor);
-        /*template<typename UnaryForeachFunctor>
-        UnaryForeachFunctor refresh_items(UnaryForeachFunctor&& for_each_functor) {
-            m_model->clear();
-            m_model_changed_connection.block();
-            auto ret = for_each_functor(std::bind(&MALItemListViewBase::append_item, this, std::placeholders::_1));
-            m_model_changed_connection.unblock();
-            return ret;
-        }*/
+
+        /** Clear the list view and repopulate it from store.
+         *
+         * The view's model reads its rows from store, so sort and
+         * filter functions can use the store's columns instead of the
+         * items.
+         */
+        void refresh_items(const std::shared_ptr<const MALItemColumns>& store);
+
+        /** Applies one MAL::signal_*_changed event, touching only the
+         * rows that changed. store must be at least as new as the
+         * snapshot that produced changes.
+         */
+        void apply_changes(const std::shared_ptr<const MALItemColumns>& store, const ItemChanges& changes);
+
+        bool has_store() const { return static_cast<bool>(m_model->get_store()); }
+
+        /** Returns the row's index in the current store, or
+         * MALItemColumns::npos if the row has been edited since it
+         * was populated from the store.
+         */
+        std::size_t store_row(const Gtk::TreeModel::const_iterator& iter) const;
 
 		void do_model_foreach(const Gtk::TreeModel::SlotForeachPathAndIter& slot) {m_model->foreach(slot);};
 		void set_row_activated_cb(sigc::slot<void, const std::shared_ptr<MALItem>&> slot) { m_row_activated_cb = slot;} ;
@@ -265,9 +283,7 @@ namespace MAL {
 
 	protected:
 		std::shared_ptr<MAL>                        m_mal;
-		Glib::RefPtr<Gtk::ListStore>                m_root_model;
-        Glib::RefPtr<Gtk::TreeModelFilter>          m_filter_model;
-        Glib::RefPtr<Gtk::TreeModelSort>            m_model;
+        Glib::RefPtr<ItemStoreModel>                m_model;
 		Gtk::TreeView                              *m_treeview;
         std::shared_ptr<MALItem>                    m_detailed_item;
         Gtk::TreeViewColumn                        *m_title_column;
@@ -276,6 +292,11 @@ namespace MAL {
         // Use if you connect to signal_row_changed
         sigc::connection                          m_model_changed_connection;
 
+        /* Call before replacing the item on a row, so that sort and
+         * filter functions stop trusting the store for that row.
+         */
+        void detach_row_from_store(const Gtk::TreeRow& row);
+
 
         /* Chain up!
          * Called when m_items has changed (We have fetched a new anime list from MAL)
@@ -287,8 +308,21 @@ namespace MAL {
     private:
 		void on_my_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
         sigc::slot<bool, const std::shared_ptr<MALItem>&> m_filter_func;
-        void append_item(const std::shared_ptr<MALItem>& item);
-        int malitem_comparitor(const Gtk::TreeModel::iterator&, const Gtk::TreeModel::iterator&);
+        ItemStoreModel::SlotVisible m_visible_func;
+        bool is_row_visible(const Gtk::TreeModel::const_iterator& iter) const;
+        void fill_row(std::size_t index, const Gtk::TreeRow& row);
+
+        /* Store rows are compared directly, so edited rows sort by
+         * their store values. The user can not edit the title or
+         * season, which are the only sort keys.
+         */
+        int malitem_comparitor(std::size_t a, std::size_t b) const;
+        int title_comparitor(std::size_t a, std::size_t b) const;
+
+        /* The model is not a Gtk::TreeSortable, so clicks on sortable
+         * column headers are handled here */
+        void set_sort_column(Gtk::TreeViewColumn *column, int sort_column_id);
+        void on_sort_column_clicked(Gtk::TreeViewColumn *column, int sort_column_id);
 	};
 
     class MALItemListViewStatic : public virtual MALItemListViewBase {
@@ -416,6 +416,7 @@ namespace MAL {
         auto const status = manga_status_from_string(row.get_value(columns->status));
         if (status != manga->status) {
             is_changed = true;
+            detach_row_from_store(row);
             new_manga->status = status;
             item = manga = new_manga;
             row.set_value(columns->item, item);
@@ -491,17 +492,18 @@ namespace MAL {
         m_columns(columns),
         m_list_view(list_view),
         m_detail_view(detail_view),
-        m_status_combo(Gtk::manage(new MangaStatusComboBox()))
+        m_status_combo(Gtk::manage(new MangaStatusComboBox())),
+        m_filter_status(READING)
     {
         m_list_view->set_visible_func(sigc::mem_fun(this, &MangaFilteredListPage::m_visible_func));
-        m_status_combo->signal_changed().connect(sigc::mem_fun(static_cast<MALItemListViewBase*>(m_list_view), &MALItemListViewEditable::refilter));
+        m_status_combo->signal_changed().connect(sigc::mem_fun(*this, &MangaFilteredListPage::on_status_changed));
         auto label = Gtk::manage(new Gtk::Label("Filter: "));
         m_button_row->attach(*m_status_combo, -1, 0, 1, 1);
         m_button_row->attach(*label, -2, 0, 1, 1);
         m_status_combo->set_hexpand(true);
         m_status_combo->set_active_text(to_string(READING));
         m_status_combo->show();
-        mal->signal_manga_added.connect(sigc::mem_fun(*this, &MangaFilteredListPage::on_mal_update));
+        mal->signal_manga_changed.connect(sigc::mem_fun(*this, &MangaFilteredListPage::on_mal_changed));
     }
 
     bool MangaFilteredListPage::m_filter_func(const std::shared_ptr<MALItem>& item) const
@@ -512,14 +514,34 @@ namespace MAL {
 
     bool MangaFilteredListPage::m_visible_func(const Gtk::TreeModel::const_iterator& iter) const
     {
+        const auto index = m_list_view->store_row(iter);
+        if (G_LIKELY(index < m_status_mask.size()))
+            return m_status_mask[index];
+
+        /* Row was edited since the store was built */
         auto manga = iter->get_value(m_columns->manga);
         if (manga) {
-            return m_status_combo->get_manga_status() == manga->status;
+            return m_filter_status == manga->status;
         } else {
             return true;
         }
     }
 
+    void MangaFilteredListPage::update_status_mask()
+    {
+        m_filter_status = m_status_combo->get_manga_status();
+        if (m_store)
+            m_store->match_status(m_filter_status, m_status_mask);
+        else
+            m_status_mask.clear();
+    }
+
+    void MangaFilteredListPage::on_status_changed()
+    {
+        update_status_mask();
+        m_list_view->refilter();
+    }
+
     void MangaFilteredListPage::refresh()
     {
 		m_mal->get_manga_list_async();
@@ -527,7 +549,19 @@ namespace MAL {
 
     void MangaFilteredListPage::on_mal_update()
     {
-        using std::placeholders::_1;
-        m_list_view->refresh_items(std::bind(&MAL::for_each_manga, m_mal, _1));
+        m_store = m_mal->manga_columns();
+        update_status_mask();
+        m_list_view->refresh_items(m_store);
+    }
+
+    void MangaFilteredListPage::on_mal_changed(const ItemChanges& changes)
+    {
+        if (!m_list_view->has_store()) {
+            on_mal_update();
+        } else {
+            m_store = m_mal->manga_columns();
+            update_status_mask();
+            m_list_view->apply_changes(m_store, changes);
+        }
     }
 }
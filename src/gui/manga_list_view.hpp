@@ -257,7 +257,15 @@ namespace MAL {
         MangaDetailViewEditable* m_detail_view;
         MangaStatusComboBox *m_status_combo;
 
+        /* Status filter evaluated over the store's status column */
+        std::shared_ptr<const MangaColumns> m_store;
+        std::vector<std::uint8_t>           m_status_mask;
+        MangaStatus                         m_filter_status;
+
         bool m_filter_func(const std::shared_ptr<MALItem>&) const;
         bool m_visible_func(const Gtk::TreeModel::const_iterator& iter) const;
+        void on_status_changed();
+        void update_status_mask();
+        void on_mal_changed(const ItemChanges& changes);
     };
 }
@@ -0,0 +1,136 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "request_trace_window.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <gtkmm/cellrenderertext.h>
+#include <gtkmm/filechooserdialog.h>
+#include <gtkmm/grid.h>
+#include <gtkmm/scrolledwindow.h>
+
+namespace MAL {
+
+	RequestTraceWindow::RequestTraceWindow(const std::shared_ptr<MAL>& mal) :
+		Gtk::Window(),
+        m_mal(mal),
+        m_store(Gtk::ListStore::create(m_columns)),
+        m_treeview(Gtk::manage(new Gtk::TreeView(m_store))),
+        m_summary(Gtk::manage(new Gtk::Label()))
+	{
+        set_title("Requests");
+        set_default_size(900, 400);
+
+        m_treeview->append_column("Kind", m_columns.kind);
+        m_treeview->append_column("Result", m_columns.result);
+        append_ms_column("DNS", m_columns.dns);
+        append_ms_column("Connect", m_columns.connect);
+        append_ms_column("TLS", m_columns.tls);
+        append_ms_column("Wait", m_columns.wait);
+        append_ms_column("Transfer", m_columns.transfer);
+        append_ms_column("Total", m_columns.total);
+        m_treeview->append_column("Bytes", m_columns.bytes);
+        m_treeview->append_column("Reused", m_columns.reused);
+        m_treeview->append_column("URL", m_columns.url);
+
+        auto scrolled = Gtk::manage(new Gtk::ScrolledWindow());
+        scrolled->add(*m_treeview);
+        scrolled->set_hexpand(true);
+        scrolled->set_vexpand(true);
+
+        auto refresh_button = Gtk::manage(new Gtk::Button("_Refresh", true));
+        auto export_button = Gtk::manage(new Gtk::Button("_Export Trace…", true));
+        refresh_button->signal_clicked().connect(sigc::mem_fun(*this, &RequestTraceWindow::refresh));
+        export_button->signal_clicked().connect(sigc::mem_fun(*this, &RequestTraceWindow::on_export_clicked));
+
+        m_summary->set_hexpand(true);
+        m_summary->set_halign(Gtk::ALIGN_START);
+
+        auto grid = Gtk::manage(new Gtk::Grid());
+        grid->attach(*scrolled, 0, 0, 3, 1);
+        grid->attach(*m_summary, 0, 1, 1, 1);
+        grid->attach(*refresh_button, 1, 1, 1, 1);
+        grid->attach(*export_button, 2, 1, 1, 1);
+        grid->show_all();
+        add(*grid);
+
+        refresh();
+	}
+
+    void RequestTraceWindow::append_ms_column(const Glib::ustring& title, const Gtk::TreeModelColumn<double>& column)
+    {
+        auto renderer = Gtk::manage(new Gtk::CellRendererText());
+        renderer->set_alignment(1.0, 0.5);
+        auto treecolumn = Gtk::manage(new Gtk::TreeViewColumn(title, *renderer));
+        treecolumn->set_cell_data_func(*renderer, [column](Gtk::CellRenderer* cell, const Gtk::TreeModel::iterator& iter) {
+                std::ostringstream ms;
+                ms << std::fixed << std::setprecision(1) << iter->get_value(column);
+                static_cast<Gtk::CellRendererText*>(cell)->property_text() = ms.str();
+            });
+        m_treeview->append_column(*treecolumn);
+    }
+
+    void RequestTraceWindow::refresh()
+    {
+        m_store->clear();
+
+        const auto requests = m_mal->request_trace().snapshot();
+        std::size_t reused = 0;
+        double total = 0;
+        for (const auto& request : requests) {
+            /* libcurl's times are cumulative from the start */
+            const auto tls_end = std::max(request.appconnect, request.connect);
+            auto row = *m_store->append();
+            row[m_columns.kind]     = request.kind;
+            row[m_columns.url]      = request.url;
+            row[m_columns.result]   = request.result == CURLE_OK ? std::to_string(request.response_code)
+                                                                  : curl_easy_strerror(request.result);
+            row[m_columns.dns]      = request.namelookup * 1000;
+            row[m_columns.connect]  = (request.connect - request.namelookup) * 1000;
+            row[m_columns.tls]      = request.appconnect > 0 ? (request.appconnect - request.connect) * 1000 : 0;
+            row[m_columns.wait]     = request.starttransfer > 0 ? (request.starttransfer - tls_end) * 1000 : 0;
+            row[m_columns.transfer] = request.starttransfer > 0 ? (request.total - request.starttransfer) * 1000 : 0;
+            row[m_columns.total]    = request.total * 1000;
+            row[m_columns.bytes]    = request.bytes_down;
+            row[m_columns.reused]   = request.reused;
+
+            if (request.reused)
+                ++reused;
+            total += request.total;
+        }
+
+        std::ostringstream summary;
+        summary << requests.size() << " requests, " << reused << " on reused connections";
+        if (!requests.empty())
+            summary << ", " << std::fixed << std::setprecision(1)
+                    << total * 1000 / requests.size() << " ms average";
+        m_summary->set_text(summary.str());
+    }
+
+    void RequestTraceWindow::on_export_clicked()
+    {
+        Gtk::FileChooserDialog dialog(*this, "Export Request Trace", Gtk::FILE_CHOOSER_ACTION_SAVE);
+        dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+        dialog.add_button("_Save", Gtk::RESPONSE_ACCEPT);
+        dialog.set_do_overwrite_confirmation(true);
+        dialog.set_current_name("mal-gtk-requests.json");
+
+        if (dialog.run() == Gtk::RESPONSE_ACCEPT)
+            m_mal->request_trace().write_chrome_trace(dialog.get_filename());
+    }
+}
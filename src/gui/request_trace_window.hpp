@@ -0,0 +1,70 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <memory>
+#include <gtkmm/button.h>
+#include <gtkmm/label.h>
+#include <gtkmm/liststore.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/window.h>
+#include "mal.hpp"
+
+namespace MAL {
+
+    /** Lists the most recent requests to myanimelist.net with where
+     * their time went, and exports them as a Chrome trace.
+     */
+	class RequestTraceWindow : public Gtk::Window {
+	public:
+		explicit RequestTraceWindow(const std::shared_ptr<MAL>& mal);
+
+        /** Reloads the list from MAL::request_trace().
+         */
+        void refresh();
+
+	private:
+        class Columns : public Gtk::TreeModel::ColumnRecord {
+        public:
+            Gtk::TreeModelColumn<Glib::ustring> kind;
+            Gtk::TreeModelColumn<Glib::ustring> url;
+            Gtk::TreeModelColumn<Glib::ustring> result;
+            Gtk::TreeModelColumn<double>        dns;
+            Gtk::TreeModelColumn<double>        connect;
+            Gtk::TreeModelColumn<double>        tls;
+            Gtk::TreeModelColumn<double>        wait;
+            Gtk::TreeModelColumn<double>        transfer;
+            Gtk::TreeModelColumn<double>        total;
+            Gtk::TreeModelColumn<gint64>        bytes;
+            Gtk::TreeModelColumn<bool>          reused;
+
+            Columns() {
+                add(kind); add(url); add(result); add(dns); add(connect); add(tls);
+                add(wait); add(transfer); add(total); add(bytes); add(reused);
+            }
+        };
+
+        std::shared_ptr<MAL>         m_mal;
+        Columns                      m_columns;
+        Glib::RefPtr<Gtk::ListStore> m_store;
+        Gtk::TreeView               *m_treeview;
+        Gtk::Label                  *m_summary;
+
+        void append_ms_column(const Glib::ustring& title, const Gtk::TreeModelColumn<double>& column);
+        void on_export_clicked();
+	};
+}
@@ -0,0 +1,195 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "html_form_scanner.hpp"
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <libxml/HTMLparser.h>
+
+namespace MAL {
+
+    namespace {
+        const char* attribute(const xmlChar **atts, const char *name, bool *present = nullptr)
+        {
+            if (present)
+                *present = false;
+            for (; atts && atts[0]; atts += 2) {
+                if (std::strcmp(reinterpret_cast<const char*>(atts[0]), name) == 0) {
+                    if (present)
+                        *present = true;
+                    return atts[1] ? reinterpret_cast<const char*>(atts[1]) : "";
+                }
+            }
+            return nullptr;
+        }
+
+        struct HtmlParserCtxtDeleter {
+            void operator()(htmlParserCtxtPtr ctxt) const {
+                htmlFreeParserCtxt(ctxt);
+            }
+        };
+    }
+
+    /* Where a scan is up to, handed to the SAX callbacks */
+    struct ScanState {
+        typedef HtmlFormScanner::Kind Kind;
+
+        const std::vector<HtmlFormScanner::Field>& fields;
+        std::vector<bool>  seen;
+        std::size_t        remaining;
+        htmlParserCtxtPtr  ctxt;
+        int                select;   /* Index into fields while inside a wanted <select> */
+        int                textarea; /* Likewise for <textarea> */
+        std::string        text;
+        bool               elements; /* Any element at all seen */
+
+        explicit ScanState(const std::vector<HtmlFormScanner::Field>& f) :
+            fields(f), seen(f.size(), false), remaining(f.size()), ctxt(nullptr),
+            select(-1), textarea(-1), elements(false)
+        {
+        }
+
+        int find(Kind kind, const char *name) const {
+            if (!name)
+                return -1;
+            for (std::size_t i = 0; i < fields.size(); ++i) {
+                if (!seen[i] && fields[i].kind == kind && std::strcmp(fields[i].name, name) == 0)
+                    return static_cast<int>(i);
+            }
+            return -1;
+        }
+
+        void set(int index, std::string&& value) {
+            fields[index].setter(std::move(value));
+            seen[index] = true;
+            if (--remaining == 0)
+                xmlStopParser(ctxt);
+        }
+
+        void start_element(const char *element, const xmlChar **atts) {
+            elements = true;
+            if (std::strcmp(element, "input") == 0) {
+                const char *type = attribute(atts, "type");
+                if (type && (std::strcmp(type, "text") == 0 || std::strcmp(type, "checkbox") == 0)) {
+                    const int index = find(Kind::INPUT, attribute(atts, "name"));
+                    if (index >= 0) {
+                        const char *value = attribute(atts, "value");
+                        set(index, value ? value : "");
+                    }
+                }
+            } else if (std::strcmp(element, "select") == 0) {
+                select = find(Kind::SELECT, attribute(atts, "name"));
+            } else if (std::strcmp(element, "option") == 0 && select >= 0) {
+                bool selected;
+                attribute(atts, "selected", &selected);
+                if (selected) {
+                    const char *value = attribute(atts, "value");
+                    const int index = select;
+                    select = -1;
+                    set(index, value ? value : "");
+                }
+            } else if (std::strcmp(element, "textarea") == 0) {
+                textarea = find(Kind::TEXTAREA, attribute(atts, "name"));
+                text.clear();
+            }
+        }
+
+        void end_element(const char *element) {
+            if (std::strcmp(element, "select") == 0) {
+                select = -1;
+            } else if (std::strcmp(element, "textarea") == 0 && textarea >= 0) {
+                const int index = textarea;
+                textarea = -1;
+                set(index, std::move(text));
+            }
+        }
+
+        void characters(const char *ch, int len) {
+            if (textarea >= 0)
+                text.append(ch, static_cast<std::size_t>(len));
+        }
+    };
+
+    namespace {
+        extern "C" {
+            static void
+            scan_start_element(void *ctx, const xmlChar *name, const xmlChar **atts)
+            {
+                static_cast<ScanState*>(ctx)->start_element(reinterpret_cast<const char*>(name), atts);
+            }
+
+            static void
+            scan_end_element(void *ctx, const xmlChar *name)
+            {
+                static_cast<ScanState*>(ctx)->end_element(reinterpret_cast<const char*>(name));
+            }
+
+            static void
+            scan_characters(void *ctx, const xmlChar *ch, int len)
+            {
+                static_cast<ScanState*>(ctx)->characters(reinterpret_cast<const char*>(ch), len);
+            }
+        }
+    }
+
+    void HtmlFormScanner::input(const char *name, Setter setter)
+    {
+        m_fields.push_back({Kind::INPUT, name, std::move(setter)});
+    }
+
+    void HtmlFormScanner::select(const char *name, Setter setter)
+    {
+        m_fields.push_back({Kind::SELECT, name, std::move(setter)});
+    }
+
+    void HtmlFormScanner::textarea(const char *name, Setter setter)
+    {
+        m_fields.push_back({Kind::TEXTAREA, name, std::move(setter)});
+    }
+
+    bool HtmlFormScanner::scan(const std::string& html) const
+    {
+        if (html.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+            return false;
+
+        htmlSAXHandler sax;
+        std::memset(&sax, 0, sizeof sax);
+        sax.startElement = scan_start_element;
+        sax.endElement   = scan_end_element;
+        sax.characters   = scan_characters;
+
+        ScanState state(m_fields);
+        std::unique_ptr<htmlParserCtxt, HtmlParserCtxtDeleter> ctxt(
+            htmlCreatePushParserCtxt(&sax, &state, nullptr, 0, "http://myanimelist.net/",
+                                     XML_CHAR_ENCODING_UTF8));
+        if (!ctxt)
+            return false;
+
+        state.ctxt = ctxt.get();
+        htmlCtxtUseOptions(ctxt.get(), HTML_PARSE_RECOVER | HTML_PARSE_NOERROR |
+                                       HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+        htmlParseChunk(ctxt.get(), html.data(), static_cast<int>(html.size()), 1);
+
+        /* Stopping once every field is in is not a failure. With
+         * HTML_PARSE_RECOVER only fatal errors, such as running out
+         * of memory, make libxml2 give up. */
+        if (state.remaining == 0)
+            return true;
+        return state.elements && ctxt->lastError.level != XML_ERR_FATAL;
+    }
+}
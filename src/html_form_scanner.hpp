@@ -0,0 +1,71 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MAL {
+
+    /** Pulls named form fields out of an HTML page.
+     *
+     * The page is parsed as a stream of SAX events; no document is
+     * built, and parsing stops as soon as every field asked for has
+     * been seen. Fields missing from the page are left alone.
+     */
+    class HtmlFormScanner {
+    public:
+        typedef std::function<void (std::string&& value)> Setter;
+
+        /** <input type="text|checkbox" name="name" value="...">
+         */
+        void input(const char *name, Setter setter);
+
+        /** The value of the <option selected> in <select name="name">.
+         */
+        void select(const char *name, Setter setter);
+
+        /** The text inside <textarea name="name">.
+         */
+        void textarea(const char *name, Setter setter);
+
+        /** Hands each field found in html to its setter, in page
+         * order.
+         *
+         * Returns false if html could not be parsed: no parser could
+         * be created, libxml2 gave up on it, or it held no elements
+         * at all, as with an empty reply. Some setters may have run
+         * by then, so callers should drop whatever they were filling
+         * in.
+         */
+        bool scan(const std::string& html) const;
+
+    private:
+        enum class Kind { INPUT, SELECT, TEXTAREA };
+
+        struct Field {
+            Kind        kind;
+            const char *name;
+            Setter      setter;
+        };
+
+        std::vector<Field> m_fields;
+
+        friend struct ScanState;
+    };
+}
@@ -0,0 +1,148 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "http_capture.hpp"
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace MAL {
+
+    namespace {
+        bool read_field(std::istream& in, std::size_t size, std::string& field)
+        {
+            field.resize(size);
+            if (size > 0 && !in.read(&field[0], static_cast<std::streamsize>(size)))
+                return false;
+            return in.get() == '\n';
+        }
+
+        /* headers without its Set-Cookie lines, which carry the
+         * session */
+        std::string without_cookies(const std::string& headers)
+        {
+            static const char set_cookie[] = "Set-Cookie:";
+            std::string out;
+            out.reserve(headers.size());
+            for (std::size_t start = 0; start < headers.size(); ) {
+                auto end = headers.find('\n', start);
+                end = end == std::string::npos ? headers.size() : end + 1;
+                if (strncasecmp(headers.c_str() + start, set_cookie, sizeof set_cookie - 1) != 0)
+                    out.append(headers, start, end - start);
+                start = end;
+            }
+            return out;
+        }
+    }
+
+    HttpCapture::HttpCapture(bool recording) :
+        m_recording(recording)
+    {
+    }
+
+    std::unique_ptr<HttpCapture> HttpCapture::record_to(const std::string& path)
+    {
+        std::unique_ptr<HttpCapture> capture(new HttpCapture(true));
+
+        /* Responses hold the user's lists and account pages, so only
+         * the user may read the file, even one left from before */
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd >= 0) {
+            ::fchmod(fd, S_IRUSR | S_IWUSR);
+            ::close(fd);
+            capture->m_out.open(path, std::ios::binary | std::ios::trunc);
+        }
+        if (!capture->m_out.is_open() || !capture->m_out) {
+            std::cerr << "Error: Unable to write HTTP capture to " << path << std::endl;
+            return nullptr;
+        }
+        return capture;
+    }
+
+    std::unique_ptr<HttpCapture> HttpCapture::replay_from(const std::string& path)
+    {
+        std::unique_ptr<HttpCapture> capture(new HttpCapture(false));
+        if (!load(path, capture->m_exchanges)) {
+            std::cerr << "Error: Unable to read HTTP capture " << path << std::endl;
+            return nullptr;
+        }
+        capture->m_used.assign(capture->m_exchanges.size(), false);
+        return capture;
+    }
+
+    bool HttpCapture::load(const std::string& path, std::vector<HttpExchange>& exchanges)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream header(line);
+            std::string tag;
+            std::size_t url_len, headers_len, body_len;
+            HttpExchange exchange;
+            header >> tag >> exchange.kind >> exchange.method >> exchange.status
+                   >> exchange.result >> exchange.total_us >> url_len >> headers_len >> body_len;
+            if (!header || tag != "exchange")
+                return false;
+
+            if (!read_field(in, url_len, exchange.url) ||
+                !read_field(in, headers_len, exchange.headers) ||
+                !read_field(in, body_len, exchange.body))
+                return false;
+
+            exchanges.push_back(std::move(exchange));
+        }
+
+        return in.eof();
+    }
+
+    void HttpCapture::record(const HttpExchange& exchange)
+    {
+        const auto headers = without_cookies(exchange.headers);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_out << "exchange " << exchange.kind << " " << exchange.method << " " << exchange.status
+              << " " << exchange.result << " " << exchange.total_us << " " << exchange.url.size()
+              << " " << headers.size() << " " << exchange.body.size() << "\n"
+              << exchange.url << "\n" << headers << "\n";
+        m_out.write(exchange.body.data(), static_cast<std::streamsize>(exchange.body.size()));
+        m_out << "\n";
+        m_out.flush();
+    }
+
+    const HttpExchange* HttpCapture::replay(const std::string& kind, const std::string& url)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const HttpExchange *last = nullptr;
+        for (std::size_t i = 0; i < m_exchanges.size(); ++i) {
+            const auto& exchange = m_exchanges[i];
+            if (exchange.kind != kind || exchange.url != url)
+                continue;
+            if (!m_used[i]) {
+                m_used[i] = true;
+                return &exchange;
+            }
+            last = &exchange;
+        }
+        return last;
+    }
+}
@@ -0,0 +1,97 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MAL {
+
+    /** One request to myanimelist.net and what came back.
+     */
+    struct HttpExchange {
+        std::string  kind;       /* As given to MAL::perform: "get", "image", ... */
+        std::string  method;
+        std::string  url;
+        long         status;     /* HTTP response code, 0 if none */
+        int          result;     /* CURLcode */
+        std::int64_t total_us;   /* Time the transfer took */
+        std::string  headers;    /* Response headers; Set-Cookie is not recorded */
+        std::string  body;       /* Response body */
+    };
+
+    /** A capture file of HttpExchanges, written during a real
+     * session and replayed in place of the network.
+     *
+     * The file is a sequence of records, each a header line
+     *
+     *   exchange KIND METHOD STATUS RESULT TOTAL_US URL_LEN HEADERS_LEN BODY_LEN
+     *
+     * followed by the url, headers and body, each of the given
+     * length and each followed by a newline. Bodies are stored as
+     * received, so images survive.
+     *
+     * Safe to use from multiple threads.
+     */
+    class HttpCapture {
+    public:
+        /** Appends every exchange to path, truncating it first.
+         *
+         * The file is made readable by the user only. Set-Cookie
+         * headers are left out, but bodies are kept whole, and they
+         * include the user's lists and account pages.
+         */
+        static std::unique_ptr<HttpCapture> record_to(const std::string& path);
+
+        /** Loads path to replay. Returns null, after saying why on
+         * std::cerr, if it can not be read.
+         */
+        static std::unique_ptr<HttpCapture> replay_from(const std::string& path);
+
+        /** Parses a whole capture file. Returns false if it is
+         * truncated or malformed; exchanges holds those before the
+         * error.
+         */
+        static bool load(const std::string& path, std::vector<HttpExchange>& exchanges);
+
+        bool replaying() const { return !m_recording; }
+
+        /** Writes exchange to the capture file. Recording only.
+         */
+        void record(const HttpExchange& exchange);
+
+        /** The recorded response to the next request of kind for
+         * url. Exchanges are handed out in the order they were
+         * recorded; once all matching ones have been used, the last
+         * is repeated. Returns null if there is none. Replaying only.
+         */
+        const HttpExchange* replay(const std::string& kind, const std::string& url);
+
+    private:
+        explicit HttpCapture(bool recording);
+
+        bool                      m_recording;
+        std::mutex                m_mutex;
+        std::ofstream             m_out;       /* Recording */
+        std::vector<HttpExchange> m_exchanges; /* Replaying */
+        std::vector<bool>         m_used;
+    };
+}
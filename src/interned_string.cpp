@@ -0,0 +1,73 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "interned_string.hpp"
+#include <mutex>
+#include <unordered_set>
+
+namespace MAL {
+
+    namespace {
+        struct StringPool {
+            std::mutex                      mutex;
+            std::unordered_set<std::string> strings; /* Nodes never move */
+        };
+
+        /* Function-local so that static MALItems can intern too */
+        StringPool& string_pool()
+        {
+            static StringPool *pool = new StringPool();
+            return *pool;
+        }
+
+        const std::string* empty_string()
+        {
+            static const std::string *empty = new std::string();
+            return empty;
+        }
+    }
+
+    const std::string* InternedString::intern(std::string&& str)
+    {
+        if (str.empty())
+            return empty_string();
+
+        auto& pool = string_pool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        return &*pool.strings.insert(std::move(str)).first;
+    }
+
+    InternedString::InternedString() :
+        m_str(empty_string())
+    {
+    }
+
+    InternedString::InternedString(const std::string& str) :
+        m_str(intern(std::string(str)))
+    {
+    }
+
+    InternedString::InternedString(std::string&& str) :
+        m_str(intern(std::move(str)))
+    {
+    }
+
+    InternedString::InternedString(const char *str) :
+        m_str(intern(std::string(str)))
+    {
+    }
+}
@@ -0,0 +1,119 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace MAL {
+
+    /** A handle to a string kept in a process-wide pool.
+     *
+     * Tags and fansub groups repeat across thousands of items; each
+     * distinct string is stored once and every item holds a
+     * pointer. Pooled strings are never freed, so only intern values
+     * drawn from a small, shared vocabulary, never per-item text
+     * such as titles or synonyms. Interning takes a lock, copying and
+     * comparing handles does not.
+     */
+    class InternedString {
+    public:
+        InternedString();
+        InternedString(const std::string& str);
+        InternedString(std::string&& str);
+        InternedString(const char *str);
+
+        const std::string& str() const { return *m_str; }
+        operator const std::string&() const { return *m_str; }
+
+        bool empty() const { return m_str->empty(); }
+        std::string::size_type size() const { return m_str->size(); }
+
+        /* Equal strings are interned to the same address */
+        friend bool operator==(const InternedString& l, const InternedString& r) { return l.m_str == r.m_str; }
+        friend bool operator!=(const InternedString& l, const InternedString& r) { return l.m_str != r.m_str; }
+
+        /* Orders by content, like std::string */
+        friend bool operator<(const InternedString& l, const InternedString& r) {
+            return l.m_str != r.m_str && *l.m_str < *r.m_str;
+        }
+
+    private:
+        static const std::string* intern(std::string&& str);
+
+        const std::string *m_str;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const InternedString& str)
+    {
+        return os << str.str();
+    }
+
+    /** A sorted set of strings, stored flat.
+     *
+     * Replaces std::set<std::string>: one allocation for the whole
+     * set instead of a tree node and a string each. T is
+     * InternedString for tags, std::string for synonyms.
+     */
+    template<typename T>
+    class FlatStringSet {
+    public:
+        typedef typename std::vector<T>::const_iterator const_iterator;
+        typedef const_iterator                          iterator;
+        typedef T                                       value_type;
+
+        const_iterator begin() const { return m_items.cbegin(); }
+        const_iterator end()   const { return m_items.cend(); }
+        std::size_t    size()  const { return m_items.size(); }
+        bool           empty() const { return m_items.empty(); }
+
+        void insert(T&& str) {
+            auto iter = std::lower_bound(m_items.begin(), m_items.end(), str);
+            if (iter == m_items.end() || *iter != str)
+                m_items.insert(iter, std::move(str));
+        }
+
+        void insert(const T& str) { insert(T(str)); }
+
+        /** Adds every string in other.
+         */
+        void merge(const FlatStringSet& other) {
+            if (other.m_items.empty() || other.m_items == m_items)
+                return;
+
+            std::vector<T> merged;
+            merged.reserve(m_items.size() + other.m_items.size());
+            std::set_union(m_items.cbegin(), m_items.cend(),
+                           other.m_items.cbegin(), other.m_items.cend(),
+                           std::back_inserter(merged));
+            merged.shrink_to_fit();
+            m_items.swap(merged);
+        }
+
+        friend bool operator==(const FlatStringSet& l, const FlatStringSet& r) { return l.m_items == r.m_items; }
+        friend bool operator!=(const FlatStringSet& l, const FlatStringSet& r) { return l.m_items != r.m_items; }
+
+    private:
+        std::vector<T> m_items;
+    };
+
+    typedef FlatStringSet<InternedString> InternedStringSet;
+    typedef FlatStringSet<std::string>    StringSet;
+}
@@ -0,0 +1,145 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "item_columns.hpp"
+#include <algorithm>
+#include <glib.h>
+
+namespace MAL {
+
+    constexpr std::size_t MALItemColumns::npos;
+
+    MALItemColumns::MALItemColumns(const std::shared_ptr<const void>& source, std::size_t n,
+                                   const MALItemColumns *previous) :
+        m_source(source),
+        m_previous(previous),
+        m_previous_row(0)
+    {
+        series_itemdb_id.reserve(n);
+        season_key.reserve(n);
+        score.reserve(n);
+        last_updated.reserve(n);
+        title_key.reserve(n);
+    }
+
+    void MALItemColumns::append(const MALItem& item)
+    {
+        series_itemdb_id.push_back(item.series_itemdb_id);
+        season_key.push_back(item.series_date_begin.season_key());
+        score.push_back(item.score);
+        last_updated.push_back(item.last_updated);
+        title_key.push_back(make_title_key(item));
+    }
+
+    std::string MALItemColumns::make_title_key(const MALItem& item)
+    {
+        /* Both stores are in id order, so walk the old one alongside */
+        if (m_previous) {
+            const auto& ids = m_previous->series_itemdb_id;
+            while (m_previous_row < ids.size() && ids[m_previous_row] < item.series_itemdb_id)
+                ++m_previous_row;
+            if (m_previous_row < ids.size() && ids[m_previous_row] == item.series_itemdb_id
+                && m_previous->item(m_previous_row)->series_title == item.series_title)
+                return m_previous->title_key[m_previous_row];
+        }
+
+        gchar *key = g_utf8_collate_key(item.series_title.c_str(), item.series_title.size());
+        std::string out(key);
+        g_free(key);
+        return out;
+    }
+
+    std::size_t MALItemColumns::index_of(int_fast64_t id) const
+    {
+        auto iter = std::lower_bound(series_itemdb_id.cbegin(), series_itemdb_id.cend(), id);
+        if (iter == series_itemdb_id.cend() || *iter != id)
+            return npos;
+        return static_cast<std::size_t>(iter - series_itemdb_id.cbegin());
+    }
+
+    void AnimeColumns::append(const std::shared_ptr<Anime>& anime)
+    {
+        MALItemColumns::append(*anime);
+        status.push_back(static_cast<std::int8_t>(anime->status));
+        series_type.push_back(static_cast<std::int8_t>(anime->series_type));
+        episodes.push_back(anime->episodes);
+        items.push_back(anime);
+    }
+
+    void AnimeColumns::for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const
+    {
+        std::for_each(items.cbegin(), items.cend(), f);
+    }
+
+    void AnimeColumns::match_status(AnimeStatus s, std::vector<std::uint8_t>& mask) const
+    {
+        const auto n = status.size();
+        const auto wanted = static_cast<std::int8_t>(s);
+        const std::int8_t *in = status.data();
+        mask.resize(n);
+        std::uint8_t *out = mask.data();
+
+        /* Simple enough for the compiler to vectorize */
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = in[i] == wanted;
+    }
+
+    void MangaColumns::append(const std::shared_ptr<Manga>& manga)
+    {
+        MALItemColumns::append(*manga);
+        status.push_back(static_cast<std::int8_t>(manga->status));
+        series_type.push_back(static_cast<std::int8_t>(manga->series_type));
+        chapters.push_back(manga->chapters);
+        volumes.push_back(manga->volumes);
+        items.push_back(manga);
+    }
+
+    void MangaColumns::for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const
+    {
+        std::for_each(items.cbegin(), items.cend(), f);
+    }
+
+    void MangaColumns::match_status(MangaStatus s, std::vector<std::uint8_t>& mask) const
+    {
+        const auto n = status.size();
+        const auto wanted = static_cast<std::int8_t>(s);
+        const std::int8_t *in = status.data();
+        mask.resize(n);
+        std::uint8_t *out = mask.data();
+
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = in[i] == wanted;
+    }
+
+    ItemVectorColumns::ItemVectorColumns(std::vector<std::shared_ptr<MALItem> >&& in) :
+        MALItemColumns(nullptr, in.size(), nullptr),
+        items(std::move(in))
+    {
+        std::sort(items.begin(), items.end(),
+                  [](const std::shared_ptr<MALItem>& l, const std::shared_ptr<MALItem>& r) {
+                      return l->series_itemdb_id < r->series_itemdb_id;
+                  });
+        for (const auto& item : items)
+            MALItemColumns::append(*item);
+        finish();
+    }
+
+    void ItemVectorColumns::for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const
+    {
+        std::for_each(items.cbegin(), items.cend(), f);
+    }
+}
@@ -0,0 +1,183 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "malitem.hpp"
+#include "anime.hpp"
+#include "manga.hpp"
+
+namespace MAL {
+
+    /** Struct-of-arrays copy of the fields the list views sort and
+     * filter on.
+     *
+     * Built once per published list snapshot, so it is immutable and
+     * may be shared between threads. Row i of every column describes
+     * the i-th item of the snapshot, in snapshot order (ascending
+     * series_itemdb_id).
+     */
+    class MALItemColumns {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        virtual ~MALItemColumns() = default;
+
+        std::size_t size() const { return series_itemdb_id.size(); }
+
+        /** Returns the row for series_itemdb_id, or npos.
+         */
+        std::size_t index_of(int_fast64_t id) const;
+
+        /** Returns the row for id, trying hint first.
+         *
+         * hint is a row index remembered from an earlier store, which
+         * stays correct unless items were inserted or removed since.
+         */
+        std::size_t resolve(std::size_t hint, int_fast64_t id) const {
+            if (hint < size() && series_itemdb_id[hint] == id)
+                return hint;
+            return index_of(id);
+        }
+
+        /** Returns the item at row index.
+         */
+        virtual std::shared_ptr<MALItem> item(std::size_t index) const = 0;
+
+        /** True if this store was built from the snapshot at source.
+         */
+        bool is_from(const void *source) const { return m_source.get() == source; }
+
+        /** Calls f for every item, in row order.
+         */
+        virtual void for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const = 0;
+
+        std::vector<int_fast64_t>  series_itemdb_id;
+        std::vector<std::uint32_t> season_key;
+        std::vector<float>         score;
+        std::vector<std::time_t>   last_updated;
+
+        /* g_utf8_collate_key() of series_title. Comparing two keys
+         * with std::string::compare() orders titles like
+         * g_utf8_collate() does, at the cost of a memcmp.
+         */
+        std::vector<std::string>   title_key;
+
+    protected:
+        /* previous, if given, is an older store for the same list.
+         * Its title keys are reused for titles that did not change.
+         */
+        MALItemColumns(const std::shared_ptr<const void>& source, std::size_t n,
+                       const MALItemColumns *previous);
+        void append(const MALItem& item);
+        void finish() { m_previous = nullptr; }
+
+    private:
+        std::string make_title_key(const MALItem& item);
+
+        std::shared_ptr<const void> m_source; /* Keeps the snapshot alive */
+        const MALItemColumns *m_previous;     /* Only set while building */
+        std::size_t           m_previous_row;
+    };
+
+    class AnimeColumns final : public MALItemColumns {
+    public:
+        template <typename Snapshot>
+        explicit AnimeColumns(const std::shared_ptr<const Snapshot>& snapshot,
+                              const AnimeColumns *previous = nullptr) :
+            MALItemColumns(snapshot, snapshot->size(), previous)
+            {
+                status.reserve(snapshot->size());
+                series_type.reserve(snapshot->size());
+                episodes.reserve(snapshot->size());
+                items.reserve(snapshot->size());
+                for (const auto& anime : *snapshot)
+                    append(anime);
+                finish();
+            }
+
+        virtual void for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const override;
+        virtual std::shared_ptr<MALItem> item(std::size_t index) const override { return items[index]; }
+
+        /** Sets mask[i] to 1 where status[i] == s, 0 elsewhere.
+         */
+        void match_status(AnimeStatus s, std::vector<std::uint8_t>& mask) const;
+
+        std::vector<std::int8_t>             status;
+        std::vector<std::int8_t>             series_type;
+        std::vector<std::int32_t>            episodes;
+        std::vector<std::shared_ptr<Anime> > items;
+
+    private:
+        void append(const std::shared_ptr<Anime>& anime);
+    };
+
+    class MangaColumns final : public MALItemColumns {
+    public:
+        template <typename Snapshot>
+        explicit MangaColumns(const std::shared_ptr<const Snapshot>& snapshot,
+                              const MangaColumns *previous = nullptr) :
+            MALItemColumns(snapshot, snapshot->size(), previous)
+            {
+                status.reserve(snapshot->size());
+                series_type.reserve(snapshot->size());
+                chapters.reserve(snapshot->size());
+                volumes.reserve(snapshot->size());
+                items.reserve(snapshot->size());
+                for (const auto& manga : *snapshot)
+                    append(manga);
+                finish();
+            }
+
+        virtual void for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const override;
+        virtual std::shared_ptr<MALItem> item(std::size_t index) const override { return items[index]; }
+
+        /** Sets mask[i] to 1 where status[i] == s, 0 elsewhere.
+         */
+        void match_status(MangaStatus s, std::vector<std::uint8_t>& mask) const;
+
+        std::vector<std::int8_t>             status;
+        std::vector<std::int8_t>             series_type;
+        std::vector<std::int32_t>            chapters;
+        std::vector<std::int32_t>            volumes;
+        std::vector<std::shared_ptr<Manga> > items;
+
+    private:
+        void append(const std::shared_ptr<Manga>& manga);
+    };
+
+    /** Columns over an arbitrary set of items, such as search
+     * results, which have no snapshot of their own.
+     *
+     * items need not be sorted; they are ordered by series_itemdb_id
+     * here.
+     */
+    class ItemVectorColumns final : public MALItemColumns {
+    public:
+        explicit ItemVectorColumns(std::vector<std::shared_ptr<MALItem> >&& items);
+
+        virtual void for_each_item(const std::function<void (const std::shared_ptr<MALItem>&)>& f) const override;
+        virtual std::shared_ptr<MALItem> item(std::size_t index) const override { return items[index]; }
+
+        std::vector<std::shared_ptr<MALItem> > items;
+    };
+}
@@ -0,0 +1,121 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "item_date.hpp"
+#include <cstring>
+
+namespace MAL {
+
+    namespace {
+        /* Parses exactly n ASCII digits, or returns -1 */
+        static inline int parse_digits(const char *s, int n)
+        {
+            int v = 0;
+            for (int i = 0; i < n; ++i) {
+                const unsigned d = static_cast<unsigned char>(s[i]) - '0';
+                if (d > 9)
+                    return -1;
+                v = v * 10 + static_cast<int>(d);
+            }
+            return v;
+        }
+
+        static inline void format_digits(char *out, int v, int n)
+        {
+            for (int i = n - 1; i >= 0; --i) {
+                out[i] = static_cast<char>('0' + v % 10);
+                v /= 10;
+            }
+        }
+    }
+
+    ItemDate::ItemDate(int year, int month, int day) :
+        m_packed(0)
+    {
+        if (year <= 0 || year > 9999)
+            return;
+        if (month < 0 || month > 12)
+            month = 0;
+        if (day < 0 || day > 31 || month == 0)
+            day = 0;
+
+        m_packed = (static_cast<std::uint32_t>(year)  << 16)
+                 | (static_cast<std::uint32_t>(month) << 8)
+                 |  static_cast<std::uint32_t>(day);
+    }
+
+    ItemDate ItemDate::parse(const std::string& str)
+    {
+        if (str.size() < 4)
+            return ItemDate();
+
+        const char *s = str.data();
+        const int year = parse_digits(s, 4);
+        int month = 0, day = 0;
+        if (str.size() >= 7 && s[4] == '-') {
+            month = parse_digits(s + 5, 2);
+            if (str.size() >= 10 && s[7] == '-')
+                day = parse_digits(s + 8, 2);
+        }
+
+        return ItemDate(year, month, day);
+    }
+
+    std::string ItemDate::to_string() const
+    {
+        char buf[10] = { '0', '0', '0', '0', '-', '0', '0', '-', '0', '0' };
+        format_digits(buf,     year(),  4);
+        format_digits(buf + 5, month(), 2);
+        format_digits(buf + 8, day(),   2);
+        return std::string(buf, sizeof(buf));
+    }
+
+    Glib::Date ItemDate::to_glib_date() const
+    {
+        Glib::Date out;
+        if (Glib::Date::valid_year(year()))
+            out.set_year(year());
+        if (Glib::Date::valid_month(static_cast<Glib::Date::Month>(month())))
+            out.set_month(static_cast<Glib::Date::Month>(month()));
+        if (Glib::Date::valid_day(day()))
+            out.set_day(day());
+        return out;
+    }
+
+    std::string ItemDate::season() const
+    {
+        const auto key = season_key();
+        if (key == 0)
+            return "Unknown";
+
+        /* "Autumn 65536" at most, built in place */
+        char buf[16];
+        std::size_t len = 0;
+        if (const char *name = malgtk_season_key_get_name(key)) {
+            len = std::strlen(name);
+            std::memcpy(buf, name, len);
+            buf[len++] = ' ';
+        }
+
+        const int y = malgtk_season_key_get_year(key);
+        int digits = 1;
+        for (int v = y; v >= 10; v /= 10)
+            ++digits;
+        format_digits(buf + len, y, digits);
+        return std::string(buf, len + digits);
+    }
+}
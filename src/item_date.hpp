@@ -0,0 +1,89 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <glibmm/date.h>
+#include "malgtk_season.h"
+
+namespace MAL {
+
+    /** A MAL date, parsed once and packed into 32 bits.
+     *
+     * MAL hands out "YYYY-MM-DD" strings where any part may be
+     * zero when unknown ("0000-00-00", "2012-04-00"). The year
+     * lives in the high 16 bits, then the month, then the day, so
+     * comparing the packed values orders dates the same way as
+     * comparing the strings did, unknown parts first.
+     */
+    class ItemDate {
+    public:
+        constexpr ItemDate() : m_packed(0) {}
+        ItemDate(int year, int month, int day);
+
+        /** Parses "YYYY-MM-DD", "YYYY-MM" or "YYYY". Anything that
+         * does not parse is treated as unknown.
+         */
+        static ItemDate parse(const std::string& str);
+
+        int year()  const { return static_cast<int>(m_packed >> 16); }
+        int month() const { return static_cast<int>((m_packed >> 8) & 0xff); }
+        int day()   const { return static_cast<int>(m_packed & 0xff); }
+
+        bool is_unknown()  const { return m_packed == 0; }
+        bool is_complete() const { return year() && month() && day(); }
+
+        /** Formats as "YYYY-MM-DD", with unknown parts as zeros.
+         */
+        std::string to_string() const;
+
+        /** Returns a Glib::Date with whichever parts are known set.
+         *
+         * The date is only valid() if all parts are known.
+         */
+        Glib::Date to_glib_date() const;
+
+        /** Integer sort key for the season, the same key as
+         * malgtk_date_get_season_key() gives; see malgtk_season.h.
+         */
+        std::uint32_t season_key() const {
+            return malgtk_season_key(year(), month());
+        }
+
+        /** "Winter", "Spring", "Summer" or "Autumn", or nullptr when
+         * the month is unknown. December counts towards the next
+         * year's winter, see season_year().
+         */
+        const char* season_name() const { return malgtk_season_key_get_name(season_key()); }
+        int season_year() const { return malgtk_season_key_get_year(season_key()); }
+
+        /** "Winter 2014", the year alone when the month is unknown,
+         * or "Unknown".
+         */
+        std::string season() const;
+
+        std::uint32_t packed() const { return m_packed; }
+
+        friend bool operator==(const ItemDate& l, const ItemDate& r) { return l.m_packed == r.m_packed; }
+        friend bool operator!=(const ItemDate& l, const ItemDate& r) { return l.m_packed != r.m_packed; }
+        friend bool operator< (const ItemDate& l, const ItemDate& r) { return l.m_packed <  r.m_packed; }
+
+    private:
+        std::uint32_t m_packed;
+    };
+}
@@ -0,0 +1,209 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency_monitor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <glibmm/main.h>
+
+namespace MAL {
+
+    bool LatencyMonitor::s_enabled = g_getenv("MALGTK_LATENCY_TRACE") != nullptr ||
+                                     g_getenv("MALGTK_LATENCY_TRACE_FILE") != nullptr;
+
+    constexpr guint       LatencyMonitor::heartbeat_ms;
+    constexpr gint64      LatencyMonitor::stall_threshold_us;
+    constexpr std::size_t LatencyMonitor::top_count;
+    constexpr std::size_t LatencyMonitor::trace_capacity;
+    constexpr gint64      LatencyMonitor::trace_min_us;
+    constexpr std::size_t LatencyMonitor::bucket_count;
+
+    LatencyMonitor& LatencyMonitor::get()
+    {
+        static LatencyMonitor monitor;
+        return monitor;
+    }
+
+    LatencyMonitor::LatencyMonitor() :
+        m_epoch         (g_get_monotonic_time()),
+        m_histogram     (),
+        m_expected_beat (0),
+        m_last_beat     (0),
+        m_current       (nullptr),
+        m_stopping      (false)
+    {
+        auto path = g_getenv("MALGTK_LATENCY_TRACE_FILE");
+        if (path)
+            m_trace_path = path;
+    }
+
+    LatencyMonitor::~LatencyMonitor()
+    {
+        stop();
+    }
+
+    void LatencyMonitor::start()
+    {
+        if (!s_enabled || m_heartbeat.connected())
+            return;
+
+        const auto now = g_get_monotonic_time();
+        m_last_beat = now;
+        m_expected_beat = now + heartbeat_ms * 1000;
+        m_heartbeat = Glib::signal_timeout().connect(sigc::mem_fun(*this, &LatencyMonitor::on_heartbeat),
+                                                     heartbeat_ms);
+        m_watchdog = std::thread([this] { watch(); });
+    }
+
+    void LatencyMonitor::stop()
+    {
+        if (!m_watchdog.joinable())
+            return;
+
+        m_heartbeat.disconnect();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cond.notify_one();
+        m_watchdog.join();
+
+        print_summary();
+        if (!m_trace_path.empty())
+            write_trace();
+    }
+
+    bool LatencyMonitor::on_heartbeat()
+    {
+        const auto now = g_get_monotonic_time();
+        const auto late = std::max<gint64>(0, now - m_expected_beat);
+        m_last_beat = now;
+        m_expected_beat = now + heartbeat_ms * 1000;
+
+        std::size_t bucket = 0;
+        for (auto ms = late / 1000; ms > 0 && bucket + 1 < bucket_count; ms >>= 1)
+            ++bucket;
+        ++m_histogram[bucket];
+
+        if (late >= trace_min_us && m_late_beats.size() < trace_capacity)
+            m_late_beats.push_back({"dispatch latency", now - late, late});
+
+        return true;
+    }
+
+    void LatencyMonitor::watch()
+    {
+        gint64 reported = 0; /* Beat of the stall already warned about */
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_cond.wait_for(lock, std::chrono::milliseconds(stall_threshold_us / 2000),
+                                [this] { return m_stopping; })) {
+            const gint64 beat = m_last_beat;
+            const auto stalled = g_get_monotonic_time() - beat;
+            if (stalled < stall_threshold_us || beat == reported)
+                continue;
+
+            reported = beat;
+            const char *current = m_current;
+            std::cerr << "Warning: Main loop stalled for " << stalled / 1000 << " ms"
+                      << (current ? " in " : "") << (current ? current : "") << std::endl;
+        }
+    }
+
+    void LatencyMonitor::record(const char *name, gint64 start, gint64 end, const char *outer)
+    {
+        m_current = outer;
+
+        const Event event {name, start, end - start};
+
+        auto& totals = m_totals[name];
+        ++totals.count;
+        totals.total += event.duration;
+        totals.max = std::max(totals.max, event.duration);
+
+        auto longer = [](const Event& a, const Event& b) { return a.duration > b.duration; };
+        if (m_slowest.size() < top_count || event.duration > m_slowest.back().duration) {
+            m_slowest.insert(std::upper_bound(m_slowest.begin(), m_slowest.end(), event, longer), event);
+            if (m_slowest.size() > top_count)
+                m_slowest.pop_back();
+        }
+
+        if (event.duration >= trace_min_us && m_trace.size() < trace_capacity)
+            m_trace.push_back(event);
+    }
+
+    void LatencyMonitor::print_summary() const
+    {
+        std::size_t beats = 0;
+        for (auto count : m_histogram)
+            beats += count;
+
+        std::cerr << "Main loop dispatch latency over " << beats << " heartbeats:" << std::endl;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            if (!m_histogram[i])
+                continue;
+
+            if (i + 1 < bucket_count)
+                std::cerr << "  < " << std::setw(5) << (1 << i) << " ms: ";
+            else
+                std::cerr << "  >= " << std::setw(4) << (1 << (i - 1)) << " ms: ";
+            std::cerr << m_histogram[i] << std::endl;
+        }
+
+        std::cerr << "Slowest main thread work:" << std::endl;
+        for (const auto& event : m_slowest) {
+            std::cerr << "  " << std::setw(8) << std::fixed << std::setprecision(2)
+                      << event.duration / 1000.0 << " ms  " << event.name
+                      << " at " << (event.start - m_epoch) / 1000 << " ms" << std::endl;
+        }
+
+        std::cerr << "Totals by scope (count, total ms, max ms):" << std::endl;
+        for (const auto& totals : m_totals) {
+            std::cerr << "  " << totals.first << ": " << totals.second.count << ", "
+                      << totals.second.total / 1000.0 << ", " << totals.second.max / 1000.0 << std::endl;
+        }
+    }
+
+    void LatencyMonitor::write_trace() const
+    {
+        std::ofstream out(m_trace_path);
+        if (!out) {
+            std::cerr << "Error: Unable to write latency trace to " << m_trace_path << std::endl;
+            return;
+        }
+
+        /* Names are string literals from the source, no escaping
+         * needed */
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (const auto* events : {&m_trace, &m_late_beats}) {
+            const auto tid = events == &m_trace ? 1 : 2;
+            for (const auto& event : *events) {
+                out << (first ? "" : ",") << "\n{\"name\":\"" << event.name
+                    << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << event.start - m_epoch
+                    << ",\"dur\":" << event.duration << "}";
+                first = false;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+        std::cerr << "Wrote latency trace to " << m_trace_path << std::endl;
+    }
+}
@@ -0,0 +1,158 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glib.h>
+#include <sigc++/connection.h>
+
+namespace MAL {
+
+    /** Measures how long the GTK+ main thread is kept from its main
+     * loop, and by what.
+     *
+     * Off unless the MALGTK_LATENCY_TRACE or
+     * MALGTK_LATENCY_TRACE_FILE environment variable is set. While
+     * on:
+     *
+     * - A heartbeat timeout records how late the main loop
+     *   dispatches it, into a histogram.
+     * - A watchdog thread prints a warning to std::cerr whenever the
+     *   heartbeat stops for longer than stall_threshold_us, naming
+     *   the Scope the main thread is inside.
+     * - Every Scope records its duration. The slowest are listed on
+     *   exit with the histogram.
+     * - If MALGTK_LATENCY_TRACE_FILE names a file, the scopes and
+     *   late heartbeats are written to it on exit as Chrome trace
+     *   JSON, for chrome://tracing or Perfetto.
+     */
+    class LatencyMonitor {
+    public:
+        LatencyMonitor(const LatencyMonitor&) = delete;
+        LatencyMonitor& operator=(const LatencyMonitor&) = delete;
+
+        static LatencyMonitor& get();
+
+        static bool enabled() { return s_enabled; }
+
+        /** Starts the heartbeat and watchdog. Call on the main
+         * thread before running the main loop. Does nothing unless
+         * enabled().
+         */
+        void start();
+
+        /** Stops measuring, prints the summary and writes the trace
+         * file.
+         */
+        void stop();
+
+        /** Times the enclosing block on the main thread.
+         *
+         * name must be a string literal. Costs one branch while the
+         * monitor is off.
+         */
+        class Scope {
+        public:
+            explicit Scope(const char *name) :
+                m_name(name),
+                m_start(s_enabled ? g_get_monotonic_time() : 0)
+            {
+                if (s_enabled)
+                    m_outer = get().m_current.exchange(name);
+            }
+
+            ~Scope() {
+                if (s_enabled && m_start)
+                    get().record(m_name, m_start, g_get_monotonic_time(), m_outer);
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            const char *m_name;
+            gint64      m_start;
+            const char *m_outer = nullptr;
+        };
+
+    private:
+        LatencyMonitor();
+        ~LatencyMonitor();
+
+        static bool s_enabled;
+
+        /* Heartbeat period, and how long it may be late before the
+         * watchdog warns */
+        static constexpr guint  heartbeat_ms       = 20;
+        static constexpr gint64 stall_threshold_us = G_USEC_PER_SEC / 5;
+
+        /* Slowest scopes kept for the summary, and trace events kept
+         * for the file. Only scopes of at least trace_min_us are
+         * traced. */
+        static constexpr std::size_t top_count      = 20;
+        static constexpr std::size_t trace_capacity = 200000;
+        static constexpr gint64      trace_min_us   = 1000;
+
+        /* Dispatch latency buckets: < 1 ms, < 2 ms, < 4 ms ... */
+        static constexpr std::size_t bucket_count = 12;
+
+        struct Event {
+            const char *name;
+            gint64      start;
+            gint64      duration;
+        };
+
+        struct Totals {
+            std::size_t count = 0;
+            gint64      total = 0;
+            gint64      max   = 0;
+        };
+
+        std::string                          m_trace_path;
+        gint64                               m_epoch;
+
+        /* Main thread only */
+        std::array<std::size_t, bucket_count> m_histogram;
+        gint64                               m_expected_beat;
+        std::map<std::string, Totals>        m_totals;
+        std::vector<Event>                   m_slowest; /* Sorted, longest first */
+        std::vector<Event>                   m_trace;
+        std::vector<Event>                   m_late_beats;
+        sigc::connection                     m_heartbeat;
+
+        /* Shared with the watchdog */
+        std::atomic<gint64>                  m_last_beat;
+        std::atomic<const char*>             m_current;
+        std::mutex                           m_mutex;
+        std::condition_variable              m_cond;
+        bool                                 m_stopping;
+        std::thread                          m_watchdog;
+
+        bool on_heartbeat();
+        void watch();
+        void record(const char *name, gint64 start, gint64 end, const char *outer);
+        void print_summary() const;
+        void write_trace() const;
+    };
+}
@@ -0,0 +1,50 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "local_lists.hpp"
+#include <iostream>
+#include "xml_reader.hpp"
+
+namespace MAL {
+
+    bool deserialize_local_lists(std::string&& xml,
+                                 const std::function<void (std::shared_ptr<Anime>&&)>& on_anime,
+                                 const std::function<void (std::shared_ptr<Manga>&&)>& on_manga)
+    {
+        XmlReader reader(std::move(xml));
+        reader.read();
+        try {
+            while(!(reader.get_name() == "mal-gtk" && reader.get_type() == XML_READER_TYPE_END_ELEMENT)) {
+                if (reader.get_name() == "anime" && reader.get_type() == XML_READER_TYPE_ELEMENT) {
+                    on_anime(std::make_shared<Anime>(reader));
+                } else if (reader.get_name() == "manga" && reader.get_type() == XML_READER_TYPE_ELEMENT) {
+                    on_manga(std::make_shared<Manga>(reader));
+                } else {
+                    if (reader.read() < 0)
+                        break;
+                }
+            }
+        } catch (std::exception e) {
+            std::cerr << "Caught exception " << e.what() << " on node " << reader.get_name() << " value '" << reader.get_value() << "'" << std::endl;
+            reader.read();
+            std::cerr << "Next node was " << reader.get_name() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
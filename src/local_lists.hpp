@@ -0,0 +1,65 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include "anime.hpp"
+#include "manga.hpp"
+#include "xml_writer.hpp"
+
+namespace MAL {
+
+    /** AnimeMangaList.xml, the local copy of the lists.
+     *
+     * <mal-gtk><anime_list><anime/>...</anime_list>
+     *          <manga_list><manga/>...</manga_list></mal-gtk>
+     *
+     * AnimeRange and MangaRange are any ranges of
+     * std::shared_ptr<Anime> and std::shared_ptr<Manga>, such as
+     * a SnapshotSet snapshot.
+     */
+    template<typename AnimeRange, typename MangaRange>
+    std::string serialize_local_lists(const AnimeRange& anime_list, const MangaRange& manga_list)
+    {
+        XmlWriter writer;
+        writer.startDoc();
+        writer.startElement("mal-gtk");
+        writer.startElement("anime_list");
+        for (const auto& anime : anime_list)
+            anime->serialize(writer);
+        writer.endElement();
+        writer.startElement("manga_list");
+        for (const auto& manga : manga_list)
+            manga->serialize(writer);
+        writer.endElement();
+        writer.endDoc();
+        return writer.getString();
+    }
+
+    /** Parses a document written by serialize_local_lists, handing
+     * each item to on_anime or on_manga in document order.
+     *
+     * Returns false if the document could not be parsed, after
+     * reporting why on std::cerr. Items handed over before the error
+     * are not taken back.
+     */
+    bool deserialize_local_lists(std::string&& xml,
+                                 const std::function<void (std::shared_ptr<Anime>&&)>& on_anime,
+                                 const std::function<void (std::shared_ptr<Manga>&&)>& on_manga);
+}
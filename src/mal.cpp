@@ -23,7 +23,10 @@
 #include <glibmm/miscutils.h>
 #include <glibmm.h>
 #include <chrono>
-#include "xml_reader.hpp"
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+#include "local_lists.hpp"
 
 namespace {
     extern "C" {
@@ -85,6 +88,54 @@ namespace {
         }
     }
 
+    /* Each transfer runs entirely on one m_io thread */
+    thread_local const std::unique_ptr<char[]> curl_ebuffer = std::make_unique<char[]>(CURL_ERROR_SIZE);
+
+    /* The two kinds of response buffer, for MAL::perform's capture */
+    std::size_t body_size(const std::string *body)
+    {
+        return body->size();
+    }
+
+    std::size_t body_size(const GByteArray *body)
+    {
+        return body->len;
+    }
+
+    std::string body_since(const std::string *body, std::size_t start)
+    {
+        return body->substr(start);
+    }
+
+    std::string body_since(const GByteArray *body, std::size_t start)
+    {
+        return std::string(reinterpret_cast<const char*>(body->data) + start, body->len - start);
+    }
+
+    void append_body(std::string *body, const std::string& data)
+    {
+        body->append(data);
+    }
+
+    void append_body(GByteArray *body, const std::string& data)
+    {
+        g_byte_array_append(body, reinterpret_cast<const guint8*>(data.data()), data.size());
+    }
+
+    std::string effective_method(CURL *curl, const char *kind)
+    {
+#if LIBCURL_VERSION_NUM >= 0x074800
+        char *method = nullptr;
+        if (curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_METHOD, &method) == CURLE_OK && method)
+            return method;
+#else
+        (void)curl;
+#endif
+        /* Only these fetch; the rest post a form */
+        const bool get = strcmp(kind, "get") == 0 || strcmp(kind, "image") == 0 || strcmp(kind, "search") == 0;
+        return get ? "GET" : "POST";
+    }
+
     static void
     print_curl_error(CURLcode code,
                      const std::unique_ptr<char[]>& curl_ebuffer)
@@ -161,10 +212,11 @@ namespace {
         }
     }
 
-    static CURLcode
-    curl_do_html_login(std::unique_ptr<CURL, MAL::CURLEasyDeleter>& curl,
-                       const std::string& username,
-                       const std::string& password)
+    static void
+    curl_setup_html_login(std::unique_ptr<CURL, MAL::CURLEasyDeleter>& curl,
+                          const std::string& login_url,
+                          const std::string& username,
+                          const std::string& password)
     {
         std::string fields = "username=";
         fields += username;
@@ -172,8 +224,86 @@ namespace {
         fields += password;
         fields += "&cookie=1";
         curl_setup_post(curl, fields);
-        curl_easy_setopt(curl.get(), CURLOPT_URL, "https://myanimelist.net/login.php");
-        return curl_easy_perform(curl.get());
+        curl_easy_setopt(curl.get(), CURLOPT_URL, login_url.c_str());
+    }
+
+    /* Merges item into list, recording an insertion or, when it
+     * differs from our copy, an update. Published items are never
+     * modified; a merged clone replaces them.
+     */
+    template <typename Set, typename Item>
+    static void
+    merge_item(Set& list, const std::shared_ptr<Item>& item, MAL::ItemChanges& changes)
+    {
+        auto iter = list.find(item);
+        if (iter != list.end()) {
+            auto merged = std::static_pointer_cast<Item>((**iter).clone());
+            merged->update_from_list(item);
+            if (!merged->equals(**iter)) {
+                iter = list.erase(iter);
+                list.insert(iter, merged);
+                changes.updated.push_back(item->series_itemdb_id);
+            }
+        } else {
+            list.insert(item);
+            changes.inserted.push_back(item->series_itemdb_id);
+        }
+    }
+
+    /* Merges a complete list fetched from myanimelist.net. A
+     * non-empty fetch is authoritative for what was in before, the
+     * list as it was when the request went out: anything in before
+     * that the fetch does not contain has been removed from the
+     * user's list. Items added since, by add_anime_sync or
+     * add_manga_sync, may be missing from the fetch and are kept.
+     */
+    template <typename Set, typename Item>
+    static void
+    merge_fetched_list(Set& list, const Set& before,
+                       const std::list<std::shared_ptr<Item> >& fetched, MAL::ItemChanges& changes)
+    {
+        std::unordered_set<int_fast64_t> seen;
+        seen.reserve(fetched.size());
+        for (const auto& item : fetched) {
+            seen.insert(item->series_itemdb_id);
+            merge_item(list, item, changes);
+        }
+
+        if (fetched.empty())
+            return;
+
+        for (auto iter = list.begin(); iter != list.end();) {
+            auto const id = (*iter)->series_itemdb_id;
+            if (seen.count(id) == 0 && before.count(*iter) != 0) {
+                changes.removed.push_back(id);
+                iter = list.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    /* Replaces the item with id in list by a clone modified by fn,
+     * recording an update if anything changed. Returns the clone, or
+     * nullptr if id is not in list.
+     */
+    template <typename Set, typename Fn>
+    static typename Set::value_type
+    modify_item(Set& list, const typename Set::value_type& key, MAL::ItemChanges& changes, Fn&& fn)
+    {
+        typedef typename Set::value_type::element_type Item;
+        auto iter = list.find(key);
+        if (iter == list.end())
+            return nullptr;
+
+        auto modified = std::static_pointer_cast<Item>((**iter).clone());
+        fn(*modified);
+        if (!modified->equals(**iter)) {
+            iter = list.erase(iter);
+            list.insert(iter, modified);
+            changes.updated.push_back(modified->series_itemdb_id);
+        }
+        return modified;
     }
 }
     
@@ -183,11 +313,19 @@ namespace MAL {
         text_util(std::make_shared<TextUtility>()),
         serializer(text_util),
         manga_serializer(text_util),
-        curl_ebuffer(std::make_unique<char[]>(CURL_ERROR_SIZE)),
         share_lock_functors(new pair_lock_functor_t(std::bind(&MAL::involke_lock_function, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
                                                     std::bind(&MAL::involke_unlock_function, this, std::placeholders::_1, std::placeholders::_2))),
-        curl_share(curl_share_init())
+        curl_share(curl_share_init()),
+        m_io(4),
+        m_writes(m_io),
+        m_disk(m_cpu)
     {
+        /* Created up front so the lock functions never modify the map */
+        for (int data = CURL_LOCK_DATA_NONE; data < CURL_LOCK_DATA_LAST; ++data)
+            map_mutex.emplace(std::piecewise_construct,
+                              std::forward_as_tuple(static_cast<curl_lock_data>(data)),
+                              std::tuple<>());
+
         signal_run_password_dialog.connect(sigc::mem_fun(*this, &MAL::run_password_dialog));
         CURLSHcode code;
 
@@ -216,6 +354,16 @@ namespace MAL {
             print_curl_share_error(code);
         }
 
+        auto record_path = g_getenv("MALGTK_RECORD");
+        auto replay_path = g_getenv("MALGTK_REPLAY");
+        if (replay_path && *replay_path)
+            m_capture = HttpCapture::replay_from(replay_path);
+        else if (record_path && *record_path)
+            m_capture = HttpCapture::record_to(record_path);
+
+        if (BASE_URL != DEFAULT_BASE_URL)
+            signal_mal_info("Using " + BASE_URL + " in place of myanimelist.net");
+
         if (!user_info->has_details()) {
             run_password_dialog();
         }
@@ -225,7 +373,26 @@ namespace MAL {
 
     MAL::~MAL()
     {
-        serialize_to_disk_async();
+        /* Fetches hand their parsing to m_cpu, so m_io goes first */
+        m_io.shutdown();
+        m_cpu.shutdown();
+        serialize_to_disk_sync();
+
+        auto trace_path = g_getenv("MALGTK_REQUEST_TRACE");
+        if (trace_path && *trace_path)
+            m_request_trace.write_chrome_trace(trace_path);
+    }
+
+    std::string MAL::base_url_from_environment()
+    {
+        std::string url = DEFAULT_BASE_URL;
+        auto env = g_getenv("MALGTK_BASE_URL");
+        if (env && *env) {
+            url = env;
+            while (url.size() > 1 && url.back() == '/')
+                url.pop_back();
+        }
+        return url;
     }
 
     void MAL::run_password_dialog() {
@@ -334,30 +501,28 @@ namespace MAL {
     void MAL::get_anime_list_async(DownloadProgressCb_t progress_cb,
                                    OperationCompleteCb_t complete_cb)
     {
-        active.send( [=] { this->get_anime_list_sync(progress_cb, complete_cb); } );
+        auto before = m_anime_list.snapshot();
+        run_async(m_io, [this, progress_cb] {
+                const std::string url = LIST_BASE_URL + user_info->get_username().get() + "&status=all&type=anime";
+                return get_sync(url, progress_cb);
+            }).then(m_cpu, [this, before, complete_cb] (std::unique_ptr<std::string> buf) {
+                merge_anime_list(std::move(buf), before, complete_cb);
+            });
     }
 
-    void MAL::get_anime_list_sync(DownloadProgressCb_t progress_cb,
-                                  OperationCompleteCb_t complete_cb)
+    void MAL::merge_anime_list(std::unique_ptr<std::string> buf,
+                               const AnimeSet::snapshot_type& before,
+                               const OperationCompleteCb_t& complete_cb)
     {
-        const std::string url = LIST_BASE_URL + user_info->get_username().get() + "&status=all&type=anime";
-        auto buf = get_sync(url, progress_cb);
         if (buf) {
             text_util->parse_html_entities(*buf);
             auto anime_list = serializer.deserialize(*buf);
         
-            {
-                std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-                std::for_each(anime_list.begin(), anime_list.end(),
-                              [this](const std::shared_ptr<Anime>& anime) {
-                                  auto iter = m_anime_list.find(anime);
-                                  if (iter != m_anime_list.end()) {
-                                      (**iter).update_from_list(anime);
-                                  } else {
-                                      m_anime_list.insert(anime);
-                                  }
-                              });
-            }
+            ItemChanges changes;
+            m_anime_list.update([&before, &anime_list, &changes](AnimeSet::set_type& list) {
+                    merge_fetched_list(list, *before, anime_list, changes);
+                });
+            send_anime_changes(std::move(changes));
 
             if (complete_cb)
                 cb_dispatcher.send(std::bind(complete_cb, true));
@@ -373,28 +538,27 @@ namespace MAL {
 
     void MAL::get_manga_list_async()
     {
-        active.send( [this](){ this->get_manga_list_sync(); } );
+        auto before = m_manga_list.snapshot();
+        run_async(m_io, [this] {
+                const std::string url = LIST_BASE_URL + user_info->get_username().get() + "&status=all&type=manga";
+                return get_sync(url);
+            }).then(m_cpu, [this, before] (std::unique_ptr<std::string> buf) {
+                merge_manga_list(std::move(buf), before);
+            });
     }
 
-    void MAL::get_manga_list_sync() {
-        const std::string url = LIST_BASE_URL + user_info->get_username().get() + "&status=all&type=manga";
-        auto buf = get_sync(url);
+    void MAL::merge_manga_list(std::unique_ptr<std::string> buf,
+                               const MangaSet::snapshot_type& before)
+    {
         if (buf) {
             text_util->parse_html_entities(*buf);
             auto manga_list = manga_serializer.deserialize(*buf);
 
-            {
-                std::lock_guard<std::mutex> lock(m_manga_list_mutex);
-                std::for_each(manga_list.begin(), manga_list.end(),
-                              [this](const std::shared_ptr<Manga>& manga) {
-                                  auto iter = m_manga_list.find(manga);
-                                  if (iter != m_manga_list.end()) {
-                                      (**iter).update_from_list(manga);
-                                  } else {
-                                      m_manga_list.insert(manga);
-                                  }
-                              });
-            }
+            ItemChanges changes;
+            m_manga_list.update([&before, &manga_list, &changes](MangaSet::set_type& list) {
+                    merge_fetched_list(list, *before, manga_list, changes);
+                });
+            send_manga_changes(std::move(changes));
 
             signal_manga_added();
             signal_mal_info("Refreshed manga list from myanimelist.net");
@@ -403,32 +567,41 @@ namespace MAL {
 
     void MAL::get_anime_details_async(const std::shared_ptr<const Anime>& anime)
     {
-        active.send( [this, anime](){ this->get_anime_details_sync(anime); } );
+        const std::string url = DETAILS_BASE_URL + std::to_string(anime->series_itemdb_id);
+        run_async(m_io, [this, url] {
+                return get_sync(url);
+            }).then(m_cpu, [this, anime] (std::unique_ptr<std::string> buf) {
+                merge_anime_details(std::move(buf), anime);
+            });
     }
 
     void MAL::get_manga_details_async(const std::shared_ptr<const Manga>& manga)
     {
-        active.send( [this, manga](){ this->get_manga_details_sync(manga); } );
+        const std::string url = MANGA_DETAILS_BASE_URL + std::to_string(manga->id);
+        run_async(m_io, [this, url] {
+                return get_sync(url);
+            }).then(m_cpu, [this, manga] (std::unique_ptr<std::string> buf) {
+                merge_manga_details(std::move(buf), manga);
+            });
     }
 
-    void MAL::get_manga_details_sync(const std::shared_ptr<const Manga>& manga)
+    void MAL::merge_manga_details(std::unique_ptr<std::string> buf,
+                                  const std::shared_ptr<const Manga>& manga)
     {
-        const std::string url = MANGA_DETAILS_BASE_URL + std::to_string(manga->id);
-        auto buf = get_sync(url);
         std::shared_ptr<Manga> details = nullptr;
         if (buf) {
             details = manga_serializer.deserialize_details(*buf);
         }
 
         if (details) {
-            std::lock_guard<std::mutex> lock(m_manga_list_mutex);
-            auto const id = manga->series_itemdb_id;
-            auto iter = std::find_if(m_manga_list.begin(), m_manga_list.end(), [id](const std::shared_ptr<Manga>& a) {
-                    return a->series_itemdb_id == id;
+            auto const key = std::const_pointer_cast<Manga>(manga);
+            ItemChanges changes;
+            m_manga_list.update([&key, &details, &changes](MangaSet::set_type& list) {
+                    modify_item(list, key, changes, [&details](Manga& detailed) {
+                            detailed.update_from_details(details);
+                        });
                 });
-            if (iter != m_manga_list.end()) {
-                (**iter).update_from_details(details);
-            }
+            send_manga_changes(std::move(changes));
 
             signal_manga_detailed();
             signal_mal_info(std::string("Downloaded extended details for ") + manga->series_title);
@@ -449,15 +622,16 @@ namespace MAL {
         std::unique_ptr<std::string> buf = std::make_unique<std::string>();
         setup_curl_easy(curl.get(), url, buf.get());
         curl_setup_httpauth(curl, user_info);
-        DownloadProgressCb_t bound_cb = [this, &progress_cb] (int_fast64_t progress) {
-            cb_dispatcher.send( std::bind(progress_cb, progress) );
+        const auto progress_key = cb_dispatcher.make_key();
+        DownloadProgressCb_t bound_cb = [this, &progress_cb, progress_key] (int_fast64_t progress) {
+            cb_dispatcher.send( progress_key, std::bind(progress_cb, progress) );
         };
 
         if (progress_cb) {
             curl_setup_progress(curl, bound_cb);
         }
 
-        CURLcode code = curl_easy_perform(curl.get());
+        CURLcode code = perform(curl.get(), "get", url, buf.get());
         if (code != CURLE_OK) {
             signal_mal_error(std::string("Error communicating with myanimelist.net: ") + curl_ebuffer.get());
             return nullptr;
@@ -466,7 +640,8 @@ namespace MAL {
         if (buf->find("Error: You must first login to see this page.") == std::string::npos) {
             return buf;
         } else {
-            code = curl_do_html_login(curl, user_info->get_username().get(), user_info->get_password().get());
+            curl_setup_html_login(curl, LOGIN_URL, user_info->get_username().get(), user_info->get_password().get());
+            code = perform(curl.get(), "login", LOGIN_URL, buf.get());
             if (code != CURLE_OK) {
                 signal_mal_error(std::string("Couldn't perform myanimelist.net php login: ") + curl_ebuffer.get() );
                 return nullptr;
@@ -486,7 +661,7 @@ namespace MAL {
                     curl_setup_progress(curl, bound_cb);
                 }
                 
-                code = curl_easy_perform(curl.get());
+                code = perform(curl.get(), "get", url, buf.get());
                 if (code != CURLE_OK) {
                     signal_mal_error(std::string("Error communicating with myanimelist.net: ") + curl_ebuffer.get());
                     return nullptr;
@@ -497,24 +672,23 @@ namespace MAL {
         }
     }
 
-    void MAL::get_anime_details_sync(const std::shared_ptr<const Anime>& anime)
+    void MAL::merge_anime_details(std::unique_ptr<std::string> buf,
+                                  const std::shared_ptr<const Anime>& anime)
     {
-        const std::string url = DETAILS_BASE_URL + std::to_string(anime->series_itemdb_id);
-        auto buf = get_sync(url);
         std::shared_ptr<Anime> details = nullptr;
         if (buf) {
             details = serializer.deserialize_details(*buf);
         }
 
         if (details) {
-            std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-            auto const id = anime->series_itemdb_id;
-            auto iter = std::find_if(m_anime_list.begin(), m_anime_list.end(), [id](const std::shared_ptr<Anime>& a) {
-                    return a->series_itemdb_id == id;
+            auto const key = std::const_pointer_cast<Anime>(anime);
+            ItemChanges changes;
+            m_anime_list.update([&key, &details, &changes](AnimeSet::set_type& list) {
+                    modify_item(list, key, changes, [&details](Anime& detailed) {
+                            detailed.update_from_details(details);
+                        });
                 });
-            if (iter != m_anime_list.end()) {
-                (**iter).update_from_details(details);
-            }
+            send_anime_changes(std::move(changes));
 
             signal_anime_detailed();
             signal_mal_info(std::string("Downloaded extended details for ") + anime->series_title);
@@ -526,19 +700,28 @@ namespace MAL {
     void MAL::get_image_async(const MALItem& item,
                               const std::function<void(const Glib::RefPtr<Gio::MemoryInputStream>&)>& cb)
     {
-        active.send([this, item, cb] {
-                auto img = get_image_sync(item);
-                cb_dispatcher.send(std::bind(cb, img));
+        run_async(m_io, [this, item] {
+                return get_image_sync(item);
+            }).then(cb_dispatcher, [cb] (Glib::RefPtr<Gio::MemoryInputStream> img) {
+                cb(img);
             });
     }
 
     Glib::RefPtr<Gio::MemoryInputStream> MAL::get_image_sync(const MALItem& item) {
-        auto iter = image_cache.find(item.image_url);
-        if (iter == std::end(image_cache)) {
+        Glib::RefPtr<Glib::Bytes> cached;
+        {
+            std::lock_guard<std::mutex> lock(image_cache_mutex);
+            auto iter = image_cache.find(item.image_url);
+            if (iter != std::end(image_cache))
+                cached = iter->second;
+        }
+
+        if (!cached) {
             std::unique_ptr<CURL, CURLEasyDeleter> curl {curl_easy_init()};
             GByteArray *ba = g_byte_array_new();
             setup_curl_easy_mis(curl.get(), item.image_url, ba);
-            CURLcode code = curl_easy_perform(curl.get());
+            long response_code = 0;
+            CURLcode code = perform(curl.get(), "image", item.image_url, ba, &response_code);
             
             if (code != CURLE_OK) {
                 print_curl_error(code, curl_ebuffer);
@@ -546,11 +729,10 @@ namespace MAL {
                 g_byte_array_free(ba, TRUE);
                 return Glib::RefPtr<Gio::MemoryInputStream>();
             } else {
-                char *url;
-                long response_code;
-                curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &response_code);
+                char *url = nullptr;
                 curl_easy_getinfo(curl.get(), CURLINFO_EFFECTIVE_URL, &url);
-                if (404 == response_code ||
+                if (404 == response_code || !url ||
+                    NOT_FOUND_URL == url ||
                     strcmp(url, "https://myanimelist.net/404.php") == 0 ||
                     strcmp(url, "http://myanimelist.net/404.php") == 0)
                 {
@@ -560,51 +742,60 @@ namespace MAL {
                 }
 
                 GBytes *gbytes = g_byte_array_free_to_bytes(ba);
+                std::lock_guard<std::mutex> lock(image_cache_mutex);
                 auto inserted = image_cache.emplace(item.image_url, Glib::wrap(gbytes));
-                auto mis = Gio::MemoryInputStream::create();
-                mis->add_bytes(inserted.first->second);
-                return mis;
+                cached = inserted.first->second;
             }
-        } else {
-            auto mis = Gio::MemoryInputStream::create();
-            mis->add_bytes(iter->second);
-            return mis;
         }
-    }
 
-    void MAL::search_anime_async(const std::string& terms) {
-        active.send( [this, terms](){ this->search_anime_sync(terms); } );
+        auto mis = Gio::MemoryInputStream::create();
+        mis->add_bytes(cached);
+        return mis;
     }
 
-    void MAL::search_anime_sync(const std::string& terms) {
+    std::unique_ptr<std::string> MAL::search_sync(const std::string& base_url,
+                                                  const std::string& terms)
+    {
         std::unique_ptr<CURL, CURLEasyDeleter> curl {curl_easy_init()};
         std::unique_ptr<std::string> buf = std::make_unique<std::string>();
         std::unique_ptr<char, CURLEscapeDeleter> terms_escaped {curl_easy_escape(curl.get(), terms.c_str(), terms.size())};
-        const std::string url = SEARCH_BASE_URL + terms_escaped.get();
+        const std::string url = base_url + terms_escaped.get();
 
         setup_curl_easy(curl.get(), url, buf.get());
         curl_setup_httpauth(curl, user_info);
 
-        CURLcode code = curl_easy_perform(curl.get());
+        long res = 0;
+        CURLcode code = perform(curl.get(), "search", url, buf.get(), &res);
         if (code != CURLE_OK) {
-            long res = 0;
-            code = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
-            if (code != CURLE_OK)
-                print_curl_error(code, curl_ebuffer);
-            else if (res == 401) {
+            if (res == 401) {
                 signal_run_password_dialog();
             } else {
                 signal_mal_error(std::string("Error searching myanimelist.net: ") + curl_ebuffer.get());
             }
-            return;
+            return nullptr;
         }
 
+        return buf;
+    }
+
+    void MAL::search_anime_async(const std::string& terms) {
+        run_async(m_io, [this, terms] {
+                return search_sync(SEARCH_BASE_URL, terms);
+            }).then(m_cpu, [this, terms] (std::unique_ptr<std::string> buf) {
+                merge_anime_search(std::move(buf), terms);
+            });
+    }
+
+    void MAL::merge_anime_search(std::unique_ptr<std::string> buf,
+                                 const std::string& terms)
+    {
+        if (!buf)
+            return;
+
         text_util->parse_html_entities(*buf);
         if (buf->size() > 0) {
             auto search_results = serializer.deserialize(*buf);
-            std::lock_guard<std::mutex> lock(m_anime_search_results_mutex);
-            m_anime_search_results.clear();
-            m_anime_search_results.insert(search_results.cbegin(), search_results.cend());
+            m_anime_search_results.reset(AnimeSet::set_type(search_results.cbegin(), search_results.cend()));
         } else {
             signal_mal_error("myanimelist.net returned zero responses for search terms '" + terms + "'");
         }
@@ -615,34 +806,20 @@ namespace MAL {
     void MAL::refresh_anime_async(const std::shared_ptr<Anime>& anime,
                                   const std::function<void (std::shared_ptr<Anime>& fresh_anime)>& cb)
     {
-        active.send( [this, anime, cb]() {
-                auto fresh_anime = refresh_anime_sync(anime);
-                cb_dispatcher.send(std::bind(cb, fresh_anime));
+        run_async(m_io, [this, anime] {
+                return search_sync(SEARCH_BASE_URL, anime->series_title);
+            }).then(m_cpu, [this, anime] (std::unique_ptr<std::string> buf) {
+                return merge_refreshed_anime(std::move(buf), anime);
+            }).then(cb_dispatcher, [cb] (std::shared_ptr<Anime> fresh_anime) {
+                cb(fresh_anime);
             });
     }
 
-    std::shared_ptr<Anime> MAL::refresh_anime_sync(const std::shared_ptr<Anime>& anime) {
-        std::unique_ptr<CURL, CURLEasyDeleter> curl {curl_easy_init()};
-        std::unique_ptr<std::string> buf = std::make_unique<std::string>();
-        std::unique_ptr<char, CURLEscapeDeleter> terms_escaped {curl_easy_escape(curl.get(), anime->series_title.c_str(), anime->series_title.size())};
-        const std::string url = SEARCH_BASE_URL + terms_escaped.get();
-
-        setup_curl_easy(curl.get(), url, buf.get());
-        curl_setup_httpauth(curl, user_info);
-
-        CURLcode code = curl_easy_perform(curl.get());
-        if (code != CURLE_OK) {
-            long res = 0;
-            code = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
-            if (code != CURLE_OK)
-                print_curl_error(code, curl_ebuffer);
-            else if (res == 401) {
-                signal_run_password_dialog();
-            } else {
-                signal_mal_error(std::string("Error searching myanimelist.net: ") + curl_ebuffer.get());
-            }
+    std::shared_ptr<Anime> MAL::merge_refreshed_anime(std::unique_ptr<std::string> buf,
+                                                      const std::shared_ptr<Anime>& anime)
+    {
+        if (!buf)
             return nullptr;
-        }
 
         text_util->parse_html_entities(*buf);
         if (!buf->empty()) {
@@ -661,14 +838,15 @@ namespace MAL {
                 return nullptr;
             }
 
-            {
-                std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-                auto it = m_anime_list.find(*match);
-                if (it != std::end(m_anime_list)) {
-                    (*it)->series_synopsis = std::move((*match)->series_synopsis);
-                    return *it;
-                }
-            }
+            std::shared_ptr<Anime> fresh = nullptr;
+            ItemChanges changes;
+            m_anime_list.update([&match, &fresh, &changes](AnimeSet::set_type& list) {
+                    fresh = modify_item(list, *match, changes, [&match](Anime& item) {
+                            item.series_synopsis = std::move((*match)->series_synopsis);
+                        });
+                });
+            send_anime_changes(std::move(changes));
+            return fresh;
         }
         return nullptr;
     }
@@ -676,35 +854,20 @@ namespace MAL {
     void MAL::refresh_manga_async(const std::shared_ptr<Manga>& manga,
                                   const std::function<void (std::shared_ptr<Manga>& fresh_manga)>& cb)
     {
-        active.send( [this, manga, cb]() {
-                auto fresh_manga = refresh_manga_sync(manga);
-                cb_dispatcher.send(std::bind(cb, fresh_manga));
+        run_async(m_io, [this, manga] {
+                return search_sync(MANGA_SEARCH_BASE_URL, manga->series_title);
+            }).then(m_cpu, [this, manga] (std::unique_ptr<std::string> buf) {
+                return merge_refreshed_manga(std::move(buf), manga);
+            }).then(cb_dispatcher, [cb] (std::shared_ptr<Manga> fresh_manga) {
+                cb(fresh_manga);
             });
     }
 
-    std::shared_ptr<Manga> MAL::refresh_manga_sync(const std::shared_ptr<Manga>& manga)
+    std::shared_ptr<Manga> MAL::merge_refreshed_manga(std::unique_ptr<std::string> buf,
+                                                      const std::shared_ptr<Manga>& manga)
     {
-        std::unique_ptr<CURL, CURLEasyDeleter> curl {curl_easy_init()};
-        std::unique_ptr<std::string> buf = std::make_unique<std::string>();
-        std::unique_ptr<char, CURLEscapeDeleter> terms_escaped {curl_easy_escape(curl.get(), manga->series_title.c_str(), manga->series_title.size())};
-        const std::string url = MANGA_SEARCH_BASE_URL + terms_escaped.get();
-
-        setup_curl_easy(curl.get(), url, buf.get());
-        curl_setup_httpauth(curl, user_info);
-
-        CURLcode code = curl_easy_perform(curl.get());
-        if (code != CURLE_OK) {
-            long res = 0;
-            code = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
-            if (code != CURLE_OK)
-                print_curl_error(code, curl_ebuffer);
-            else if (res == 401) {
-                signal_run_password_dialog();
-            } else {
-                signal_mal_error(std::string("Error searching myanimelist.net: ") + curl_ebuffer.get());
-            }
+        if (!buf)
             return nullptr;
-        }
 
         text_util->parse_html_entities(*buf);
         if (!buf->empty()) {
@@ -722,51 +885,37 @@ namespace MAL {
                 return nullptr;
             }
 
-            {
-                std::lock_guard<std::mutex> lock(m_manga_list_mutex);
-                auto it = m_manga_list.find(*match);
-                if (it != std::end(m_manga_list)) {
-                    (*it)->series_synopsis = std::move((*match)->series_synopsis);
-                    return *it;
-                }
-            }
+            std::shared_ptr<Manga> fresh = nullptr;
+            ItemChanges changes;
+            m_manga_list.update([&match, &fresh, &changes](MangaSet::set_type& list) {
+                    fresh = modify_item(list, *match, changes, [&match](Manga& item) {
+                            item.series_synopsis = std::move((*match)->series_synopsis);
+                        });
+                });
+            send_manga_changes(std::move(changes));
+            return fresh;
         }
         return nullptr;
     }
 
     void MAL::search_manga_async(const std::string& terms) {
-        active.send( [this, terms](){ this->search_manga_sync(terms); } );
+        run_async(m_io, [this, terms] {
+                return search_sync(MANGA_SEARCH_BASE_URL, terms);
+            }).then(m_cpu, [this, terms] (std::unique_ptr<std::string> buf) {
+                merge_manga_search(std::move(buf), terms);
+            });
     }
 
-    void MAL::search_manga_sync(const std::string& terms) {
-        std::unique_ptr<CURL, CURLEasyDeleter> curl {curl_easy_init()};
-        std::unique_ptr<std::string> buf = std::make_unique<std::string>();
-        std::unique_ptr<char, CURLEscapeDeleter> terms_escaped {curl_easy_escape(curl.get(), terms.c_str(), terms.size())};
-        const std::string url = MANGA_SEARCH_BASE_URL + terms_escaped.get();
-
-        setup_curl_easy(curl.get(), url, buf.get());
-        curl_setup_httpauth(curl, user_info);
-
-        CURLcode code = curl_easy_perform(curl.get());
-        if (code != CURLE_OK) {
-            long res = 0;
-            code = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
-            if (code != CURLE_OK)
-                print_curl_error(code, curl_ebuffer);
-            else if (res == 401) {
-                signal_run_password_dialog();
-            } else {
-                signal_mal_error(std::string("Error searching myanimelist.net: ") + curl_ebuffer.get());
-            }
+    void MAL::merge_manga_search(std::unique_ptr<std::string> buf,
+                                 const std::string& terms)
+    {
+        if (!buf)
             return;
-        }
 
         text_util->parse_html_entities(*buf);
         if (buf->size() > 0) {
             auto search_results = manga_serializer.deserialize(*buf);
-            std::lock_guard<std::mutex> lock(m_manga_search_results_mutex);
-            m_manga_search_results.clear();
-            m_manga_search_results.insert(search_results.cbegin(), search_results.cend());
+            m_manga_search_results.reset(MangaSet::set_type(search_results.cbegin(), search_results.cend()));
         } else {
             signal_mal_error("myanimelist.net returned zero responses for search terms '" + terms + "'");
         }
@@ -775,7 +924,7 @@ namespace MAL {
     }
 
     void MAL::update_anime_async(const std::shared_ptr<Anime>& anime) {
-        active.send( [=] { update_anime_sync(anime); } );
+        m_writes.post([this, anime] { update_anime_sync(anime); });
     }
     
     bool MAL::update_anime_sync(const std::shared_ptr<Anime>& anime) {
@@ -789,13 +938,10 @@ namespace MAL {
         curl_setup_post(curl, xml);
         curl_setup_httpauth(curl, user_info);
 
-        CURLcode code = curl_easy_perform(curl.get());
+        long res = 0;
+        CURLcode code = perform(curl.get(), "update", url, buf.get(), &res);
         if (code != CURLE_OK) {
-            long res = 0;
-            code = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
-            if (code != CURLE_OK)
-                print_curl_error(code, curl_ebuffer);
-            else if (res == 401) {
+            if (res == 401) {
                 signal_run_password_dialog();
             } else {
                 signal_mal_error(anime->series_title + " not updated due to myanimelist.net error: " + curl_ebuffer.get());
@@ -804,14 +950,22 @@ namespace MAL {
         }
 
         if (buf->compare("Updated") == 0) {
-            std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-            auto iter = std::find_if(m_anime_list.begin(), m_anime_list.end(), [&anime](const std::shared_ptr<Anime>& a) {
-                    return a->series_itemdb_id == anime->series_itemdb_id;
+            bool found = false;
+            ItemChanges changes;
+            m_anime_list.update([&anime, &found, &changes](AnimeSet::set_type& list) {
+                    auto iter = list.find(anime);
+                    if (iter != list.end()) {
+                        /* anime may be shared with the caller, so
+                         * publish a stamped copy of it */
+                        auto updated = std::static_pointer_cast<Anime>(anime->clone());
+                        updated->last_updated = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+                        AnimeSet::replace(list, updated);
+                        changes.updated.push_back(anime->series_itemdb_id);
+                        found = true;
+                    }
                 });
-            if (iter != m_anime_list.end()) {
-                anime->last_updated = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                m_anime_list.erase(iter);
-                m_anime_list.insert(anime);
+            send_anime_changes(std::move(changes));
+            if (found) {
                 signal_mal_info(anime->series_title + " successfully updated");
             } else {
                 signal_mal_error(anime->series_title + " updated, but is not in our local list. Programmer error!");
@@ -825,7 +979,7 @@ namespace MAL {
     }
 
     void MAL::update_manga_async(const std::shared_ptr<Manga>& manga) {
-        active.send( [this, manga](){ this->update_manga_sync(manga); } );
+        m_writes.post([this, manga] { update_manga_sync(manga); });
     }
 
     bool MAL::update_manga_sync(const std::shared_ptr<Manga>& manga) {
@@ -838,13 +992,10 @@ namespace MAL {
         curl_setup_post(curl, xml);
         curl_setup_httpauth(curl, user_info);
 
-        CURLcode code = curl_easy_perform(curl.get());
+        long res = 0;
+        CURLcode code = perform(curl.get(), "update", url, buf.get(), &res);
         if (code != CURLE_OK) {
-            long res = 0;
-            code = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
-            if (code != CURLE_OK)
-                print_curl_error(code, curl_ebuffer);
-            else if (res == 401) {
+            if (res == 401) {
                 signal_run_password_dialog();
             } else {
                 signal_mal_error(manga->series_title + " not updated due to myanimelist.net error: " + curl_ebuffer.get());
@@ -853,15 +1004,21 @@ namespace MAL {
         }
 
         if (buf->compare("Updated") == 0) {
-            std::lock_guard<std::mutex> lock(m_manga_list_mutex);
-            auto iter = std::find_if(m_manga_list.begin(), m_manga_list.end(), [&manga](const std::shared_ptr<Manga>& m) {
-                    return m->series_itemdb_id == manga->series_itemdb_id;
+            bool found = false;
+            ItemChanges changes;
+            m_manga_list.update([&manga, &found, &changes](MangaSet::set_type& list) {
+                    auto iter = list.find(manga);
+                    if (iter != list.end()) {
+                        auto updated = std::static_pointer_cast<Manga>(manga->clone());
+                        updated->last_updated = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+                        MangaSet::replace(list, updated);
+                        changes.updated.push_back(manga->series_itemdb_id);
+                        found = true;
+                    }
                 });
-            if (iter != m_manga_list.end()) {
-                m_manga_list.erase(iter);
-                m_manga_list.insert(manga);
+            send_manga_changes(std::move(changes));
+            if (found)
                 signal_mal_info(manga->series_title + " successfully updated");
-            }
             return true;
         } else {
             signal_mal_error(manga->series_title + " not updated due to myanimelist.net error: " + *buf);
@@ -873,7 +1030,7 @@ namespace MAL {
     MAL::add_anime_async(const Anime& anime,
                          OperationCompleteCb_t complete_cb)
     {
-        active.send( [=] { this->add_anime_sync(anime, complete_cb); } );
+        m_writes.post([this, anime, complete_cb] { add_anime_sync(anime, complete_cb); });
     }
 
     bool
@@ -890,11 +1047,10 @@ namespace MAL {
         xml.insert(0, "data=");
         curl_setup_post(curl, xml);
         curl_setup_httpauth(curl, user_info);
-        CURLcode code = curl_easy_perform(curl.get());
+        long res = 0;
+        CURLcode code = perform(curl.get(), "add", url, buf.get(), &res);
         if (code != CURLE_OK) {
             signal_mal_error(anime.series_title + " not added due to myanimelist.net error: " + curl_ebuffer.get());
-            long res = 0;
-            curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &res);
             if (res == 401) {
                 signal_run_password_dialog();
             }
@@ -904,13 +1060,11 @@ namespace MAL {
         if (code == CURLE_OK) {
             {
                 auto anime_p = std::static_pointer_cast<Anime>(anime.clone());
-                std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-                auto iter = m_anime_list.find(anime_p);
-                if (iter != m_anime_list.end()) {
-                    (**iter).update_from_list(anime_p);
-                } else {
-                    m_anime_list.insert(anime_p);
-                }
+                ItemChanges changes;
+                m_anime_list.update([&anime_p, &changes](AnimeSet::set_type& list) {
+                        merge_item(list, anime_p, changes);
+                    });
+                send_anime_changes(std::move(changes));
             }
 
             if (complete_cb)
@@ -929,7 +1083,7 @@ namespace MAL {
     }
 
     void MAL::add_manga_async(const Manga& manga) {
-        active.send( [this, manga](){ this->add_manga_sync(manga); } );
+        m_writes.post([this, manga] { add_manga_sync(manga); });
     }
 
     bool MAL::add_manga_sync(const Manga& manga) {
@@ -942,9 +1096,8 @@ namespace MAL {
         curl_setup_post(curl, xml);
         curl_setup_httpauth(curl, user_info);
 
-        CURLcode code = curl_easy_perform(curl.get());
         long html_code = 0;
-        curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &html_code);
+        CURLcode code = perform(curl.get(), "add", url, buf.get(), &html_code);
 
         if (code != CURLE_OK) {
             signal_mal_error(manga.series_title + " not added due to myanimelist.net error: " + curl_ebuffer.get());
@@ -964,15 +1117,64 @@ namespace MAL {
         }
     }
 
+    template<typename Body>
+    CURLcode MAL::perform(CURL *curl, const char *kind, const std::string& url, Body *body, long *status)
+    {
+        if (status)
+            *status = 0;
+
+        if (m_capture && m_capture->replaying()) {
+            auto exchange = m_capture->replay(kind, url);
+            if (!exchange) {
+                std::snprintf(curl_ebuffer.get(), CURL_ERROR_SIZE, "%s %s is not in the capture", kind, url.c_str());
+                return CURLE_COULDNT_CONNECT;
+            }
+            if (status)
+                *status = exchange->status;
+            append_body(body, exchange->body);
+            if (exchange->result != CURLE_OK)
+                std::snprintf(curl_ebuffer.get(), CURL_ERROR_SIZE, "Replayed HTTP %ld", exchange->status);
+            return static_cast<CURLcode>(exchange->result);
+        }
+
+        std::string headers;
+        const auto body_start = body_size(body);
+        if (m_capture) {
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &curl_write_function);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers);
+        }
+
+        const gint64 start = g_get_monotonic_time();
+        const CURLcode code = curl_easy_perform(curl);
+        m_request_trace.record(curl, kind, start, code);
+        if (status)
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, status);
+
+        if (m_capture) {
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, nullptr);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
+
+            HttpExchange exchange;
+            exchange.kind     = kind;
+            exchange.method   = effective_method(curl, kind);
+            exchange.url      = url;
+            exchange.status   = 0;
+            exchange.result   = code;
+            exchange.total_us = g_get_monotonic_time() - start;
+            exchange.headers  = std::move(headers);
+            exchange.body     = body_since(body, body_start);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &exchange.status);
+            m_capture->record(exchange);
+        }
+
+        return code;
+    }
+
     void MAL::involke_lock_function(CURL*, curl_lock_data data, curl_lock_access) {
         auto iter = map_mutex.find(data);
         if (iter == map_mutex.end()) {
-            auto res = map_mutex.emplace(std::piecewise_construct, std::forward_as_tuple(data), std::tuple<>());
-            if (!res.second) {
-                std::cerr << "Error: Trying to lock curl data but we can't create the mutex" << std::endl;
-                return;
-            }
-            iter = res.first;
+            std::cerr << "Error: Trying to lock curl data but we don't have the mutex." << std::endl;
+            return;
         }
 
         iter->second.lock();
@@ -990,39 +1192,46 @@ namespace MAL {
 
     void MAL::deserialize_from_disk_async()
     {
-        active.send( [this](){ deserialize_from_disk_sync(); } );
+        m_disk.post([this] { deserialize_from_disk_sync(); });
     }
 
     void MAL::deserialize_from_disk_sync()
     {
         auto filename = Glib::build_filename(Glib::get_user_data_dir(), "mal-gtk", "AnimeMangaList.xml");
         try {
-            XmlReader reader(Glib::file_get_contents(filename));
-            std::unique_lock<std::mutex> anime_lock(m_anime_list_mutex, std::defer_lock);
-            std::unique_lock<std::mutex> manga_lock(m_manga_list_mutex, std::defer_lock);
-            std::lock(anime_lock, manga_lock);
-            reader.read();
-            try {
-                while(!(reader.get_name() == "mal-gtk" && reader.get_type() == XML_READER_TYPE_END_ELEMENT)) {
-                    if (reader.get_name() == "anime" && reader.get_type() == XML_READER_TYPE_ELEMENT) {
-                        m_anime_list.insert(m_anime_list.end(), std::make_shared<Anime>(reader));
-                    } else if (reader.get_name() == "manga" && reader.get_type() == XML_READER_TYPE_ELEMENT) {
-                        m_manga_list.insert(m_manga_list.end(), std::make_shared<Manga>(reader));
-                    } else {
-                        if (reader.read() < 0)
-                            break;
-                    }
-                }
+            AnimeSet::set_type anime_list;
+            MangaSet::set_type manga_list;
+            const bool parsed = deserialize_local_lists(Glib::file_get_contents(filename),
+                [&anime_list](std::shared_ptr<Anime>&& anime) {
+                    anime_list.insert(anime_list.end(), std::move(anime));
+                },
+                [&manga_list](std::shared_ptr<Manga>&& manga) {
+                    manga_list.insert(manga_list.end(), std::move(manga));
+                });
+
+            if (parsed) {
+                ItemChanges anime_changes;
+                m_anime_list.update([&anime_list, &anime_changes](AnimeSet::set_type& list) {
+                        for (const auto& anime : anime_list) {
+                            if (list.insert(anime).second)
+                                anime_changes.inserted.push_back(anime->series_itemdb_id);
+                        }
+                    });
+                send_anime_changes(std::move(anime_changes));
+
+                ItemChanges manga_changes;
+                m_manga_list.update([&manga_list, &manga_changes](MangaSet::set_type& list) {
+                        for (const auto& manga : manga_list) {
+                            if (list.insert(manga).second)
+                                manga_changes.inserted.push_back(manga->series_itemdb_id);
+                        }
+                    });
+                send_manga_changes(std::move(manga_changes));
 
                 signal_anime_added();
                 signal_manga_added();
                 signal_mal_info("Loaded anime and manga list from local storage.");
-            } catch (std::exception e) {
-                std::cerr << "Caught exception " << e.what() << " on node " << reader.get_name() << " value '" << reader.get_value() << "'" << std::endl;
-                reader.read();
-                std::cerr << "Next node was " << reader.get_name() << std::endl;
             }
-
         } catch (Glib::FileError e) {
             if (e.code() != Glib::FileError::NO_SUCH_ENTITY)
                 signal_mal_error("Error reading anime list from disk: " + e.what());
@@ -1031,22 +1240,31 @@ namespace MAL {
         }
     }
 
+    void MAL::send_anime_changes(ItemChanges&& changes)
+    {
+        if (changes.empty())
+            return;
+
+        auto shared = std::make_shared<const ItemChanges>(std::move(changes));
+        cb_dispatcher.send([this, shared] { signal_anime_changed.emit(*shared); });
+    }
+
+    void MAL::send_manga_changes(ItemChanges&& changes)
+    {
+        if (changes.empty())
+            return;
+
+        auto shared = std::make_shared<const ItemChanges>(std::move(changes));
+        cb_dispatcher.send([this, shared] { signal_manga_changed.emit(*shared); });
+    }
+
     void MAL::serialize_to_disk_async() {
-        active.send( [this](){ serialize_to_disk_sync(); } );
+        m_disk.post([this] { serialize_to_disk_sync(); });
     }
 
     void MAL::serialize_to_disk_sync()
     {
-        XmlWriter writer;
-        writer.startDoc();
-        writer.startElement("mal-gtk");
-        writer.startElement("anime_list");
-        for_each_anime(std::bind(&Anime::serialize, std::placeholders::_1, std::ref(writer)));
-        writer.endElement();
-        writer.startElement("manga_list");
-        for_each_manga(std::bind(&Manga::serialize, std::placeholders::_1, std::ref(writer)));
-        writer.endElement();
-        writer.endDoc();
+        const auto xml = serialize_local_lists(*anime_snapshot(), *manga_snapshot());
 
         auto datadir = Glib::get_user_data_dir();
         auto dir = Glib::build_filename(datadir, "mal-gtk");
@@ -1070,7 +1288,7 @@ namespace MAL {
         }
         auto filename = Glib::build_filename(dir, "AnimeMangaList.xml");
         try {
-            Glib::file_set_contents(filename, writer.getString());
+            Glib::file_set_contents(filename, xml);
         } catch (Glib::FileError e) {
             signal_mal_error("Unable to save to disk: " + e.what());
         }
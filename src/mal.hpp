@@ -22,19 +22,26 @@
 #include <algorithm>
 #include <functional>
 #include <mutex>
+#include <vector>
 #include <curl/curl.h>
 #include <giomm/memoryinputstream.h>
 #include <glibmm/bytes.h>
 #include <glibmm/dispatcher.h>
+#include <sigc++/signal.h>
 #include "anime.hpp"
 #include "manga.hpp"
 #include "anime_serializer.hpp"
 #include "manga_serializer.hpp"
 #include "user_info.hpp"
 #include "text_util.hpp"
-#include "active.hpp"
+#include "task_pool.hpp"
+#include "future.hpp"
+#include "http_capture.hpp"
+#include "request_trace.hpp"
 #include "message_dispatcher.hpp"
 #include "callback_dispatcher.hpp"
+#include "snapshot_set.hpp"
+#include "item_columns.hpp"
 
 namespace MAL {
 
@@ -62,6 +69,18 @@ namespace MAL {
         }
     };
 
+    /** The series_itemdb_ids touched by one update of an item list.
+     */
+    struct ItemChanges {
+        std::vector<int_fast64_t> inserted;
+        std::vector<int_fast64_t> updated;
+        std::vector<int_fast64_t> removed;
+
+        bool empty() const {
+            return inserted.empty() && updated.empty() && removed.empty();
+        }
+    };
+
     /** Interface to myanimelist.net.
      *
      * Includes a local cache of lists downloaded. Network operations
@@ -71,26 +90,86 @@ namespace MAL {
         typedef std::function<void (CURL*, curl_lock_data, curl_lock_access)> lock_functor_t;
         typedef std::function<void (CURL*, curl_lock_data)> unlock_functor_t;
 
+        template <typename T>
+        class MALItemComparator {
+        public:
+            bool operator()(const std::shared_ptr<const T>& l,const std::shared_ptr<const T>& r) const
+                {
+                    return l->series_itemdb_id < r->series_itemdb_id;
+                    /*auto season = l->series_date_begin.substr(0,7).compare(r->series_date_begin.substr(0,7));
+                      if (season == 0)
+                      return l->series_itemdb_id < r->series_itemdb_id;
+                      else
+                      return season > 0;*/
+                };
+        };
+
     public:
         MAL(std::unique_ptr<UserInfo>&& info);
         ~MAL();
 
+        typedef SnapshotSet<Anime, MALItemComparator<Anime> > AnimeSet;
+        typedef SnapshotSet<Manga, MALItemComparator<Manga> > MangaSet;
+
+        /** Returns an immutable snapshot of the anime list.
+         *
+         * The snapshot may be iterated from any thread without
+         * locking. Items inside it must not be modified; clone them
+         * first.
+         */
+        AnimeSet::snapshot_type anime_snapshot() const {
+            return m_anime_list.snapshot();
+        }
+
+        /** Returns an immutable snapshot of the manga list.
+         */
+        MangaSet::snapshot_type manga_snapshot() const {
+            return m_manga_list.snapshot();
+        }
+
+        /** Returns the sort/filter columns for the current anime
+         * snapshot, building them on first use after a change.
+         */
+        std::shared_ptr<const AnimeColumns> anime_columns() {
+            auto snapshot = m_anime_list.snapshot();
+            auto columns  = std::atomic_load(&m_anime_columns);
+            if (!columns || !columns->is_from(snapshot.get())) {
+                columns = std::make_shared<const AnimeColumns>(snapshot, columns.get());
+                std::atomic_store(&m_anime_columns, columns);
+            }
+            return columns;
+        }
+
+        /** Returns the sort/filter columns for the current manga
+         * snapshot, building them on first use after a change.
+         */
+        std::shared_ptr<const MangaColumns> manga_columns() {
+            auto snapshot = m_manga_list.snapshot();
+            auto columns  = std::atomic_load(&m_manga_columns);
+            if (!columns || !columns->is_from(snapshot.get())) {
+                columns = std::make_shared<const MangaColumns>(snapshot, columns.get());
+                std::atomic_store(&m_manga_columns, columns);
+            }
+            return columns;
+        }
+
         /** Applies the given functor object f to all anime.
          *
-         * Used because the anime list is behind a mutex.
+         * Iterates a snapshot, so f may take as long as it likes
+         * without blocking list updates on the worker thread.
          */
         void for_each_anime(const std::function<void (const std::shared_ptr<Anime>& item)>& f) {
-            std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-            std::for_each(m_anime_list.cbegin(), m_anime_list.cend(), f);
+            auto snapshot = m_anime_list.snapshot();
+            std::for_each(snapshot->cbegin(), snapshot->cend(), f);
         }
 
         /** Applies the given functor object f to all manga.
          *
-         * Used because the manga list is behind a mutex.
+         * Iterates a snapshot, see for_each_anime.
          */
         void for_each_manga(const std::function<void (const std::shared_ptr<Manga>& item)>& f) {
-            std::lock_guard<std::mutex> lock(m_manga_list_mutex);
-            std::for_each(m_manga_list.cbegin(), m_manga_list.cend(), f);
+            auto snapshot = m_manga_list.snapshot();
+            std::for_each(snapshot->cbegin(), snapshot->cend(), f);
         }
 
         /** Applies the given functor object f to all anime search results.
@@ -98,8 +177,8 @@ namespace MAL {
          * TODO: Migrate to using CallbackDispatcher and remove.
          */
         void for_each_anime_search_result(const std::function<void (const std::shared_ptr<Anime>& item)>& f) {
-            std::lock_guard<std::mutex> lock(m_anime_search_results_mutex);
-            std::for_each(m_anime_search_results.cbegin(), m_anime_search_results.cend(), f);
+            auto snapshot = m_anime_search_results.snapshot();
+            std::for_each(snapshot->cbegin(), snapshot->cend(), f);
         }
 
         /** Applies the given functor object f to all manga search results.
@@ -107,21 +186,26 @@ namespace MAL {
          * TODO: Migrate to using CallbackDispatcher and remove.
          */
         void for_each_manga_search_result(const std::function<void (const std::shared_ptr<Manga>& item)>& f) {
-            std::lock_guard<std::mutex> lock(m_manga_search_results_mutex);
-            std::for_each(m_manga_search_results.cbegin(), m_manga_search_results.cend(), f);
+            auto snapshot = m_manga_search_results.snapshot();
+            std::for_each(snapshot->cbegin(), snapshot->cend(), f);
         }
 
-        std::shared_ptr<Anime>
-        find_anime(const std::shared_ptr<Anime>& anime)
+        /** Looks up our copy of anime in the current snapshot.
+         *
+         * The returned item is shared with the snapshot and is
+         * read-only.
+         */
+        std::shared_ptr<const Anime>
+        find_anime(const std::shared_ptr<Anime>& anime) const
             {
-                std::lock_guard<std::mutex> lock(m_anime_list_mutex);
-                auto iter = m_anime_list.find(anime);
-                if (iter == m_anime_list.end())
+                auto snapshot = m_anime_list.snapshot();
+                auto iter = snapshot->find(anime);
+                if (iter == snapshot->end())
                     return nullptr;
                 else
-                    return std::static_pointer_cast<Anime>((**iter).clone());
+                    return *iter;
             }
-        
+
         /** Provides a callback on GTK+ Main Thread when an error occurs.
          */
         MessageDispatcher<Glib::ustring> signal_mal_error;
@@ -162,6 +246,16 @@ namespace MAL {
 
         Glib::Dispatcher signal_anime_added;
         Glib::Dispatcher signal_manga_added;
+
+        /** Emitted on the GTK+ main thread after the anime list has
+         * changed, once per published snapshot. Fetch the new
+         * contents with anime_columns() or anime_snapshot().
+         */
+        sigc::signal<void, const ItemChanges&> signal_anime_changed;
+
+        /** As signal_anime_changed, for the manga list.
+         */
+        sigc::signal<void, const ItemChanges&> signal_manga_changed;
         Glib::Dispatcher signal_anime_search_completed;
         Glib::Dispatcher signal_manga_search_completed;
         Glib::Dispatcher signal_anime_detailed;
@@ -173,46 +267,59 @@ namespace MAL {
         typedef std::pair<lock_functor_t, unlock_functor_t> pair_lock_functor_t;
         void serialize_to_disk_async();
 
+        /** Timings of the most recent requests to myanimelist.net.
+         *
+         * Written out as Chrome trace JSON on exit when
+         * MALGTK_REQUEST_TRACE names a file.
+         */
+        const RequestTrace& request_trace() const { return m_request_trace; }
+
     private:
-        const std::string LIST_BASE_URL          = "https://myanimelist.net/malappinfo.php?u=";
-        const std::string DETAILS_BASE_URL       = "https://myanimelist.net/editlist.php?type=anime&id=";
-        const std::string SEARCH_BASE_URL        = "https://myanimelist.net/api/anime/search.xml?q=";
-        const std::string UPDATED_BASE_URL       = "https://myanimelist.net/api/animelist/update/";
-        const std::string ADD_BASE_URL           = "https://myanimelist.net/api/animelist/add/";
-        const std::string MANGA_DETAILS_BASE_URL = "https://myanimelist.net/panel.php?go=editmanga&id=";
-        const std::string MANGA_SEARCH_BASE_URL  = "https://myanimelist.net/api/manga/search.xml?q=";
-        const std::string MANGA_UPDATED_BASE_URL = "https://myanimelist.net/api/mangalist/update/";
-        const std::string MANGA_ADD_BASE_URL     = "https://myanimelist.net/api/mangalist/add/";
+        /* MALGTK_BASE_URL, so the application can be pointed at a
+         * stand-in server; DEFAULT_BASE_URL otherwise */
+        static constexpr const char *DEFAULT_BASE_URL = "https://myanimelist.net";
+        static std::string base_url_from_environment();
+
+        const std::string BASE_URL               = base_url_from_environment();
+        const std::string LOGIN_URL              = BASE_URL + "/login.php";
+        const std::string NOT_FOUND_URL          = BASE_URL + "/404.php";
+        const std::string LIST_BASE_URL          = BASE_URL + "/malappinfo.php?u=";
+        const std::string DETAILS_BASE_URL       = BASE_URL + "/editlist.php?type=anime&id=";
+        const std::string SEARCH_BASE_URL        = BASE_URL + "/api/anime/search.xml?q=";
+        const std::string UPDATED_BASE_URL       = BASE_URL + "/api/animelist/update/";
+        const std::string ADD_BASE_URL           = BASE_URL + "/api/animelist/add/";
+        const std::string MANGA_DETAILS_BASE_URL = BASE_URL + "/panel.php?go=editmanga&id=";
+        const std::string MANGA_SEARCH_BASE_URL  = BASE_URL + "/api/manga/search.xml?q=";
+        const std::string MANGA_UPDATED_BASE_URL = BASE_URL + "/api/mangalist/update/";
+        const std::string MANGA_ADD_BASE_URL     = BASE_URL + "/api/mangalist/add/";
 
         CallbackDispatcher cb_dispatcher;
 
-        /** Returns the anime list for username. As slow as the
-         * internet.
+        /** Fetches url. As slow as the internet.
          * Safe to call from multiple threads.
          */
-
-        void get_anime_list_sync(DownloadProgressCb_t progress_cb = nullptr,
-                                 OperationCompleteCb_t complete_cb = nullptr);
-
-        /** Returns the manga list for username. As slow as the
-         * internet.
-         * Safe to call from multiple threads.
-         */
-        void get_manga_list_sync();
-
         std::unique_ptr<std::string> get_sync(const std::string& url, DownloadProgressCb_t progress_cb = nullptr);
-        void get_anime_details_sync(const std::shared_ptr<const Anime>& anime);
-        void get_manga_details_sync(const std::shared_ptr<const Manga>& manga);
-
-        /** Searches MAL.net. Slow as the Internet.
-         * Safe to call from multiple threads.
-         */
-        void search_anime_sync(const std::string& terms);
 
-        /** Searches MAL.net. Slow as the Internet.
+        /** Fetches the search results for terms from the API at
+         * base_url, or nullptr on failure. As slow as the internet.
          * Safe to call from multiple threads.
          */
-        void search_manga_sync(const std::string& terms);
+        std::unique_ptr<std::string> search_sync(const std::string& base_url, const std::string& terms);
+
+        /* The parsing half of each request, run on m_cpu with what
+         * the fetch on m_io returned. Each accepts nullptr for a
+         * failed fetch. Safe to call from multiple threads.
+         * A list fetch also takes the list as it was before the
+         * request went out; see merge_fetched_list. */
+        void merge_anime_list(std::unique_ptr<std::string> buf, const AnimeSet::snapshot_type& before,
+                              const OperationCompleteCb_t& complete_cb);
+        void merge_manga_list(std::unique_ptr<std::string> buf, const MangaSet::snapshot_type& before);
+        void merge_anime_details(std::unique_ptr<std::string> buf, const std::shared_ptr<const Anime>& anime);
+        void merge_manga_details(std::unique_ptr<std::string> buf, const std::shared_ptr<const Manga>& manga);
+        void merge_anime_search(std::unique_ptr<std::string> buf, const std::string& terms);
+        void merge_manga_search(std::unique_ptr<std::string> buf, const std::string& terms);
+        std::shared_ptr<Anime> merge_refreshed_anime(std::unique_ptr<std::string> buf, const std::shared_ptr<Anime>& anime);
+        std::shared_ptr<Manga> merge_refreshed_manga(std::unique_ptr<std::string> buf, const std::shared_ptr<Manga>& manga);
 
         /** Updates MAL.net with the new anime details. As slow as the
          * Internet.
@@ -239,9 +346,6 @@ namespace MAL {
          */
         bool add_manga_sync(const Manga& manga);
 
-        std::shared_ptr<Anime> refresh_anime_sync(const std::shared_ptr<Anime>& item);
-        std::shared_ptr<Manga> refresh_manga_sync(const std::shared_ptr<Manga>& item);
-
         std::unique_ptr<UserInfo> user_info;
         Glib::Dispatcher signal_run_password_dialog;
         void run_password_dialog();
@@ -249,6 +353,19 @@ namespace MAL {
         void involke_lock_function(CURL*, curl_lock_data, curl_lock_access);
         void involke_unlock_function(CURL*, curl_lock_data);
 
+        /* curl_easy_perform() of url, recorded in m_request_trace
+         * under kind, a string literal. body is what the handle's
+         * write function appends to, a std::string or GByteArray.
+         *
+         * MALGTK_RECORD names a file to capture every exchange to;
+         * with MALGTK_REPLAY the response comes from such a capture
+         * and curl is never run, so ask for the HTTP response code
+         * through status rather than from curl; it is 0 if there
+         * was none. */
+        template<typename Body>
+        CURLcode perform(CURL *curl, const char *kind, const std::string& url, Body *body,
+                         long *status = nullptr);
+
         void setup_curl_easy(CURL* easy, const std::string& url, std::string*);
         void setup_curl_easy_mis(CURL* easy, const std::string& url, GByteArray *);
 
@@ -256,39 +373,36 @@ namespace MAL {
         void deserialize_from_disk_async();
         void deserialize_from_disk_sync();
 
-        template <typename T>
-        class MALItemComparator {
-        public:
-            bool operator()(const std::shared_ptr<const T>& l,const std::shared_ptr<const T>& r)
-                {
-                    return l->series_itemdb_id < r->series_itemdb_id;
-                    /*auto season = l->series_date_begin.substr(0,7).compare(r->series_date_begin.substr(0,7));
-                      if (season == 0)
-                      return l->series_itemdb_id < r->series_itemdb_id;
-                      else
-                      return season > 0;*/
-                };
-        };
+        /* Delivers changes to signal_*_changed on the main thread */
+        void send_anime_changes(ItemChanges&& changes);
+        void send_manga_changes(ItemChanges&& changes);
 
-        std::set<std::shared_ptr<Anime>, MALItemComparator<Anime> > m_anime_list;
-        std::mutex                                                  m_anime_list_mutex;
-        std::set<std::shared_ptr<Manga>, MALItemComparator<Manga> > m_manga_list;
-        std::mutex                                                  m_manga_list_mutex;
-        std::set<std::shared_ptr<Anime>, MALItemComparator<Anime> > m_anime_search_results;
-        std::mutex                                                  m_anime_search_results_mutex;
-        std::set<std::shared_ptr<Manga>, MALItemComparator<Manga> > m_manga_search_results;
-        std::mutex                                                  m_manga_search_results_mutex;
+        AnimeSet m_anime_list;
+        MangaSet m_manga_list;
+        AnimeSet m_anime_search_results;
+        MangaSet m_manga_search_results;
+
+        /* Only ever accessed through std::atomic_load/atomic_store */
+        std::shared_ptr<const AnimeColumns> m_anime_columns;
+        std::shared_ptr<const MangaColumns> m_manga_columns;
 
         std::shared_ptr<TextUtility> text_util;
         AnimeSerializer serializer;
         MangaSerializer manga_serializer;
-        std::unique_ptr<char[]> curl_ebuffer;
         std::unique_ptr<pair_lock_functor_t> share_lock_functors;
-        std::map<curl_lock_data, std::mutex> map_mutex;
-        
+        std::map<curl_lock_data, std::mutex> map_mutex; /* Filled in by the constructor, never modified after */
+
+        std::mutex image_cache_mutex;
         std::map<std::string, Glib::RefPtr<Glib::Bytes> > image_cache;
 
         std::unique_ptr<CURLSH, CURLShareDeleter> curl_share;
-        Active active; /* Must be destroyed before curl_share */
+        RequestTrace m_request_trace;
+        std::unique_ptr<HttpCapture> m_capture; /* Null unless recording or replaying */
+
+        /* Shut down by the destructor, before curl_share goes */
+        IOExecutor       m_io;     /* Network transfers */
+        WorkStealingPool m_cpu;    /* Parsing and merging */
+        Strand           m_writes; /* Updates and adds, in order, on m_io */
+        Strand           m_disk;   /* Reading and writing the local list, in order, on m_cpu */
     };
 }
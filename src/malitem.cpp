@@ -166,12 +166,13 @@ namespace MAL {
     MALItem::MALItem() :
         series_itemdb_id   {0},
         id                 {0},
+        last_updated       {0},
         score              {0.},
-        enable_reconsuming {false},
         downloaded_items   {0},
         times_consumed     {0},
         reconsume_value    {ReconsumeValue::INVALID},
         priority           {Priority::INVALID},
+        enable_reconsuming {false},
         enable_discussion  {false},
         has_details        {false}
     {
@@ -289,6 +290,33 @@ namespace MAL {
         return std::make_shared<MALItem>(*this);
     }
 
+    bool MALItem::equals(const MALItem& o) const
+    {
+        return series_itemdb_id       == o.series_itemdb_id
+            && last_updated           == o.last_updated
+            && series_title           == o.series_title
+            && series_preferred_title == o.series_preferred_title
+            && series_date_begin      == o.series_date_begin
+            && series_date_end        == o.series_date_end
+            && image_url              == o.image_url
+            && series_synonyms        == o.series_synonyms
+            && series_synopsis        == o.series_synopsis
+            && tags                   == o.tags
+            && date_start             == o.date_start
+            && date_finish            == o.date_finish
+            && id                     == o.id
+            && score                  == o.score
+            && enable_reconsuming     == o.enable_reconsuming
+            && fansub_group           == o.fansub_group
+            && comments               == o.comments
+            && downloaded_items       == o.downloaded_items
+            && times_consumed         == o.times_consumed
+            && reconsume_value        == o.reconsume_value
+            && priority               == o.priority
+            && enable_discussion      == o.enable_discussion
+            && has_details            == o.has_details;
+    }
+
     void MALItem::serialize(XmlWriter& writer) const
     {
         writer.startElement("MALitem");
@@ -298,30 +326,24 @@ namespace MAL {
         writer.writeElement("series_itemdb_id",   to_string(series_itemdb_id));
         writer.writeElement("series_title",                 series_title);
         writer.writeElement("series_preferred_title",       series_preferred_title);
-        writer.writeElement("series_date_begin",            series_date_begin);
-        writer.writeElement("series_date_end",              series_date_end);
+        writer.writeElement("series_date_begin",            series_date_begin.to_string());
+        writer.writeElement("series_date_end",              series_date_end.to_string());
         writer.writeElement("image_url",                    image_url);
 
         writer.startElement("series_synonyms");
-        std::for_each(std::begin(series_synonyms), std::end(series_synonyms),
-                      std::bind(&XmlWriter::writeElement,
-                                std::ref(writer),
-                                "series_synonym",
-                                std::placeholders::_1));
+        for (const std::string& synonym : series_synonyms)
+            writer.writeElement("series_synonym", synonym);
         writer.endElement();
 
         writer.writeElement("series_synopsis",              series_synopsis );
 
         writer.startElement("tags");
-        std::for_each(std::begin(tags), std::end(tags),
-                      std::bind(&XmlWriter::writeElement,
-                                std::ref(writer),
-                                "tag",
-                                std::placeholders::_1));
+        for (const std::string& tag : tags)
+            writer.writeElement("tag", tag);
         writer.endElement();
 
-        writer.writeElement("date_start",                   date_start);
-        writer.writeElement("date_finish",                  date_finish);
+        writer.writeElement("date_start",                   date_start.to_string());
+        writer.writeElement("date_finish",                  date_finish.to_string());
         writer.writeElement("id",                 to_string(id));
         writer.writeElement("last_updated",       to_string(last_updated));
         writer.writeElement("score",              to_string(score));
@@ -372,8 +394,8 @@ namespace MAL {
             image_url          = item->image_url;
             id                 = item->id;
             last_updated       = item->last_updated;
-            series_synonyms.insert(item->series_synonyms.begin(), item->series_synonyms.end());
-            tags           .insert(item->tags.begin(),            item->tags.end());
+            series_synonyms.merge(item->series_synonyms);
+            tags           .merge(item->tags);
             
             // TODO: handle conflicts for these:
             date_start         = item->date_start;
@@ -402,12 +424,12 @@ namespace MAL {
 
 	void MALItem::set_series_date_begin(std::string&& str)
 	{
-		series_date_begin = std::move(str);
+		series_date_begin = ItemDate::parse(str);
 	}
 
 	void MALItem::set_series_date_end(std::string&& str)
 	{
-		series_date_end = std::move(str);
+		series_date_end = ItemDate::parse(str);
 	}
 
 	void MALItem::set_image_url(std::string&& str)
@@ -470,12 +492,12 @@ namespace MAL {
 		
 	void MALItem::set_date_start(std::string&& str)
 	{
-		date_start = std::move(str);
+		date_start = ItemDate::parse(str);
 	}
 
 	void MALItem::set_date_finish(std::string&& str)
 	{
-		date_finish = std::move(str);
+		date_finish = ItemDate::parse(str);
 	}
 
 	void MALItem::set_id(std::string&& str)
@@ -545,76 +567,9 @@ namespace MAL {
 	}
 
     std::string MALItem::get_season_began() const {
-        return get_season(series_date_begin);
+        return series_date_begin.season();
     }
 
-	std::string MALItem::get_season(Glib::Date&& date) const {
-        if ( Glib::Date::valid_year(date.get_year()) ) {
-            if ( Glib::Date::valid_month(date.get_month()) ) {
-                switch (date.get_month()) {
-                    case Glib::Date::DECEMBER:
-                        date.add_years(1);
-                        [[fallthrough]];
-                    case Glib::Date::JANUARY:
-                    case Glib::Date::FEBRUARY:
-                        return "Winter " + std::to_string(date.get_year());
-                    case Glib::Date::MARCH:
-                    case Glib::Date::APRIL:
-                    case Glib::Date::MAY:
-                        return "Spring " + std::to_string(date.get_year());
-                    case Glib::Date::JUNE:
-                    case Glib::Date::JULY:
-                    case Glib::Date::AUGUST:
-                        return "Summer " + std::to_string(date.get_year());
-                    case Glib::Date::SEPTEMBER:
-                    case Glib::Date::OCTOBER:
-                    case Glib::Date::NOVEMBER:
-                        return "Autumn " + std::to_string(date.get_year());
-                    case Glib::Date::BAD_MONTH:
-                    default:
-                        return std::to_string(date.get_year());
-                }
-            } else {
-                return std::to_string(date.get_year());
-            }
-        } else {
-            return "Unknown";
-        }
-	}
-
-	std::string MALItem::get_season(const std::string& in) const {
-        Glib::Date::Year year  = std::stoi(in.substr(0,4));
-        const int        month = std::stoi(in.substr(5,2));
-
-        if ( Glib::Date::valid_year(year) ) {
-            switch (month) {
-                case 12:
-                    ++year;
-                    [[fallthrough]];
-                case 1:
-                case 2:
-                    return "Winter " + std::to_string(year);
-                case 3:
-                case 4:
-                case 5:
-                    return "Spring " + std::to_string(year);
-                case 6:
-                case 7:
-                case 8:
-                    return "Summer " + std::to_string(year);
-                case 9:
-                case 10:
-                case 11:
-                    return "Autumn " + std::to_string(year);
-                case 0:
-                default:
-                    return std::to_string(year);
-            }
-        } else {
-            return "Unknown";
-        }
-	}
-
     Glib::Date MALItem::get_date_began() const {
         return get_date(series_date_begin);
     }
@@ -623,40 +578,7 @@ namespace MAL {
         return get_date(series_date_end);
     }
 
-    Glib::Date MALItem::get_date(const std::string& in) const {
-        Glib::Date        out;
-        Glib::Date::Day   day   = 0;
-        Glib::Date::Month month = Glib::Date::BAD_MONTH;
-        Glib::Date::Year  year  = 0;
-
-        try {
-            year = std::stoi(in.substr(0,4));
-            day = std::stoi(in.substr(8,2));
-            switch (std::stoi(in.substr(5,2))) {
-                case 1:  month = Glib::Date::JANUARY;   break;
-                case 2:  month = Glib::Date::FEBRUARY;  break;
-                case 3:  month = Glib::Date::MARCH;     break;
-                case 4:  month = Glib::Date::APRIL;     break;
-                case 5:  month = Glib::Date::MAY;       break;
-                case 6:  month = Glib::Date::JUNE;      break;
-                case 7:  month = Glib::Date::JULY;      break;
-                case 8:  month = Glib::Date::AUGUST;    break;
-                case 9:  month = Glib::Date::SEPTEMBER; break;
-                case 10: month = Glib::Date::OCTOBER;   break;
-                case 11: month = Glib::Date::NOVEMBER;  break;
-                case 12: month = Glib::Date::DECEMBER;  break;
-                default: month = Glib::Date::BAD_MONTH; break;
-            }
-        } catch (std::exception e) {
-        }
-
-        if (Glib::Date::valid_year(year))
-            out.set_year(year);
-        if (Glib::Date::valid_month(month))
-            out.set_month(month);
-        if (Glib::Date::valid_day(day))
-            out.set_day(day);
-
-        return out;
+    Glib::Date MALItem::get_date(const ItemDate& date) const {
+        return date.to_glib_date();
     }
 }
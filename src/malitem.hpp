@@ -16,25 +16,27 @@
  */
 
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <ctime>
-#include <set>
 #include <glibmm/date.h>
 #include "xml_writer.hpp"
 #include "xml_reader.hpp"
+#include "item_date.hpp"
+#include "interned_string.hpp"
 #include "malgtk_malitem.h"
 
 namespace MAL {
 
-    enum class Priority : int {
+    enum class Priority : std::int8_t {
         INVALID = MALGTK_MALITEM_PRIORITY_INVALID,
         LOW     = MALGTK_MALITEM_PRIORITY_LOW,
         MEDIUM  = MALGTK_MALITEM_PRIORITY_MEDIUM,
         HIGH    = MALGTK_MALITEM_PRIORITY_HIGH
     };
 
-    enum class ReconsumeValue : int {
+    enum class ReconsumeValue : std::int8_t {
         INVALID   = MALGTK_MALITEM_RECONSUME_VALUE_INVALID,
         VERY_LOW  = MALGTK_MALITEM_RECONSUME_VALUE_VERY_LOW,
         LOW       = MALGTK_MALITEM_RECONSUME_VALUE_LOW,
@@ -58,6 +60,9 @@ namespace MAL {
         MALItem(XmlReader&);
 		virtual ~MALItem() = default;
         virtual std::shared_ptr<MALItem> clone() const;
+
+        /* Chain up. other must be of the same dynamic type */
+        virtual bool equals(const MALItem& other) const;
         MALItem& operator=(const MALItem&) = default;
         MALItem(const MALItem&) = default;
 
@@ -66,33 +71,34 @@ namespace MAL {
 
     public:
 
-		int_fast64_t          series_itemdb_id;   //N
-		std::string           series_title;       //D
-        std::string           series_preferred_title;
-		std::string           series_date_begin;  //D
-		std::string           series_date_end;    //D
-		std::string           image_url;          //D
-		std::set<std::string> series_synonyms;    //D
-		std::string           series_synopsis;    //D
-
-		std::set<std::string> tags;               // We know how to serialize /
-		std::string           date_start;         //Ddeserialize these fields
-		std::string           date_finish;        //D
-		int_fast64_t          id;                 //N<-- not serialized
-		std::time_t           last_updated;       //N<-- not serialized
-		float                 score;              //D
-		bool                  enable_reconsuming; //D
-
-		std::string           fansub_group;       //DWe know how to serialize
-		std::string           comments;           // these fields, but not
-		int_fast16_t          downloaded_items;   //Ddeserialize
-		int_fast16_t          times_consumed;     //D
-		ReconsumeValue        reconsume_value;    //D
-		Priority              priority;           //D
-		bool                  enable_discussion;  //
-
+        /* Fields read on every sort and filter come first so that
+         * they share the first cache line with the vtable pointer.
+         */
+        int_fast64_t          series_itemdb_id;   //N
+        int_fast64_t          id;                 //N<-- not serialized
+        std::time_t           last_updated;       //N<-- not serialized
+        float                 score;              //D
+        ItemDate              series_date_begin;  //D
+        ItemDate              series_date_end;    //D
+        ItemDate              date_start;         //D
+        ItemDate              date_finish;        //D
+        std::int32_t          downloaded_items;   //D
+        std::int32_t          times_consumed;     //D
+        ReconsumeValue        reconsume_value;    //D
+        Priority              priority;           //D
+        bool                  enable_reconsuming; //D
+        bool                  enable_discussion;  //
         bool                  has_details;
 
+        std::string           series_title;       //D
+        std::string           series_preferred_title;
+        std::string           image_url;          //D
+        std::string           series_synopsis;    //D
+        std::string           comments;           // We know how to serialize, but not deserialize
+        InternedString        fansub_group;       //D
+        StringSet             series_synonyms;    //D
+        InternedStringSet     tags;               //D
+
         virtual void update_from_details (const std::shared_ptr<MALItem>& details);
         virtual void update_from_list (const std::shared_ptr<MALItem>& item);
 
@@ -128,10 +134,7 @@ namespace MAL {
         std::string get_season_began() const;
         Glib::Date get_date_began() const;
         Glib::Date get_date_ended() const;
-        Glib::Date get_date(const std::string&) const;
-    private:
-        std::string get_season(Glib::Date&&) const;
-        std::string get_season(const std::string&) const;
+        Glib::Date get_date(const ItemDate&) const;
 	};
 
 }
@@ -254,6 +254,21 @@ namespace MAL {
         return std::make_shared<Manga>(*this);
     }
 
+    bool Manga::equals(const MALItem& other) const {
+        auto const& o = static_cast<const Manga&>(other);
+        return MALItem::equals(other)
+            && series_type       == o.series_type
+            && series_status     == o.series_status
+            && series_chapters   == o.series_chapters
+            && series_volumes    == o.series_volumes
+            && status            == o.status
+            && chapters          == o.chapters
+            && volumes           == o.volumes
+            && rereading_chapter == o.rereading_chapter
+            && retail_volumes    == o.retail_volumes
+            && storage_type      == o.storage_type;
+    }
+
     void Manga::serialize(XmlWriter& writer) const
     {
         writer.startElement("manga");
@@ -80,20 +80,21 @@ namespace MAL {
 		Manga();
         Manga(XmlReader& reader);
         virtual std::shared_ptr<MALItem> clone() const override;
+        virtual bool equals(const MALItem& other) const override;
         virtual void serialize(XmlWriter&) const override;
 
 		
 		MangaSeriesType       series_type;
 		MangaSeriesStatus     series_status;
-		int_fast16_t          series_chapters;
-		int_fast16_t          series_volumes;
+		std::int32_t          series_chapters;
+		std::int32_t          series_volumes;
 
 		MangaStatus           status;            // We know how to serialize /
-		int_fast16_t          chapters;          // deserialize these fields
-		int_fast16_t          volumes;           //
-		int_fast16_t          rereading_chapter; //
+		std::int32_t          chapters;          // deserialize these fields
+		std::int32_t          volumes;           //
+		std::int32_t          rereading_chapter; //
 
-		int_fast16_t          retail_volumes;    // We know how to serialize
+		std::int32_t          retail_volumes;    // We know how to serialize
                                                  // but not deserialize
 
         MangaStorageType      storage_type;      // Don't know how to serialize!
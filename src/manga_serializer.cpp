@@ -19,9 +19,9 @@
 #include <cstring>
 #include <memory>
 #include <libxml/xmlreader.h>
-#include <libxml/HTMLparser.h>
 #include "manga_serializer.hpp"
 #include "xml_writer.hpp"
+#include "html_form_scanner.hpp"
 
 namespace MAL {
 	enum MANGA_FIELDS : int_fast8_t { FIELDNONE, FIELDTEXT,
@@ -123,35 +123,12 @@ namespace {
 		}
 	};
 
-    struct htmlParserCtxtDeleter {
-        void operator()(htmlParserCtxtPtr parser) const {
-            htmlFreeParserCtxt (parser);
-        }
-    };
-
-    struct XmlCharDeleter {
-        void operator()(xmlChar* str) const {
-            if (str) xmlFree(str);
-        }
-    };
-
-    struct XmlDocDeleter {
-        void operator()(xmlDocPtr doc) const {
-            if (doc) xmlFreeDoc(doc);
-        }
-    };
-
 	static std::string xmlchar_to_str(const xmlChar* str) {
 		if (str)
 			return std::string(reinterpret_cast<const char*>(str));
 		else
 			return std::string();
-	}
-
-    constexpr const xmlChar* operator"" _xml(const char* str, size_t) {
-        return reinterpret_cast<const xmlChar*>(str);
-    }
-}
+	}}
 
 namespace MAL {
 
@@ -252,99 +229,23 @@ namespace MAL {
     MangaSerializer::deserialize_details(const std::string& xml) const
     {
         auto res = std::make_shared<Manga>();
-		std::unique_ptr<char[]> cstr(new char[xml.size()]);
-		std::memcpy(cstr.get(), xml.c_str(), xml.size());
-        std::unique_ptr<xmlDoc, XmlDocDeleter> doc(htmlReadMemory(cstr.get(), xml.size(), "http://myanimelist.net/",
-                                                                   nullptr, HTML_PARSE_RECOVER
-                                                                   | HTML_PARSE_NOERROR 
-                                                                   | HTML_PARSE_NOWARNING
-                                                                   | HTML_PARSE_NONET));
-		std::unique_ptr<xmlTextReader, xmlTextReaderDeleter> reader(xmlReaderWalker(doc.get()));
-		if (!reader) {
-			std::cerr << "Error: Couldn't create XML reader" << std::endl;
-            std::cerr << "XML follows: " << xml << std::endl;
-			return nullptr;
-		}
-        
-        enum { PRIORITY, STORAGE, REREADVALUE, DISCUSS, SELECTOR_NONE } selector = SELECTOR_NONE;
-        enum { TAGS, COMMENTS, NONE } textarea = NONE;
-        std::string textbuf;
-        int ret = 1;
-		for( ret = xmlTextReaderRead(reader.get()); ret == 1;
-		     ret = xmlTextReaderRead(reader.get()) ) {
-			const std::string name  = xmlchar_to_str(xmlTextReaderConstName (reader.get()));
+        Manga& manga = *res;
 
-            if (name == "input") {
-                std::unique_ptr<xmlChar, XmlCharDeleter> type(xmlTextReaderGetAttribute(reader.get(), "type"_xml));
-                std::unique_ptr<xmlChar, XmlCharDeleter> attr_name(xmlTextReaderGetAttribute(reader.get(), "name"_xml));
-                std::unique_ptr<xmlChar, XmlCharDeleter> attr_value(xmlTextReaderGetAttribute(reader.get(), "value"_xml));
-                if (type) {
-                    if (xmlStrEqual(type.get(), "text"_xml) || xmlStrEqual(type.get(), "checkbox"_xml)) {
-                        if (xmlStrEqual(attr_name.get(), "downloaded_chapters"_xml))
-                            res->set_downloaded_items(xmlchar_to_str(attr_value.get()));
-                        else if (xmlStrEqual(attr_name.get(), "times_read"_xml))
-                            res->set_times_consumed(xmlchar_to_str(attr_value.get()));
-                        else if (xmlStrEqual(attr_name.get(), "retail_volumes"_xml))
-                            res->set_retail_volumes(xmlchar_to_str(attr_value.get()));
-                    }
-                }
-            } else if (name == "textarea" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
-                std::unique_ptr<xmlChar, XmlCharDeleter> attr_name(xmlTextReaderGetAttribute(reader.get(), "name"_xml));
-                if (xmlStrEqual(attr_name.get(), "tags"_xml)) textarea = TAGS;
-                else if (xmlStrEqual(attr_name.get(), "comments"_xml)) textarea = COMMENTS;
-                else textarea = NONE;
-                textbuf.clear();
-            } else if (name == "textarea" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_END_ELEMENT) {
-                if (textarea != NONE) {
-                    switch (textarea) {
-                        case TAGS:
-                            /* Not a 'detailed' field */
-                            break;
-                        case COMMENTS:
-                            res->set_comments(std::string(textbuf));
-                            break;
-                        case NONE:
-                        default:
-                            break;
-                    }
-                    textarea = NONE;
-                }
-            } else if (name == "#text" && textarea != NONE) {
-                textbuf.append(xmlchar_to_str(xmlTextReaderConstValue(reader.get())));
-            } else if (name == "select" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
-                std::unique_ptr<xmlChar, XmlCharDeleter> attr_name(xmlTextReaderGetAttribute(reader.get(), "name"_xml));
-                if (xmlStrEqual(attr_name.get(), "priority"_xml)) selector = PRIORITY;
-                if (xmlStrEqual(attr_name.get(), "storage_num"_xml)) selector = STORAGE;
-                if (xmlStrEqual(attr_name.get(), "reread_value"_xml)) selector = REREADVALUE;
-                if (xmlStrEqual(attr_name.get(), "discuss"_xml)) selector = DISCUSS;                
-            } else if (name == "select" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_END_ELEMENT)  {
-                selector = SELECTOR_NONE;
-            } else if (name == "option" && xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
-                std::unique_ptr<xmlChar, XmlCharDeleter> value(xmlTextReaderGetAttribute(reader.get(), "value"_xml));
-                if (xmlTextReaderMoveToAttribute(reader.get(), "selected"_xml) == 1) {
-                    switch (selector) {
-                        case PRIORITY:
-                            res->set_priority(xmlchar_to_str(value.get()));
-                            break;
-                        case STORAGE:
-                            res->set_storage_type(xmlchar_to_str(value.get()));
-                            break;
-                        case REREADVALUE:
-                            res->set_reconsume_value(xmlchar_to_str(value.get()));
-                            break;
-                        case DISCUSS:
-                            res->set_enable_discussion(xmlchar_to_str(value.get()));
-                            break;
-                        case SELECTOR_NONE:
-                        default:
-                            break;
-                    }
-                }
-            }
+        HtmlFormScanner scanner;
+        scanner.input("downloaded_chapters", [&manga](std::string&& v) { manga.set_downloaded_items(std::move(v)); });
+        scanner.input("times_read",          [&manga](std::string&& v) { manga.set_times_consumed(std::move(v)); });
+        scanner.input("retail_volumes",      [&manga](std::string&& v) { manga.set_retail_volumes(std::move(v)); });
+        scanner.select("priority",           [&manga](std::string&& v) { manga.set_priority(std::move(v)); });
+        scanner.select("storage_num",        [&manga](std::string&& v) { manga.set_storage_type(std::move(v)); });
+        scanner.select("reread_value",       [&manga](std::string&& v) { manga.set_reconsume_value(std::move(v)); });
+        scanner.select("discuss",            [&manga](std::string&& v) { manga.set_enable_discussion(std::move(v)); });
+        scanner.textarea("comments",         [&manga](std::string&& v) { manga.set_comments(std::move(v)); });
+
+        if (!scanner.scan(xml)) {
+			std::cerr << "Error: Couldn't parse the details page" << std::endl;
+			return nullptr;
         }
 
-        if (ret != 0) return nullptr; // Some sort of parsing error
-        
         return res;
     }
 
@@ -362,8 +263,8 @@ namespace MAL {
             writer.writeElement("times_reread", to_string(manga.times_consumed));
             writer.writeElement("reread_value", to_string(manga.reconsume_value));
         }
-        writer.writeElement("date_start", manga.date_start);
-        writer.writeElement("date_finish", manga.date_finish);
+        writer.writeElement("date_start", manga.date_start.to_string());
+        writer.writeElement("date_finish", manga.date_finish.to_string());
         if (manga.has_details) {
             writer.writeElement("priority", to_string(static_cast<int>(manga.priority)));
             writer.writeElement("enable_discussion", manga.enable_discussion?"1":"0");
@@ -384,7 +285,7 @@ namespace MAL {
 		while (iter != manga.tags.end()) {
 			if (!was_first)
 				tags += ", ";
-			tags += *iter;
+			tags += iter->str();
 			was_first = false;
 			++iter;
 		}
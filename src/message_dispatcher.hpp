@@ -1,5 +1,5 @@
 #include <glibmm/dispatcher.h>
-#include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 
@@ -11,6 +11,12 @@ namespace MAL {
      *  Must be used with Glib::Dispatcher constraints (instantiated
      *  and deleted in receiving thread which must have a
      *  GMainContext).
+     *
+     *  The dispatcher is emitted for every message. Connected slots
+     *  should empty the queue with a single take_all(), and expect
+     *  to find it empty when an earlier call already took the
+     *  message. Messages sent before any slot was connected wait in
+     *  the queue for the next take_all().
      */
     template <typename T>
     class MessageDispatcher {
@@ -21,8 +27,11 @@ namespace MAL {
 
         template <class U>
         void operator()(U&& u) {
-            std::lock_guard<std::mutex> lock(mutex);
-            msgs.push(std::forward<U>(u));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                msgs.push_back(std::forward<U>(u));
+            }
+
             dispatcher();
         }
 
@@ -31,19 +40,13 @@ namespace MAL {
             return dispatcher.connect(std::forward<Void_slot>(void_slot));
         }
 
-        typename std::queue<T>::const_reference front() const {
-            std::lock_guard<std::mutex> lock(mutex);
-            return msgs.front();
-        }
-
-        typename std::queue<T>::reference front() {
-            std::lock_guard<std::mutex> lock(mutex);
-            return msgs.front();
-        }
-
-        void pop() {
+        /** Removes and returns every queued message, oldest first.
+         */
+        std::deque<T> take_all() {
+            std::deque<T> out;
             std::lock_guard<std::mutex> lock(mutex);
-            msgs.pop();
+            out.swap(msgs);
+            return out;
         }
 
         bool empty() const {
@@ -52,7 +55,7 @@ namespace MAL {
         }
         
     private:
-        std::queue<T>      msgs;
+        std::deque<T>      msgs;
         mutable std::mutex mutex;
         Glib::Dispatcher   dispatcher;
     };
@@ -0,0 +1,189 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "request_trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace MAL {
+
+    namespace {
+        unsigned thread_number()
+        {
+            static std::atomic<unsigned> next(1);
+            thread_local const unsigned number = next++;
+            return number;
+        }
+
+        void append_json_string(std::ostream& out, const std::string& str)
+        {
+            out << '"';
+            for (const char c : str) {
+                switch (c) {
+                    case '"':  out << "\\\""; break;
+                    case '\\': out << "\\\\"; break;
+                    case '\n': out << "\\n"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char buf[8];
+                            std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                            out << buf;
+                        } else {
+                            out << c;
+                        }
+                }
+            }
+            out << '"';
+        }
+
+        void append_slice(std::ostream& out, bool& first, const char *name, unsigned tid,
+                          gint64 ts, gint64 dur)
+        {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"" << name
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << ts << ",\"dur\":" << std::max<gint64>(dur, 0) << "}";
+            first = false;
+        }
+
+        gint64 to_us(double seconds)
+        {
+            return static_cast<gint64>(seconds * G_USEC_PER_SEC);
+        }
+    }
+
+    RequestTrace::RequestTrace(std::size_t capacity) :
+        m_next     (0),
+        m_capacity (std::max<std::size_t>(capacity, 1)),
+        m_epoch    (g_get_monotonic_time())
+    {
+        m_entries.reserve(m_capacity);
+    }
+
+    void RequestTrace::record(CURL *curl, const char *kind, gint64 start, CURLcode result)
+    {
+        RequestTiming timing {};
+        timing.kind   = kind;
+        timing.start  = start;
+        timing.thread = thread_number();
+        timing.result = result;
+
+        char *url = nullptr;
+        long connects = 0;
+        curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &timing.response_code);
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME, &timing.namelookup);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &timing.connect);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &timing.appconnect);
+        curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &timing.starttransfer);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &timing.total);
+#if LIBCURL_VERSION_NUM >= 0x073700
+        curl_off_t down = 0, up = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &down);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &up);
+#else
+        double down = 0, up = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD, &down);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD, &up);
+#endif
+        timing.bytes_down = static_cast<std::int64_t>(down);
+        timing.bytes_up   = static_cast<std::int64_t>(up);
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+        if (url)
+            timing.url = url;
+        timing.reused = result == CURLE_OK && connects == 0;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.size() < m_capacity)
+            m_entries.push_back(std::move(timing));
+        else
+            m_entries[m_next] = std::move(timing);
+        m_next = (m_next + 1) % m_capacity;
+    }
+
+    std::vector<RequestTiming> RequestTrace::snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.size() < m_capacity)
+            return m_entries;
+
+        std::vector<RequestTiming> ordered;
+        ordered.reserve(m_entries.size());
+        ordered.insert(ordered.end(), m_entries.cbegin() + m_next, m_entries.cend());
+        ordered.insert(ordered.end(), m_entries.cbegin(), m_entries.cbegin() + m_next);
+        return ordered;
+    }
+
+    std::string RequestTrace::to_chrome_trace() const
+    {
+        std::ostringstream out;
+        bool first = true;
+
+        out << "{\"traceEvents\":[";
+        for (const auto& timing : snapshot()) {
+            const auto ts = timing.start - m_epoch;
+            const auto tid = timing.thread;
+
+            out << (first ? "\n" : ",\n") << "{\"name\":\"" << timing.kind
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << ts << ",\"dur\":" << to_us(timing.total)
+                << ",\"args\":{\"url\":";
+            append_json_string(out, timing.url);
+            out << ",\"result\":";
+            append_json_string(out, curl_easy_strerror(timing.result));
+            out << ",\"response_code\":" << timing.response_code
+                << ",\"bytes_down\":" << timing.bytes_down
+                << ",\"bytes_up\":" << timing.bytes_up
+                << ",\"reused\":" << (timing.reused ? "true" : "false") << "}}";
+            first = false;
+
+            /* Phases as libcurl defines them; each starts where the
+             * previous ended */
+            const auto tls_end = std::max(timing.appconnect, timing.connect);
+            append_slice(out, first, "dns", tid, ts, to_us(timing.namelookup));
+            append_slice(out, first, "connect", tid, ts + to_us(timing.namelookup),
+                         to_us(timing.connect - timing.namelookup));
+            if (timing.appconnect > 0)
+                append_slice(out, first, "tls", tid, ts + to_us(timing.connect),
+                             to_us(timing.appconnect - timing.connect));
+            if (timing.starttransfer > 0) {
+                append_slice(out, first, "wait", tid, ts + to_us(tls_end),
+                             to_us(timing.starttransfer - tls_end));
+                append_slice(out, first, "transfer", tid, ts + to_us(timing.starttransfer),
+                             to_us(timing.total - timing.starttransfer));
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        return out.str();
+    }
+
+    bool RequestTrace::write_chrome_trace(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "Error: Unable to write request trace to " << path << std::endl;
+            return false;
+        }
+
+        out << to_chrome_trace();
+        return static_cast<bool>(out);
+    }
+}
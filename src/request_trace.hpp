@@ -0,0 +1,83 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include <glib.h>
+
+namespace MAL {
+
+    /** Where the time went in one curl transfer.
+     *
+     * The phase times are libcurl's, in seconds from the start of
+     * the transfer: name lookup, TCP connect, TLS handshake, first
+     * response byte and completion.
+     */
+    struct RequestTiming {
+        const char  *kind;          /* "list", "image", ... a string literal */
+        std::string  url;
+        gint64       start;         /* g_get_monotonic_time() */
+        unsigned     thread;        /* Small per-thread number, for the trace */
+        CURLcode     result;
+        long         response_code;
+        double       namelookup;
+        double       connect;
+        double       appconnect;    /* 0 without TLS */
+        double       starttransfer;
+        double       total;
+        std::int64_t bytes_down;
+        std::int64_t bytes_up;
+        bool         reused;        /* No new connection was made */
+    };
+
+    /** The most recent requests, kept in a ring buffer.
+     *
+     * Safe to use from multiple threads.
+     */
+    class RequestTrace {
+    public:
+        explicit RequestTrace(std::size_t capacity = 512);
+
+        /** Records the transfer curl just finished with result. start
+         * is g_get_monotonic_time() from before curl_easy_perform().
+         */
+        void record(CURL *curl, const char *kind, gint64 start, CURLcode result);
+
+        /** The recorded requests, oldest first.
+         */
+        std::vector<RequestTiming> snapshot() const;
+
+        /** The recorded requests as Chrome trace JSON, one slice per
+         * request with its phases nested inside, for chrome://tracing
+         * or Perfetto.
+         */
+        std::string to_chrome_trace() const;
+
+        bool write_chrome_trace(const std::string& path) const;
+
+    private:
+        mutable std::mutex         m_mutex;
+        std::vector<RequestTiming> m_entries;
+        std::size_t                m_next;    /* Slot for the next record */
+        std::size_t                m_capacity;
+        gint64                     m_epoch;
+    };
+}
@@ -0,0 +1,116 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace MAL {
+
+    /** A set of items published as immutable, versioned snapshots.
+     *
+     * Readers call snapshot() and iterate the returned set without
+     * holding any lock; the snapshot stays valid for as long as the
+     * reader keeps the shared_ptr alive, no matter what writers do in
+     * the meantime.
+     *
+     * Writers are serialized on a private mutex. update() copies the
+     * current set, hands the copy to the writer and atomically
+     * publishes the result. Items that are already published must be
+     * treated as immutable: to change one, clone it, modify the clone
+     * and replace() it in the writer's copy.
+     */
+    template <typename T, typename Compare>
+    class SnapshotSet {
+    public:
+        typedef std::set<std::shared_ptr<T>, Compare> set_type;
+        typedef std::shared_ptr<const set_type>       snapshot_type;
+
+        SnapshotSet() :
+            m_current(std::make_shared<const set_type>()),
+            m_version(0)
+            {
+            }
+
+        SnapshotSet(const SnapshotSet&) = delete;
+        void operator=(const SnapshotSet&) = delete;
+
+        /** Returns the most recently published snapshot.
+         *
+         * Never blocks on writers.
+         */
+        snapshot_type snapshot() const {
+            return std::atomic_load(&m_current);
+        }
+
+        /** Number of snapshots published so far.
+         */
+        uint_fast64_t version() const {
+            return m_version.load(std::memory_order_acquire);
+        }
+
+        /** Copies the current set, applies writer to the copy and
+         * publishes it.
+         *
+         * writer is called with the writer lock held, so keep it
+         * short and never call back into the GUI from it.
+         */
+        template <typename F>
+        snapshot_type update(F&& writer) {
+            std::lock_guard<std::mutex> lock(m_writer_mutex);
+            auto next = std::make_shared<set_type>(*std::atomic_load(&m_current));
+            writer(*next);
+            return publish(std::move(next));
+        }
+
+        /** Publishes set wholesale, discarding the current contents.
+         */
+        snapshot_type reset(set_type&& set) {
+            std::lock_guard<std::mutex> lock(m_writer_mutex);
+            return publish(std::make_shared<set_type>(std::move(set)));
+        }
+
+        /** Swaps item in for the element with an equivalent key in
+         * set, or inserts it if there is none.
+         *
+         * Used by writers so that published items are never mutated
+         * in place.
+         */
+        static void replace(set_type& set, const std::shared_ptr<T>& item) {
+            auto iter = set.find(item);
+            if (iter != set.end())
+                iter = set.erase(iter);
+            set.insert(iter, item);
+        }
+
+    private:
+        snapshot_type publish(std::shared_ptr<set_type>&& next) {
+            snapshot_type published = std::move(next);
+            std::atomic_store(&m_current, published);
+            m_version.fetch_add(1, std::memory_order_release);
+            return published;
+        }
+
+        /* Only ever accessed through std::atomic_load/atomic_store */
+        snapshot_type              m_current;
+        std::mutex                 m_writer_mutex;
+        std::atomic<uint_fast64_t> m_version;
+    };
+}
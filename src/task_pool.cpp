@@ -0,0 +1,274 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "task_pool.hpp"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace MAL {
+
+    namespace {
+        /* The pool and deque of the calling thread, if it is a
+         * WorkStealingPool thread */
+        thread_local const WorkStealingPool *current_pool  = nullptr;
+        thread_local unsigned                current_index = 0;
+
+        static void run_task(const Executor::Task& task)
+        {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Uncaught exception in task: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Error: Uncaught exception in task" << std::endl;
+            }
+        }
+    }
+
+    WorkStealingPool::WorkStealingPool(unsigned threads) :
+        m_queued   (0),
+        m_next     (0),
+        m_joined   (false),
+        m_stopping (false)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        m_workers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+            m_workers.emplace_back(new Worker());
+
+        m_threads.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+            m_threads.emplace_back([this, i] { run(i); });
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        shutdown();
+    }
+
+    void WorkStealingPool::post(Task task)
+    {
+        const auto n = static_cast<unsigned>(m_workers.size());
+        const auto index = current_pool == this ? current_index : m_next++ % n;
+        auto& worker = *m_workers[index];
+
+        {
+            /* shutdown() sets m_joined before it empties any deque,
+             * so under this lock either it has not reached this
+             * deque yet and will run the task, or the check sees it */
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!m_joined) {
+                worker.tasks.push_back(std::move(task));
+                ++m_queued;
+                task = nullptr;
+            }
+        }
+
+        if (task) {
+            run_task(task);
+            return;
+        }
+
+        /* Taking the lock orders this after a sleeper's check of
+         * m_queued, so the wakeup can not be lost */
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_cond.notify_one();
+    }
+
+    bool WorkStealingPool::try_pop(unsigned index, Task& task)
+    {
+        {
+            auto& own = *m_workers[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        const auto n = static_cast<unsigned>(m_workers.size());
+        for (unsigned i = 1; i < n; ++i) {
+            auto& victim = *m_workers[(index + i) % n];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void WorkStealingPool::run(unsigned index)
+    {
+        current_pool  = this;
+        current_index = index;
+
+        for (;;) {
+            Task task;
+            if (try_pop(index, task)) {
+                --m_queued;
+                run_task(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] { return m_queued > 0 || m_stopping; });
+            if (m_stopping && m_queued == 0)
+                break;
+        }
+
+        current_pool = nullptr;
+    }
+
+    void WorkStealingPool::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping)
+                return;
+            m_stopping = true;
+        }
+        m_cond.notify_all();
+
+        for (auto& thread : m_threads)
+            thread.join();
+        m_joined = true;
+
+        /* Anything posted between the last thread leaving and
+         * m_joined being set. Tasks run here that post more run
+         * them inline */
+        for (auto& worker : m_workers) {
+            std::deque<Task> late;
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                late.swap(worker->tasks);
+            }
+            for (auto& task : late)
+                run_task(task);
+        }
+    }
+
+    IOExecutor::IOExecutor(unsigned threads) :
+        m_stopping (false),
+        m_joined   (false)
+    {
+        threads = std::max(1u, threads);
+        m_threads.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+            m_threads.emplace_back([this] { run(); });
+    }
+
+    IOExecutor::~IOExecutor()
+    {
+        shutdown();
+    }
+
+    void IOExecutor::post(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_joined) {
+                m_tasks.push_back(std::move(task));
+                m_cond.notify_one();
+                return;
+            }
+        }
+
+        run_task(task);
+    }
+
+    void IOExecutor::run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cond.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+            if (m_tasks.empty())
+                break;
+
+            auto task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            lock.unlock();
+            run_task(task);
+            lock.lock();
+        }
+    }
+
+    void IOExecutor::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping)
+                return;
+            m_stopping = true;
+        }
+        m_cond.notify_all();
+
+        for (auto& thread : m_threads)
+            thread.join();
+
+        std::deque<Task> late;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_joined = true;
+            late.swap(m_tasks);
+        }
+        for (auto& task : late)
+            run_task(task);
+    }
+
+    Strand::Strand(Executor& executor) :
+        m_executor (executor),
+        m_running  (false)
+    {
+    }
+
+    void Strand::post(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+            if (m_running)
+                return;
+            m_running = true;
+        }
+
+        m_executor.post([this] { drain(); });
+    }
+
+    void Strand::drain()
+    {
+        for (;;) {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_tasks.empty()) {
+                    m_running = false;
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            run_task(task);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+/* -*- mode: c++; c-file-style: "linux"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MAL {
+
+    /** Something that runs tasks, usually on another thread.
+     *
+     * Every executor here drains its queue when shut down, then runs
+     * any task posted after that on the posting thread, so a task
+     * is never dropped.
+     */
+    class Executor {
+    public:
+        typedef std::function<void ()> Task;
+
+        virtual ~Executor() = default;
+        virtual void post(Task task) = 0;
+    };
+
+    /** Thread pool for CPU-bound work such as parsing and
+     * serializing.
+     *
+     * Each thread has its own deque. Tasks posted from a pool thread
+     * go on that thread's deque and are taken newest first; idle
+     * threads steal the oldest task from the others. Tasks posted
+     * from outside are spread over the deques in turn.
+     */
+    class WorkStealingPool final : public Executor {
+    public:
+        /* threads == 0 means one per core */
+        explicit WorkStealingPool(unsigned threads = 0);
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+        virtual ~WorkStealingPool();
+
+        virtual void post(Task task) override;
+
+        /** Runs every queued task, including ones they post, then
+         * joins the threads. Safe to call more than once.
+         */
+        void shutdown();
+
+        unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+    private:
+        struct Worker {
+            std::mutex       mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker> > m_workers;
+        std::vector<std::thread>              m_threads;
+
+        std::atomic<std::size_t>              m_queued;  /* Incremented after a push, under its lock */
+        std::atomic<unsigned>                 m_next;    /* Deque for the next outside post */
+        std::atomic<bool>                     m_joined;
+
+        std::mutex                            m_mutex;   /* Guards m_stopping, for m_cond */
+        std::condition_variable               m_cond;
+        bool                                  m_stopping;
+
+        void run(unsigned index);
+        bool try_pop(unsigned index, Task& task);
+    };
+
+    /** Threads for blocking I/O, such as curl transfers.
+     *
+     * Tasks are started in the order they were posted, on as many
+     * threads as were asked for. Use a Strand where the order they
+     * finish in matters too.
+     */
+    class IOExecutor final : public Executor {
+    public:
+        explicit IOExecutor(unsigned threads);
+        IOExecutor(const IOExecutor&) = delete;
+        IOExecutor& operator=(const IOExecutor&) = delete;
+        virtual ~IOExecutor();
+
+        virtual void post(Task task) override;
+
+        /** Runs every queued task, then joins the threads. Safe to
+         * call more than once.
+         */
+        void shutdown();
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<Task>         m_tasks;
+        std::mutex               m_mutex;
+        std::condition_variable  m_cond;
+        bool                     m_stopping;
+        std::atomic<bool>        m_joined;
+
+        void run();
+    };
+
+    /** Runs tasks one at a time, in the order they were posted, on
+     * another executor.
+     *
+     * The strand must outlive the executor's queue: destroy it only
+     * after the executor has been shut down.
+     */
+    class Strand final : public Executor {
+    public:
+        explicit Strand(Executor& executor);
+        Strand(const Strand&) = delete;
+        Strand& operator=(const Strand&) = delete;
+
+        virtual void post(Task task) override;
+
+    private:
+        Executor&        m_executor;
+        std::mutex       m_mutex;
+        std::deque<Task> m_tasks;
+        bool             m_running; /* A drain() is queued or running */
+
+        void drain();
+    };
+}
@@ -0,0 +1,283 @@
+/*
+ *  This file is part of mal-gtk.
+ *
+ *  mal-gtk is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  mal-gtk is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with mal-gtk.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <locale.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libxml/HTMLparser.h>
+#include <libxml/xmlreader.h>
+#include "html_form_scanner.hpp"
+#include "anime_serializer.hpp"
+#include "manga_serializer.hpp"
+#include "text_util.hpp"
+
+namespace {
+
+    /* Each field found, keyed on "input:name", "select:name" or
+     * "textarea:name" */
+    typedef std::map<std::string, std::string> Fields;
+
+    struct FieldNames {
+        std::vector<const char*> inputs;
+        std::vector<const char*> selects;
+        std::vector<const char*> textareas;
+    };
+
+    /* What the serializers ask for */
+    const FieldNames anime_fields = {
+        { "fansub_group", "list_downloaded_eps", "list_times_watched", "storageVal" },
+        { "priority", "storage", "list_rewatch_value", "discuss" },
+        { "list_comments" },
+    };
+
+    const FieldNames manga_fields = {
+        { "downloaded_chapters", "times_read", "retail_volumes" },
+        { "priority", "storage_num", "reread_value", "discuss" },
+        { "comments" },
+    };
+
+    const FieldNames quirks_fields = {
+        { "upper", "no_value", "hidden", "empty", "missing" },
+        { "none_selected", "bare" },
+        { "entities" },
+    };
+
+    std::string
+    read_fixture(const char *name)
+    {
+        gchar *path = g_test_build_filename(G_TEST_DIST, "fixtures", name, NULL);
+        gchar *contents = nullptr;
+        gsize length = 0;
+        GError *error = nullptr;
+        g_file_get_contents(path, &contents, &length, &error);
+        g_assert_no_error(error);
+        std::string html(contents, length);
+        g_free(contents);
+        g_free(path);
+        return html;
+    }
+
+    bool
+    wanted(const std::vector<const char*>& names, const xmlChar *name)
+    {
+        for (auto wanted_name : names) {
+            if (xmlStrEqual(name, reinterpret_cast<const xmlChar*>(wanted_name)))
+                return true;
+        }
+        return false;
+    }
+
+    std::string
+    to_str(const xmlChar *str)
+    {
+        return str ? std::string(reinterpret_cast<const char*>(str)) : std::string();
+    }
+
+    /* The tree walk deserialize_details did before HtmlFormScanner,
+     * with the field names passed in rather than written out per
+     * serializer */
+    bool
+    old_extract(const std::string& html, const FieldNames& names, Fields& fields)
+    {
+        struct Free {
+            void operator()(xmlDocPtr doc) const { xmlFreeDoc(doc); }
+            void operator()(xmlTextReaderPtr reader) const { xmlFreeTextReader(reader); }
+            void operator()(xmlChar *str) const { xmlFree(str); }
+        };
+        typedef std::unique_ptr<xmlChar, Free> xmlStringUPtr;
+        const xmlChar *type_attr     = reinterpret_cast<const xmlChar*>("type");
+        const xmlChar *name_attr     = reinterpret_cast<const xmlChar*>("name");
+        const xmlChar *value_attr    = reinterpret_cast<const xmlChar*>("value");
+        const xmlChar *selected_attr = reinterpret_cast<const xmlChar*>("selected");
+
+        std::unique_ptr<xmlDoc, Free> doc(htmlReadMemory(html.data(), static_cast<int>(html.size()),
+                                                         "http://myanimelist.net/", nullptr,
+                                                         HTML_PARSE_RECOVER | HTML_PARSE_NOERROR |
+                                                         HTML_PARSE_NOWARNING | HTML_PARSE_NONET));
+        std::unique_ptr<xmlTextReader, Free> reader(xmlReaderWalker(doc.get()));
+        if (!reader)
+            return false;
+
+        std::string select, textarea, textbuf;
+        int ret;
+        for (ret = xmlTextReaderRead(reader.get()); ret == 1; ret = xmlTextReaderRead(reader.get())) {
+            const std::string name = to_str(xmlTextReaderConstName(reader.get()));
+            const int type = xmlTextReaderNodeType(reader.get());
+
+            if (name == "input") {
+                xmlStringUPtr input_type(xmlTextReaderGetAttribute(reader.get(), type_attr));
+                xmlStringUPtr attr_name(xmlTextReaderGetAttribute(reader.get(), name_attr));
+                xmlStringUPtr attr_value(xmlTextReaderGetAttribute(reader.get(), value_attr));
+                if (input_type && (xmlStrEqual(input_type.get(), reinterpret_cast<const xmlChar*>("text")) ||
+                                   xmlStrEqual(input_type.get(), reinterpret_cast<const xmlChar*>("checkbox"))) &&
+                    wanted(names.inputs, attr_name.get()))
+                    fields["input:" + to_str(attr_name.get())] = to_str(attr_value.get());
+            } else if (name == "textarea" && type == XML_READER_TYPE_ELEMENT) {
+                xmlStringUPtr attr_name(xmlTextReaderGetAttribute(reader.get(), name_attr));
+                textarea = wanted(names.textareas, attr_name.get()) ? to_str(attr_name.get()) : "";
+                textbuf.clear();
+            } else if (name == "textarea" && type == XML_READER_TYPE_END_ELEMENT) {
+                if (!textarea.empty())
+                    fields["textarea:" + textarea] = textbuf;
+                textarea.clear();
+            } else if (name == "#text" && !textarea.empty()) {
+                textbuf.append(to_str(xmlTextReaderConstValue(reader.get())));
+            } else if (name == "select" && type == XML_READER_TYPE_ELEMENT) {
+                xmlStringUPtr attr_name(xmlTextReaderGetAttribute(reader.get(), name_attr));
+                select = wanted(names.selects, attr_name.get()) ? to_str(attr_name.get()) : "";
+            } else if (name == "select" && type == XML_READER_TYPE_END_ELEMENT) {
+                select.clear();
+            } else if (name == "option" && type == XML_READER_TYPE_ELEMENT && !select.empty()) {
+                xmlStringUPtr value(xmlTextReaderGetAttribute(reader.get(), value_attr));
+                if (xmlTextReaderMoveToAttribute(reader.get(), selected_attr) == 1)
+                    fields["select:" + select] = to_str(value.get());
+            }
+        }
+
+        return ret == 0;
+    }
+
+    bool
+    scan(const std::string& html, const FieldNames& names, Fields& fields)
+    {
+        MAL::HtmlFormScanner scanner;
+        for (auto name : names.inputs) {
+            scanner.input(name, [&fields, name](std::string&& v) {
+                    fields[std::string("input:") + name] = std::move(v);
+                });
+        }
+        for (auto name : names.selects) {
+            scanner.select(name, [&fields, name](std::string&& v) {
+                    fields[std::string("select:") + name] = std::move(v);
+                });
+        }
+        for (auto name : names.textareas) {
+            scanner.textarea(name, [&fields, name](std::string&& v) {
+                    fields[std::string("textarea:") + name] = std::move(v);
+                });
+        }
+        return scanner.scan(html);
+    }
+
+    /* Returns the number of fields found */
+    std::size_t
+    assert_same_fields(const char *fixture, const FieldNames& names)
+    {
+        const std::string html = read_fixture(fixture);
+        Fields expected, fields;
+
+        g_assert_true(old_extract(html, names, expected));
+        g_assert_true(scan(html, names, fields));
+        g_assert_cmpuint(fields.size(), ==, expected.size());
+        for (const auto& field : expected) {
+            auto found = fields.find(field.first);
+            if (found == fields.end())
+                g_error("%s: %s was not found", fixture, field.first.c_str());
+            g_assert_cmpstr(found->second.c_str(), ==, field.second.c_str());
+        }
+        return fields.size();
+    }
+}
+
+static void
+test_html_form_scanner_anime(void)
+{
+    g_assert_cmpuint(assert_same_fields("anime_edit.html", anime_fields), ==, 9);
+}
+
+static void
+test_html_form_scanner_manga(void)
+{
+    g_assert_cmpuint(assert_same_fields("manga_edit.html", manga_fields), ==, 8);
+}
+
+static void
+test_html_form_scanner_quirks(void)
+{
+    Fields fields;
+
+    g_assert_cmpuint(assert_same_fields("quirks.html", quirks_fields), ==, 5);
+
+    g_assert_true(scan(read_fixture("quirks.html"), quirks_fields, fields));
+    g_assert_cmpstr(fields["input:upper"].c_str(), ==, "shouted");
+    g_assert_cmpstr(fields["input:no_value"].c_str(), ==, "");
+    g_assert_true(fields.find("input:hidden") == fields.end());
+    g_assert_true(fields.find("input:missing") == fields.end());
+    g_assert_true(fields.find("select:none_selected") == fields.end());
+    g_assert_cmpstr(fields["select:bare"].c_str(), ==, "7");
+    g_assert_cmpstr(fields["textarea:entities"].c_str(), ==, "\"quoted\" \xc3\xa9t\xc3\xa9 \xc2\xa0x");
+
+    /* The old extractor never finished an empty textarea, as the
+     * tree has no end element for it */
+    fields.clear();
+    g_assert_true(scan("<textarea name=\"entities\"></textarea>", quirks_fields, fields));
+    g_assert_cmpstr(fields["textarea:entities"].c_str(), ==, "");
+}
+
+/* The old extractor wrote the anime storage select to storage_value;
+ * it sets the storage type now */
+static void
+test_html_form_scanner_anime_storage(void)
+{
+    auto text_util = std::make_shared<MAL::TextUtility>();
+    MAL::AnimeSerializer serializer(text_util);
+    auto anime = serializer.deserialize_details(read_fixture("anime_edit.html"));
+
+    g_assert_nonnull(anime.get());
+    g_assert_true(anime->storage_type == MAL::AnimeStorageType::RETAILDVD);
+    g_assert_cmpfloat(anime->storage_value, ==, 2.5f);
+    g_assert_cmpint(anime->downloaded_items, ==, 12);
+    g_assert_cmpint(anime->times_consumed, ==, 2);
+    g_assert_cmpstr(anime->fansub_group.str().c_str(), ==, "Commie & Friends");
+}
+
+static void
+test_html_form_scanner_failure(void)
+{
+    auto text_util = std::make_shared<MAL::TextUtility>();
+    MAL::AnimeSerializer anime_serializer(text_util);
+    MAL::MangaSerializer manga_serializer(text_util);
+    Fields fields;
+
+    g_assert_false(scan("", anime_fields, fields));
+    g_assert_false(scan(" \n\t", anime_fields, fields));
+    g_assert_false(scan("<!DOCTYPE html>", anime_fields, fields));
+    g_assert_true(fields.empty());
+
+    g_assert_null(anime_serializer.deserialize_details("").get());
+    g_assert_null(manga_serializer.deserialize_details("").get());
+
+    /* A page without the form is parsed; there is just nothing in it */
+    g_assert_true(scan("<html><body><p>Please log in</p></body></html>", anime_fields, fields));
+    g_assert_true(fields.empty());
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/malgtk/html_form_scanner/anime", test_html_form_scanner_anime);
+    g_test_add_func("/malgtk/html_form_scanner/manga", test_html_form_scanner_manga);
+    g_test_add_func("/malgtk/html_form_scanner/quirks", test_html_form_scanner_quirks);
+    g_test_add_func("/malgtk/html_form_scanner/anime-storage", test_html_form_scanner_anime_storage);
+    g_test_add_func("/malgtk/html_form_scanner/failure", test_html_form_scanner_failure);
+    return g_test_run();
+}
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 #include <glib.h>
 
 namespace {
@@ -128,7 +129,7 @@ namespace MAL {
         }
     }
 
-    void TextUtility::parse_html_entities(std::string& str)
+    void TextUtility::parse_html_entities(std::string& str) const
     {
         auto pos = str.find("&");
         for (; pos != std::string::npos; pos = str.find("&", pos + 1)) {
@@ -161,8 +162,12 @@ namespace MAL {
                 /* Convert unicode point to UTF-8 */
                 try {
                     char32_t val { entity_to_char32(entity, 1) };
-                    utf8 = ucs4conv.to_bytes(val);
-                    html_entities.emplace(entity, utf8);
+                    if (G_UNLIKELY(!g_unichar_validate(val))) {
+                        throw std::range_error("Not a unicode code point");
+                    }
+
+                    gchar buf[6];
+                    utf8.assign(buf, g_unichar_to_utf8(val, buf));
                     g_debug("Converted %s to %s", entity.c_str(), utf8.c_str());
                 } catch (std::exception& e) {
                     g_message("Error converting html integer entity '%s' to UTF-8: %s",
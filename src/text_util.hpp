@@ -18,20 +18,20 @@
 #pragma once
 #include <unordered_map>
 #include <array>
-#include <codecvt>
-#include <locale>
+#include <string>
 
 namespace MAL {
 
     class TextUtility {
     public:
         TextUtility();
-        void parse_html_entities(std::string&);
+
+        /* Safe to call from multiple threads at once */
+        void parse_html_entities(std::string&) const;
 
     private:
-        std::unordered_map<std::string, const std::string> html_entities;
-        std::array<std::string, 3> ignored_entities;
-        std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> ucs4conv;
+        const std::unordered_map<std::string, const std::string> html_entities;
+        const std::array<std::string, 3> ignored_entities;
     };
 
 }
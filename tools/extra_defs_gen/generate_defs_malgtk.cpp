@@ -21,6 +21,7 @@
 #include "malgtk_malitem.h"
 #include "malgtk_anime.h"
 #include "malgtk_manga.h"
+#include "malgtk_item_list.h"
 
 
 int
@@ -29,6 +30,7 @@ main(int, char**)
   std::cout << get_defs(MALGTK_TYPE_MALITEM)
             << get_defs(MALGTK_TYPE_ANIME)
             << get_defs(MALGTK_TYPE_MANGA)
+            << get_defs(MALGTK_TYPE_ITEM_LIST)
             << std::endl;
   
   return 0;